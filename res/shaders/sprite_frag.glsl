@@ -1,6 +1,12 @@
 #version 330 core
 
+// Variants (defined at build time, see the Makefile):
+//  SPRITE_OPAQUE  ignore texture alpha (drawn with blending off)
+//  SPRITE_CUTOUT  alpha tested hard edges (drawn with blending off)
+//  default        alpha blended, faded by the per-instance alpha
+
 in vec2 v_texcoord;
+in float v_alpha;
 
 out vec4 FragColor;
 
@@ -8,4 +14,12 @@ uniform sampler2D u_texture;
 
 void main() {
     FragColor = texture(u_texture, v_texcoord);
+#if defined(SPRITE_OPAQUE)
+    FragColor.a = 1.0f;
+#elif defined(SPRITE_CUTOUT)
+    if (FragColor.a < 0.5f) discard;
+    FragColor.a = 1.0f;
+#else
+    FragColor.a *= v_alpha;
+#endif
 }
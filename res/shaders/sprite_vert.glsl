@@ -1,14 +1,32 @@
 #version 330 core
 
+// Variants (defined at build time, see the Makefile):
+//  SPRITE_SCROLL  scale (xy) and offset (zw) the texcoords by u_uv_transform
+//                 to scroll a repeating texture across a single quad
+
 layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec2 a_texcoord;
 
+// per-instance offset (xy), scale (z), and alpha (w)
+//  left as the constant (0, 0, 1, 1) when drawing a single sprite
+layout(location = 2) in vec4 a_instance;
+
 out vec2 v_texcoord;
+out float v_alpha;
 
 uniform mat4 u_model;
 uniform mat4 u_projection;
+#ifdef SPRITE_SCROLL
+uniform vec4 u_uv_transform;
+#endif
 
 void main() {
+#ifdef SPRITE_SCROLL
+    v_texcoord = a_texcoord * u_uv_transform.xy + u_uv_transform.zw;
+#else
     v_texcoord = a_texcoord;
-    gl_Position = u_projection * u_model * vec4(a_position, 1.0f);
+#endif
+    v_alpha = a_instance.w;
+    vec3 position = vec3(a_position.xy * a_instance.z + a_instance.xy, a_position.z);
+    gl_Position = u_projection * u_model * vec4(position, 1.0f);
 }
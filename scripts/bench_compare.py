@@ -0,0 +1,62 @@
+import argparse
+import json
+import sys
+
+# Compare two flappy-bench JSON result files (see src/bench.c).
+#
+# A benchmark counts as changed when its median moved by more than both
+# --threshold (relative) and --mads times the larger of the two MADs, so
+# noisy benchmarks need a bigger move to be flagged.
+#
+# Example:
+#   make bench && cp bench.json baseline.json
+#   ... change something ...
+#   make bench && python3 scripts/bench_compare.py baseline.json bench.json
+
+DEFAULT_THRESHOLD = 0.05
+DEFAULT_MADS = 3.0
+
+
+def load(path):
+    with open(path) as f:
+        results = json.load(f)
+    return {b['name']: b for b in results['benchmarks']}
+
+
+def compare(baseline, current, threshold, mads):
+    regressions = 0
+    print('{:<32} {:>12} {:>12} {:>8}'.format('benchmark', 'baseline', 'current', 'change'))
+    for name, cur in current.items():
+        base = baseline.get(name)
+        if base is None:
+            print('{:<32} {:>12} {:>12.2f} {:>8}'.format(name, '-', cur['median'], 'new'))
+            continue
+
+        delta = cur['median'] - base['median']
+        ratio = delta / base['median'] if base['median'] > 0 else 0.0
+        noise = mads * max(base['mad'], cur['mad'])
+        verdict = ''
+        if abs(ratio) > threshold and abs(delta) > noise:
+            verdict = 'slower' if delta > 0 else 'faster'
+            regressions += delta > 0
+
+        print('{:<32} {:>12.2f} {:>12.2f} {:>+7.1f}% {}'.format(
+            name, base['median'], cur['median'], ratio * 100.0, verdict))
+
+    for name in baseline:
+        if name not in current:
+            print('{:<32} {:>12.2f} {:>12} {:>8}'.format(name, baseline[name]['median'], '-', 'gone'))
+
+    return regressions
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Compare flappy-bench results (ns/op)')
+    parser.add_argument('baseline', help='stored results')
+    parser.add_argument('current', help='new results')
+    parser.add_argument('--threshold', type=float, default=DEFAULT_THRESHOLD, help='relative change to flag')
+    parser.add_argument('--mads', type=float, default=DEFAULT_MADS, help='MADs of noise to ignore')
+
+    args = parser.parse_args()
+    regressions = compare(load(args.baseline), load(args.current), args.threshold, args.mads)
+    sys.exit(1 if regressions > 0 else 0)
@@ -0,0 +1,99 @@
+import argparse
+import random
+import struct
+
+# Build binary course files for flappy (see src/course.h for the layout).
+#
+# Hand-authored courses are plain text, one obstacle per line:
+#   x gap [gap_size [amplitude frequency]]
+# Blank lines and lines starting with '#' are ignored.
+#
+# Examples:
+#   python3 scripts/course.py compile level1.txt level1.course
+#   python3 scripts/course.py generate --count 5000000 --seed 42 huge.course
+
+MAGIC = b'FLPC'
+VERSION = 1
+
+HEADER = struct.Struct('<4sIQQQII')
+RECORD = struct.Struct('<fffffI')
+INDEX = struct.Struct('<fIQ')
+
+# defaults match the built-in generated course
+DEFAULT_SPACING = 4.0
+DEFAULT_GAP_SIZE = 4.0
+DEFAULT_INDEX_STRIDE = 1024
+
+
+def write_course(path, records, index_stride=DEFAULT_INDEX_STRIDE):
+    # records must already be sorted by x, they are streamed straight to disk
+    index = []
+    count = 0
+    with open(path, 'wb') as f:
+        f.write(bytes(HEADER.size))
+        for x, gap, gap_size, amplitude, frequency in records:
+            if count % index_stride == 0:
+                index.append(INDEX.pack(x, 0, count))
+            f.write(RECORD.pack(x, gap, gap_size, amplitude, frequency, 0))
+            count += 1
+
+        index_offset = f.tell()
+        f.write(b''.join(index))
+
+        f.seek(0)
+        f.write(HEADER.pack(MAGIC, VERSION, count, HEADER.size,
+                            index_offset, len(index), index_stride))
+
+
+def compile_course(source):
+    records = []
+    with open(source) as f:
+        for number, line in enumerate(f, start=1):
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+
+            fields = [float(v) for v in line.split()]
+            if len(fields) not in (2, 3, 5):
+                raise SystemExit('{}:{}: expected "x gap [gap_size [amplitude frequency]]"'.format(source, number))
+
+            x, gap = fields[0], fields[1]
+            gap_size = fields[2] if len(fields) > 2 else DEFAULT_GAP_SIZE
+            amplitude, frequency = (fields[3], fields[4]) if len(fields) > 3 else (0.0, 0.0)
+            records.append((x, gap, gap_size, amplitude, frequency))
+    return sorted(records, key=lambda r: r[0])
+
+
+def generate_course(count, seed, spacing, moving):
+    rng = random.Random(seed)
+    for i in range(count):
+        gap = (rng.random() - 0.5) * 4.0
+        amplitude, frequency = 0.0, 0.0
+        if rng.random() < moving:
+            amplitude = rng.uniform(0.25, 1.0)
+            frequency = rng.uniform(0.2, 0.6)
+        yield (i * spacing, gap, DEFAULT_GAP_SIZE, amplitude, frequency)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Build binary course files')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    compile_parser = sub.add_parser('compile', help='compile a hand-authored text course')
+    compile_parser.add_argument('source', help='input text file')
+    compile_parser.add_argument('course_file', help='output course file')
+
+    generate_parser = sub.add_parser('generate', help='generate a random course')
+    generate_parser.add_argument('course_file', help='output course file')
+    generate_parser.add_argument('--count', type=int, default=10000, help='number of obstacles')
+    generate_parser.add_argument('--seed', type=int, default=0, help='random seed')
+    generate_parser.add_argument('--spacing', type=float, default=DEFAULT_SPACING, help='distance between obstacles')
+    generate_parser.add_argument('--moving', type=float, default=0.0, help='fraction of moving obstacles [0.0, 1.0]')
+
+    args = parser.parse_args()
+    if args.command == 'compile':
+        records = compile_course(args.source)
+    else:
+        records = generate_course(args.count, args.seed, args.spacing, args.moving)
+
+    write_course(args.course_file, records)
@@ -0,0 +1,87 @@
+import argparse
+import ctypes
+import mmap
+import platform
+import struct
+import time
+
+# Minimal client for flappy-env (see src/env.h for the shared-memory layout).
+#
+# Arrays are exposed as memoryviews straight into the shared region (wrap
+# them with numpy.frombuffer for zero-copy arrays). Steps are requested by
+# bumping `request` and waiting for the server to echo it in `response`.
+#
+# Example:
+#   ./flappy-env --envs 256 &
+#   python3 scripts/env_client.py --steps 10000
+
+MAGIC = b'FLPE'
+VERSION = 1
+
+HEADER = struct.Struct('<4sIIIQQQQQIIII')
+REQUEST_OFFSET = HEADER.size - 16
+RESPONSE_OFFSET = HEADER.size - 12
+SHUTDOWN_OFFSET = HEADER.size - 8
+
+FUTEX_WAKE = 1
+SYS_FUTEX = {'x86_64': 202, 'aarch64': 98}.get(platform.machine())
+
+
+class Env:
+    def __init__(self, name='/flappy-env'):
+        with open('/dev/shm/' + name.lstrip('/'), 'r+b') as f:
+            self.region = mmap.mmap(f.fileno(), 0)
+
+        (magic, version, count, observation_size, size,
+         actions, observations, rewards, dones, *_) = HEADER.unpack_from(self.region)
+        if magic != MAGIC or version != VERSION:
+            raise RuntimeError('not a flappy-env region (or a different version): ' + name)
+
+        view = memoryview(self.region)
+        self.count = count
+        self.observation_size = observation_size
+        self.actions = view[actions:actions + count]
+        self.observations = view[observations:observations + 4 * count * observation_size].cast('f')
+        self.rewards = view[rewards:rewards + 4 * count].cast('f')
+        self.dones = view[dones:dones + count]
+        self.words = view[REQUEST_OFFSET:SHUTDOWN_OFFSET + 4].cast('I')
+
+        self.libc = ctypes.CDLL(None, use_errno=True) if SYS_FUTEX is not None else None
+        self.request_address = ctypes.addressof(ctypes.c_char.from_buffer(self.region, REQUEST_OFFSET))
+
+    def step(self):
+        # actions must already be written to self.actions
+        request = (self.words[0] + 1) & 0xffffffff
+        self.words[0] = request
+        if self.libc is not None:
+            self.libc.syscall(SYS_FUTEX, ctypes.c_void_p(self.request_address), FUTEX_WAKE, 1, None, None, 0)
+        while self.words[1] != request:
+            if self.words[2]:
+                raise RuntimeError('flappy-env has shut down')
+
+    def observation(self, i):
+        first = i * self.observation_size
+        return self.observations[first:first + self.observation_size]
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Drive flappy-env with a simple policy')
+    parser.add_argument('--name', default='/flappy-env', help='shared memory name')
+    parser.add_argument('--steps', type=int, default=1000, help='number of vectorized steps')
+    args = parser.parse_args()
+
+    env = Env(args.name)
+    episodes = 0
+    total = 0.0
+    start = time.perf_counter()
+    for _ in range(args.steps):
+        # flap whenever the bird is below the center of the next gap
+        for i in range(env.count):
+            env.actions[i] = env.observation(i)[3] > 0.3
+        env.step()
+        episodes += sum(env.dones)
+        total += sum(env.rewards)
+    elapsed = time.perf_counter() - start
+
+    print(f'{args.steps * env.count / elapsed:.0f} environment steps/s, '
+          f'{episodes} episodes, mean reward {total / max(episodes, 1):.2f}')
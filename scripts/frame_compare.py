@@ -0,0 +1,99 @@
+import argparse
+import sys
+
+# Compare two binary PPM (P6) frames, e.g. a software frame from flappy-render
+# against a GL readback of the same scene from flappy --dump-frame.
+#
+# A pixel counts as bad when any channel differs by more than --tolerance.
+# The frames match when at most --outliers (a fraction) of pixels are bad:
+# the two rasterizers may disagree on edge pixels and sampling rounding, but
+# not on whole sprites.
+#
+# Example (frame N of flappy-render is the scene dumped by --dump-frame N):
+#   ./flappy-render --seed 7 --frames 121 --output frames
+#   ./flappy --dump-frame 120 gl.ppm --dump-seed 7
+#   python3 scripts/frame_compare.py gl.ppm frames/frame_00120.ppm
+
+DEFAULT_TOLERANCE = 8
+DEFAULT_OUTLIERS = 0.001
+
+
+def read_token(f):
+    token = b''
+    while True:
+        c = f.read(1)
+        if not c:
+            break
+        if c == b'#' and not token:
+            f.readline()
+            continue
+        if c.isspace():
+            if token:
+                break
+            continue
+        token += c
+    return token
+
+
+def load(path):
+    with open(path, 'rb') as f:
+        if read_token(f) != b'P6':
+            raise ValueError('{}: not a binary PPM (P6)'.format(path))
+        width, height, maxval = (int(read_token(f)) for _ in range(3))
+        if maxval != 255:
+            raise ValueError('{}: unsupported maxval {}'.format(path, maxval))
+        pixels = f.read(width * height * 3)
+    if len(pixels) != width * height * 3:
+        raise ValueError('{}: truncated pixel data'.format(path))
+    return width, height, pixels
+
+
+def write_diff(path, width, height, expected, actual):
+    diff = bytes(min(255, 4 * abs(a - b)) for a, b in zip(expected, actual))
+    with open(path, 'wb') as f:
+        f.write('P6\n{} {}\n255\n'.format(width, height).encode())
+        f.write(diff)
+
+
+def compare(expected, actual, tolerance):
+    max_diff = [0, 0, 0]
+    sum_diff = [0, 0, 0]
+    bad = 0
+    for i in range(0, len(expected), 3):
+        over = False
+        for c in range(3):
+            d = abs(expected[i + c] - actual[i + c])
+            max_diff[c] = max(max_diff[c], d)
+            sum_diff[c] += d
+            over = over or d > tolerance
+        bad += over
+    return max_diff, sum_diff, bad
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Compare two PPM frames per channel')
+    parser.add_argument('expected', help='reference frame (e.g. the GL readback)')
+    parser.add_argument('actual', help='frame under test (e.g. the software render)')
+    parser.add_argument('--tolerance', type=int, default=DEFAULT_TOLERANCE, help='per-channel difference to allow')
+    parser.add_argument('--outliers', type=float, default=DEFAULT_OUTLIERS, help='fraction of pixels allowed over tolerance')
+    parser.add_argument('--diff', help='write a difference image (4x amplified) to this PPM')
+
+    args = parser.parse_args()
+    ew, eh, expected = load(args.expected)
+    aw, ah, actual = load(args.actual)
+    if (ew, eh) != (aw, ah):
+        print('size mismatch: {}x{} vs {}x{}'.format(ew, eh, aw, ah))
+        sys.exit(1)
+
+    max_diff, sum_diff, bad = compare(expected, actual, args.tolerance)
+    if args.diff:
+        write_diff(args.diff, ew, eh, expected, actual)
+
+    pixels = ew * eh
+    for name, m, s in zip('RGB', max_diff, sum_diff):
+        print('{}: max {:3d} mean {:.3f}'.format(name, m, s / pixels))
+    fraction = bad / pixels
+    ok = fraction <= args.outliers
+    print('{} of {} pixels ({:.3f}%) over tolerance {}: {}'.format(
+        bad, pixels, 100.0 * fraction, args.tolerance, 'match' if ok else 'MISMATCH'))
+    sys.exit(0 if ok else 1)
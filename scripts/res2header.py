@@ -76,11 +76,19 @@ def model2header(resource_file):
     return s.getvalue()
 
 
-def shader2header(resource_file):
-    name, ext = os.path.splitext(os.path.basename(resource_file))
+def shader2header(resource_file, header_file, defines):
+    # variants are named after their header (sprite_frag_cutout.h, ...)
+    name, ext = os.path.splitext(os.path.basename(header_file))
     with open(resource_file) as f:
         source = f.read()
 
+    # defines must follow the #version line
+    if defines:
+        lines = source.splitlines()
+        first = 1 if lines and lines[0].startswith('#version') else 0
+        lines[first:first] = ['#define {}'.format(define) for define in defines]
+        source = '\n'.join(lines) + '\n'
+
     guard = 'SHADERS_{}_H_INCLUDED'.format(name.upper())
 
     s = io.StringIO()
@@ -151,12 +159,12 @@ def texture2header(resource_file):
     return s.getvalue()
 
 
-def res2header(resource_file):
+def res2header(resource_file, header_file, defines):
     _, ext = os.path.splitext(os.path.basename(resource_file))
     if ext in ['.obj']:
         return model2header(resource_file)
     elif ext in ['.glsl']:
-        return shader2header(resource_file)
+        return shader2header(resource_file, header_file, defines)
     elif ext in ['.jpg', '.png']:
         return texture2header(resource_file)
     else:
@@ -167,8 +175,9 @@ if __name__ == '__main__':
     parser = argparse.ArgumentParser(description='Convert game resources into C headers')
     parser.add_argument('resource_file', help='input resource file')
     parser.add_argument('header_file', help='output header file')
+    parser.add_argument('--define', action='append', default=[], help='preprocessor define for a shader variant')
     args = parser.parse_args()
 
-    header = res2header(args.resource_file)
+    header = res2header(args.resource_file, args.header_file, args.define)
     with open(args.header_file, 'w') as f:
         f.write(header)
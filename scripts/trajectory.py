@@ -0,0 +1,191 @@
+import argparse
+import mmap
+import struct
+import sys
+from array import array
+
+# Read trajectory files written by flappy --trajectory and flappy-env
+# --trajectory (see src/trajectory.h for the layout). Only the footer and
+# the index are parsed up front; a column is decoded chunk by chunk when it
+# is asked for, and raw chunks are used straight from the mapping.
+#
+# Examples:
+#   python3 scripts/trajectory.py info runs.traj
+#   python3 scripts/trajectory.py dump runs.traj --columns run,tick,y,flap --head 20
+
+MAGIC = b'FLPT'
+VERSION = 1
+
+HEADER = struct.Struct('<4sIIIII')
+COLUMN = struct.Struct('<16sII')
+CHUNK = struct.Struct('<QII')
+BLOB = struct.Struct('<QII')
+FOOTER = struct.Struct('<QQII4sI')
+
+CODEC_RAW = 0
+CODEC_PACKED = 1
+
+# column type -> (array typecode, width)
+TYPES = {0: ('B', 1), 1: ('I', 4), 2: ('f', 4)}
+
+
+def get_varint(data, at):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[at]
+        at += 1
+        value |= (byte & 0x7f) << shift
+        if byte & 0x80 == 0:
+            return value, at
+        shift += 7
+
+
+def unsqueeze(data, size):
+    # (zeros, literals) varint pairs followed by the literal bytes
+    out = bytearray(size)
+    at = 0
+    i = 0
+    while at < len(data):
+        zeros, at = get_varint(data, at)
+        literal, at = get_varint(data, at)
+        i += zeros
+        out[i:i + literal] = data[at:at + literal]
+        i += literal
+        at += literal
+    return out
+
+
+def unpack(data, rows, width, stride):
+    planes = unsqueeze(data, rows * width)
+
+    # byte planes back to little-endian values
+    interleaved = bytearray(rows * width)
+    for b in range(width):
+        interleaved[b::width] = planes[b * rows:(b + 1) * rows]
+    deltas = array('I' if width == 4 else 'B', bytes(interleaved))
+    if sys.byteorder != 'little':
+        deltas.byteswap()
+
+    # undo the straight line prediction (see trajectory_delta)
+    mask = (1 << (8 * width)) - 1
+    values = array(deltas.typecode, bytes(len(deltas) * deltas.itemsize))
+    for r in range(rows):
+        if r >= 2 * stride:
+            prediction = 2 * values[r - stride] - values[r - 2 * stride]
+        elif r >= stride:
+            prediction = values[r - stride]
+        else:
+            prediction = 0
+        values[r] = (deltas[r] + prediction) & mask
+    return values.tobytes()
+
+
+class Trajectory:
+    def __init__(self, path):
+        self.file = open(path, 'rb')
+        self.data = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if len(self.data) < HEADER.size + FOOTER.size:
+            raise SystemExit('{}: not a trajectory file'.format(path))
+        magic, version, _, self.chunk_rows, self.stride, _ = HEADER.unpack_from(self.data, 0)
+        index_offset, self.rows, chunk_count, column_count, footer_magic, footer_version = \
+            FOOTER.unpack_from(self.data, len(self.data) - FOOTER.size)
+        if magic != MAGIC or footer_magic != MAGIC or version != VERSION or footer_version != VERSION:
+            raise SystemExit('{}: not a trajectory file (or a different version)'.format(path))
+
+        at = index_offset
+        self.columns = []
+        for _ in range(column_count):
+            name, type, width = COLUMN.unpack_from(self.data, at)
+            self.columns.append((name.rstrip(b'\0').decode('ascii'), type, width))
+            at += COLUMN.size
+
+        self.chunks = []
+        for _ in range(chunk_count):
+            first_row, rows, _ = CHUNK.unpack_from(self.data, at)
+            at += CHUNK.size
+            blobs = []
+            for _ in range(column_count):
+                blobs.append(BLOB.unpack_from(self.data, at))
+                at += BLOB.size
+            self.chunks.append((first_row, rows, blobs))
+
+    def close(self):
+        self.data.close()
+        self.file.close()
+
+    def column_index(self, name):
+        for i, column in enumerate(self.columns):
+            if column[0] == name:
+                return i
+        raise SystemExit('unknown column: {} (columns: {})'.format(
+            name, ', '.join(c[0] for c in self.columns)))
+
+    def chunk_column(self, chunk, name):
+        i = self.column_index(name)
+        _, type, width = self.columns[i]
+        _, rows, blobs = self.chunks[chunk]
+        offset, size, codec = blobs[i]
+
+        data = memoryview(self.data)[offset:offset + size]
+        if codec == CODEC_PACKED:
+            data = unpack(data, rows, width, self.stride)
+        elif codec != CODEC_RAW:
+            raise SystemExit('unknown codec {} in chunk {}'.format(codec, chunk))
+
+        values = array(TYPES[type][0])
+        values.frombytes(data)
+        if sys.byteorder != 'little':
+            values.byteswap()
+        return values
+
+    def column(self, name):
+        values = array(TYPES[self.columns[self.column_index(name)][1]][0])
+        for chunk in range(len(self.chunks)):
+            values.extend(self.chunk_column(chunk, name))
+        return values
+
+
+def info(trajectory):
+    print('{} rows in {} chunks (stride {})'.format(trajectory.rows, len(trajectory.chunks), trajectory.stride))
+    for i, (name, _, width) in enumerate(trajectory.columns):
+        size = sum(blobs[i][1] for _, _, blobs in trajectory.chunks)
+        packed = sum(blobs[i][2] == CODEC_PACKED for _, _, blobs in trajectory.chunks)
+        rows = max(trajectory.rows, 1)
+        print('  {:8} {:6.2f} B/row ({} raw), {} of {} chunks packed'.format(
+            name, size / rows, width, packed, len(trajectory.chunks)))
+
+
+def dump(trajectory, names, head):
+    print(' '.join(names))
+    printed = 0
+    for chunk in range(len(trajectory.chunks)):
+        columns = [trajectory.chunk_column(chunk, name) for name in names]
+        for row in zip(*columns):
+            if printed == head:
+                return
+            print(' '.join('{:g}'.format(v) if isinstance(v, float) else str(v) for v in row))
+            printed += 1
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Read trajectory files')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    info_parser = sub.add_parser('info', help='print the columns and their size')
+    info_parser.add_argument('trajectory_file', help='input trajectory file')
+
+    dump_parser = sub.add_parser('dump', help='print rows as text')
+    dump_parser.add_argument('trajectory_file', help='input trajectory file')
+    dump_parser.add_argument('--columns', default=None, help='comma separated column names (default: all)')
+    dump_parser.add_argument('--head', type=int, default=-1, help='stop after this many rows')
+
+    args = parser.parse_args()
+    trajectory = Trajectory(args.trajectory_file)
+    if args.command == 'info':
+        info(trajectory)
+    else:
+        names = args.columns.split(',') if args.columns else [c[0] for c in trajectory.columns]
+        dump(trajectory, names, args.head)
+    trajectory.close()
@@ -0,0 +1,58 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arena.h"
+
+bool
+arena_init(struct arena* arena, long size)
+{
+    assert(arena != NULL);
+    assert(size > 0);
+
+    arena->base = malloc(size);
+    if (arena->base == NULL) {
+        fprintf(stderr, "failed to allocate arena: %ld bytes\n", size);
+        return false;
+    }
+
+    arena->size = size;
+    arena->used = 0;
+    arena->peak = 0;
+    return true;
+}
+
+void
+arena_free(struct arena* arena)
+{
+    assert(arena != NULL);
+
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+// Returns NULL when the arena is exhausted (it never grows: size it for the
+// worst frame and watch arena->peak).
+void*
+arena_alloc(struct arena* arena, long size)
+{
+    assert(arena != NULL);
+    assert(size >= 0);
+
+    long start = (arena->used + ARENA_ALIGN - 1) & ~(long)(ARENA_ALIGN - 1);
+    if (start + size > arena->size) return NULL;
+
+    arena->used = start + size;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return arena->base + start;
+}
+
+void
+arena_reset(struct arena* arena)
+{
+    assert(arena != NULL);
+    arena->used = 0;
+}
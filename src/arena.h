@@ -0,0 +1,26 @@
+#ifndef FLAPPY_ARENA_H_INCLUDED
+#define FLAPPY_ARENA_H_INCLUDED
+
+#include <stdbool.h>
+
+// Linear (bump) allocator for transient per-frame data. Everything handed
+// out is released at once by arena_reset, so a frame never touches the heap.
+
+enum {
+    ARENA_ALIGN = 16,
+};
+
+struct arena {
+    unsigned char* base;
+    long size;
+    long used;
+    long peak;  // high-water mark across resets
+};
+
+bool arena_init(struct arena* arena, long size);
+void arena_free(struct arena* arena);
+
+void* arena_alloc(struct arena* arena, long size);
+void arena_reset(struct arena* arena);
+
+#endif
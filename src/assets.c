@@ -0,0 +1,181 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "assets.h"
+#include "image.h"
+
+struct assets {
+    struct asset items[ASSETS_MAX];
+    long count;
+
+    pthread_t workers[ASSETS_MAX_THREADS];
+    long threads;
+    double start;
+    double elapsed;
+
+    // shared by the workers and the consumer
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+    long claimed;          // images taken by a worker
+    long done[ASSETS_MAX]; // indices in completion order
+    long done_count;
+    long handed;           // completed images returned by assets_next
+};
+
+static double
+assets_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long
+assets_cpus(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    return sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+static void*
+assets_worker_run(void* arg)
+{
+    struct assets* assets = arg;
+
+    pthread_mutex_lock(&assets->lock);
+    while (assets->claimed < assets->count) {
+        long index = assets->claimed++;
+        pthread_mutex_unlock(&assets->lock);
+
+        struct asset* asset = &assets->items[index];
+        double start = assets_now();
+        asset->ok = image_load(&asset->image, asset->path);
+        double end = assets_now();
+        asset->decode_seconds = end - start;
+
+        pthread_mutex_lock(&assets->lock);
+        assets->done[assets->done_count++] = index;
+        if (assets->done_count == assets->count) assets->elapsed = end - assets->start;
+        pthread_cond_broadcast(&assets->finished);
+    }
+    pthread_mutex_unlock(&assets->lock);
+
+    return NULL;
+}
+
+struct assets*
+assets_start(const char* const* paths, long count, long threads)
+{
+    assert(paths != NULL);
+    assert(count >= 0 && count <= ASSETS_MAX);
+
+    struct assets* assets = calloc(1, sizeof(*assets));
+    if (assets == NULL) {
+        fprintf(stderr, "failed to allocate assets\n");
+        return NULL;
+    }
+
+    assets->count = count;
+    for (long i = 0; i < count; i++) {
+        assets->items[i].path = paths[i];
+    }
+
+    // one worker per online CPU unless told otherwise, never more than images
+    if (threads < 1) threads = assets_cpus();
+    if (threads > count) threads = count;
+    if (threads > ASSETS_MAX_THREADS) threads = ASSETS_MAX_THREADS;
+    if (threads < 1) threads = 1;
+
+    pthread_mutex_init(&assets->lock, NULL);
+    pthread_cond_init(&assets->finished, NULL);
+    assets->start = assets_now();
+
+    for (long t = 0; t < threads; t++) {
+        if (pthread_create(&assets->workers[t], NULL, assets_worker_run, assets) != 0) break;
+        assets->threads++;
+    }
+
+    // no threads at all: decode right here instead
+    if (assets->threads == 0) {
+        fprintf(stderr, "failed to start asset threads, decoding serially\n");
+        assets_worker_run(assets);
+    }
+
+    return assets;
+}
+
+void
+assets_destroy(struct assets* assets)
+{
+    if (assets == NULL) return;
+
+    for (long t = 0; t < assets->threads; t++) {
+        pthread_join(assets->workers[t], NULL);
+    }
+    for (long i = 0; i < assets->count; i++) {
+        image_free(&assets->items[i].image);
+    }
+
+    pthread_cond_destroy(&assets->finished);
+    pthread_mutex_destroy(&assets->lock);
+    free(assets);
+}
+
+long
+assets_next(struct assets* assets)
+{
+    assert(assets != NULL);
+
+    pthread_mutex_lock(&assets->lock);
+    while (assets->handed < assets->count && assets->handed == assets->done_count) {
+        pthread_cond_wait(&assets->finished, &assets->lock);
+    }
+    long index = -1;
+    if (assets->handed < assets->count) index = assets->done[assets->handed++];
+    pthread_mutex_unlock(&assets->lock);
+
+    return index;
+}
+
+struct asset*
+assets_get(struct assets* assets, long index)
+{
+    assert(assets != NULL);
+    assert(index >= 0 && index < assets->count);
+
+    return &assets->items[index];
+}
+
+double
+assets_elapsed(const struct assets* assets)
+{
+    assert(assets != NULL);
+
+    // only read once every image has been handed out (see assets_next)
+    return assets->elapsed;
+}
+
+long
+assets_threads(const struct assets* assets)
+{
+    assert(assets != NULL);
+
+    return assets->threads;
+}
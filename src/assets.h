@@ -0,0 +1,44 @@
+#ifndef FLAPPY_ASSETS_H_INCLUDED
+#define FLAPPY_ASSETS_H_INCLUDED
+
+#include <stdbool.h>
+
+#include "image.h"
+
+// Decodes a batch of images (see image.h) on a pool of worker threads, so
+// that decoding overlaps whatever the caller does meanwhile, e.g. creating
+// the window and GL context. Finished images are handed back in the order
+// they complete, so each one can be uploaded while the rest still decode.
+//
+// Workers take images one at a time from a shared cursor, so a batch with a
+// few large images keeps every thread busy until the end.
+
+enum {
+    ASSETS_MAX = 64,
+    ASSETS_MAX_THREADS = 16,
+};
+
+struct asset {
+    const char* path;
+    struct image image;
+    bool ok;
+    double decode_seconds;  // worker time spent on this image
+};
+
+struct assets;
+
+// Paths must outlive the batch. `threads` below 1 starts one worker per
+// online CPU; either way there are no more workers than images.
+struct assets* assets_start(const char* const* paths, long count, long threads);
+void assets_destroy(struct assets* assets);
+
+// Block until another image is done and return its index, or -1 once every
+// image has been handed out.
+long assets_next(struct assets* assets);
+struct asset* assets_get(struct assets* assets, long index);
+
+// Seconds from assets_start until the last image finished (0 until then).
+double assets_elapsed(const struct assets* assets);
+long assets_threads(const struct assets* assets);
+
+#endif
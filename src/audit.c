@@ -0,0 +1,41 @@
+#include <assert.h>
+#include <stddef.h>
+
+#include "audit.h"
+
+#if defined(__GNUC__)
+#define AUDIT_THREAD_LOCAL __thread
+#else
+#define AUDIT_THREAD_LOCAL
+#endif
+
+static AUDIT_THREAD_LOCAL long audit_allocations;
+static AUDIT_THREAD_LOCAL long audit_gl_objects;
+static AUDIT_THREAD_LOCAL long audit_draw_calls;
+
+void
+audit_count_allocation(void)
+{
+    audit_allocations++;
+}
+
+void
+audit_count_gl_objects(long count)
+{
+    audit_gl_objects += count;
+}
+
+void
+audit_count_draw_call(void)
+{
+    audit_draw_calls++;
+}
+
+void
+audit_read(struct audit_counts* counts)
+{
+    assert(counts != NULL);
+    counts->allocations = audit_allocations;
+    counts->gl_objects = audit_gl_objects;
+    counts->draw_calls = audit_draw_calls;
+}
@@ -0,0 +1,27 @@
+#ifndef FLAPPY_AUDIT_H_INCLUDED
+#define FLAPPY_AUDIT_H_INCLUDED
+
+// Per-thread counters of heap allocations and GL object creations, used to
+// check that steady-state frames allocate nothing. Draw calls are counted
+// alongside for the performance overlay.
+//
+// GL objects are always counted (see opengl_load_functions). Heap
+// allocations are only counted in binaries linked with
+//
+//   -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+//
+// plus audit_wrap.c, which routes every malloc/calloc/realloc made by
+// flappy's own code through counting wrappers ("make audit" does this).
+
+struct audit_counts {
+    long allocations;
+    long gl_objects;
+    long draw_calls;
+};
+
+void audit_count_allocation(void);
+void audit_count_gl_objects(long count);
+void audit_count_draw_call(void);
+void audit_read(struct audit_counts* counts);
+
+#endif
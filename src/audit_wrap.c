@@ -0,0 +1,35 @@
+#include <stddef.h>
+
+#include "audit.h"
+
+// Counting heap wrappers for audit builds. Only link this into binaries built
+// with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (see audit.h).
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size);
+void* __wrap_calloc(size_t count, size_t size);
+void* __wrap_realloc(void* ptr, size_t size);
+
+void*
+__wrap_malloc(size_t size)
+{
+    audit_count_allocation();
+    return __real_malloc(size);
+}
+
+void*
+__wrap_calloc(size_t count, size_t size)
+{
+    audit_count_allocation();
+    return __real_calloc(count, size);
+}
+
+void*
+__wrap_realloc(void* ptr, size_t size)
+{
+    audit_count_allocation();
+    return __real_realloc(ptr, size);
+}
@@ -0,0 +1,871 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "course.h"
+#include "env.h"
+#include "font.h"
+#include "metrics.h"
+#include "particle.h"
+#include "physics.h"
+#include "reach.h"
+#include "rollback.h"
+#include "timeline.h"
+#include "trajectory.h"
+#include "world.h"
+
+// Standalone benchmarks for libflappy (no window or GL context required).
+//
+// Every benchmark runs a fixed amount of work per repetition: a few warmup
+// repetitions are thrown away, then each timed repetition yields one sample
+// in nanoseconds per operation. Results are the median and the median
+// absolute deviation (MAD) of those samples, which shrug off the odd
+// preempted repetition. --json writes them one benchmark per line, so two
+// runs diff cleanly (see scripts/bench_compare.py).
+
+enum {
+    BENCH_MAX_REPS = 1001,
+    BENCH_MAX_RESULTS = 64,
+    BENCH_DEFAULT_REPS = 21,
+    BENCH_DEFAULT_WARMUP = 3,
+};
+
+struct bench_result {
+    const char* name;
+    long ops;       // operations per repetition
+    long reps;
+    double median;  // nanoseconds per operation
+    double mad;
+    double min;
+};
+
+struct bench {
+    long warmup;
+    long reps;
+    const char* filter;  // only run benchmarks whose name contains this
+
+    struct bench_result results[BENCH_MAX_RESULTS];
+    long count;
+};
+
+// one repetition of a benchmark: `ops` operations on `ctx`
+typedef void (*bench_fn)(void* ctx, long ops);
+
+// results are kept alive through here so the compiler can't drop the work
+static volatile long bench_sink;
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool
+bench_enabled(const struct bench* b, const char* name)
+{
+    return b->filter == NULL || strstr(name, b->filter) != NULL;
+}
+
+static int
+bench_compare(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Median of `samples` (reordered in place).
+static double
+bench_median(double* samples, long count)
+{
+    qsort(samples, count, sizeof(*samples), bench_compare);
+    if (count % 2 == 1) return samples[count / 2];
+    return (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+}
+
+// Time `fn` doing `ops` operations per repetition and record the result.
+static void
+bench_measure(struct bench* b, const char* name, bench_fn fn, void* ctx, long ops)
+{
+    assert(b->count < BENCH_MAX_RESULTS);
+    assert(b->reps >= 1 && b->reps <= BENCH_MAX_REPS);
+    if (!bench_enabled(b, name)) return;
+
+    for (long i = 0; i < b->warmup; i++) {
+        fn(ctx, ops);
+    }
+
+    double samples[BENCH_MAX_REPS];
+    for (long i = 0; i < b->reps; i++) {
+        double start = bench_now();
+        fn(ctx, ops);
+        samples[i] = (bench_now() - start) * 1e9 / ops;
+    }
+
+    struct bench_result* result = &b->results[b->count++];
+    result->name = name;
+    result->ops = ops;
+    result->reps = b->reps;
+    result->median = bench_median(samples, b->reps);
+    result->min = samples[0];
+    for (long i = 0; i < b->reps; i++) {
+        double deviation = samples[i] - result->median;
+        samples[i] = deviation < 0.0 ? -deviation : deviation;
+    }
+    result->mad = bench_median(samples, b->reps);
+
+    printf("%-32s %12.2lf ns/op  +- %-10.2lf min %-12.2lf (%ld ops x %ld reps)\n",
+        name, result->median, result->mad, result->min, ops, result->reps);
+}
+
+static bool
+bench_write_json(const struct bench* b, const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "failed to open file: %s\n", path);
+        return false;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"unit\": \"ns/op\",\n");
+    fprintf(f, "  \"warmup\": %ld,\n", b->warmup);
+    fprintf(f, "  \"reps\": %ld,\n", b->reps);
+    fprintf(f, "  \"benchmarks\": [\n");
+    for (long i = 0; i < b->count; i++) {
+        const struct bench_result* r = &b->results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"median\": %.3lf, \"mad\": %.3lf, \"min\": %.3lf, \"ops\": %ld, \"reps\": %ld}%s\n",
+            r->name, r->median, r->mad, r->min, r->ops, r->reps, i + 1 < b->count ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    bool ok = ferror(f) == 0;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "failed to write file: %s\n", path);
+    return ok;
+}
+
+// Flap towards the next gap, crashing now and then (flaps to start and
+// restart a run too).
+static bool
+bench_bot(const struct world* world, long tick)
+{
+    struct course_record obstacle;
+    bool flap = !world->running || world->dead;
+    if (world_obstacle(world, world->score, &obstacle)) {
+        flap = flap || (world->entities.pos_y[WORLD_BIRD] < obstacle.gap - 0.5f &&
+            world->entities.vel_y[WORLD_BIRD] < 0.0f && (tick % 7) != 0);
+    }
+    return flap;
+}
+
+enum {
+    PHYSICS_CASES = 4096,  // 112 KB of inputs, cycled through
+};
+
+struct physics_case {
+    float cx, cy, cr;
+    float rx, ry, rw, rh;
+};
+
+static void
+physics_run(void* ctx, long ops)
+{
+    const struct physics_case* cases = ctx;
+    long hits = 0;
+    for (long i = 0; i < ops; i++) {
+        const struct physics_case* c = &cases[i % PHYSICS_CASES];
+        hits += physics_intersect_circle_rect(c->cx, c->cy, c->cr, c->rx, c->ry, c->rw, c->rh);
+    }
+    bench_sink = hits;
+}
+
+static void
+bench_physics(struct bench* b)
+{
+    if (!bench_enabled(b, "physics_intersect_circle_rect")) return;
+
+    struct physics_case* cases = malloc(PHYSICS_CASES * sizeof(*cases));
+    assert(cases != NULL);
+
+    // a bird-sized circle anywhere in view against pipe-sized rects around
+    // it, so hits and misses (and every clamping branch) are mixed
+    unsigned int seed = 1;
+    for (long i = 0; i < PHYSICS_CASES; i++) {
+        float r[6];
+        for (long j = 0; j < 6; j++) {
+            seed = seed * 1103515245u + 12345u;
+            r[j] = ((seed >> 8) & 0xffff) / 65535.0f;
+        }
+        cases[i].cx = (r[0] - 0.5f) * WIDTH;
+        cases[i].cy = (r[1] - 0.5f) * HEIGHT;
+        cases[i].cr = BIRD_RADIUS;
+        cases[i].rx = cases[i].cx + (r[2] - 0.5f) * 4.0f * PIPE_WIDTH;
+        cases[i].ry = cases[i].cy + (r[3] - 0.5f) * HEIGHT;
+        cases[i].rw = PIPE_WIDTH;
+        cases[i].rh = r[4] * HEIGHT;
+    }
+
+    bench_measure(b, "physics_intersect_circle_rect", physics_run, cases, 1000000);
+
+    free(cases);
+}
+
+enum {
+    FONT_STRINGS = 256,
+    FONT_BUFFER_SIZE = 64 * 1024,
+};
+
+struct font_ctx {
+    char strings[FONT_STRINGS][16];
+    float* buffer;
+};
+
+static void
+font_size_run(void* ctx, long ops)
+{
+    struct font_ctx* font = ctx;
+    long total = 0;
+    for (long i = 0; i < ops; i++) {
+        total += font_size(font->strings[i % FONT_STRINGS]);
+    }
+    bench_sink = total;
+}
+
+static void
+font_vertices_run(void* ctx, long ops)
+{
+    struct font_ctx* font = ctx;
+    long total = 0;
+    for (long i = 0; i < ops; i++) {
+        total += font_vertices(font->strings[i % FONT_STRINGS]);
+    }
+    bench_sink = total;
+}
+
+static void
+font_print_run(void* ctx, long ops)
+{
+    struct font_ctx* font = ctx;
+    for (long i = 0; i < ops; i++) {
+        const char* str = font->strings[i % FONT_STRINGS];
+        long size = font_size(str);
+        font_print(str, font->buffer, size);
+        font_place(font->buffer, size, -WIDTH / 2.0f + 1.0f, HEIGHT / 2.0f - 1.0f, 0.5f, 0.5f);
+    }
+    bench_sink = (long)font->buffer[0];
+}
+
+static void
+bench_font(struct bench* b)
+{
+    if (!bench_enabled(b, "font_size") && !bench_enabled(b, "font_vertices") && !bench_enabled(b, "font_print")) return;
+
+    struct font_ctx* font = malloc(sizeof(*font));
+    assert(font != NULL);
+    font->buffer = malloc(FONT_BUFFER_SIZE);
+    assert(font->buffer != NULL);
+
+    // scores as the HUD prints them, mostly three digits with some longer
+    unsigned int seed = 1;
+    for (long i = 0; i < FONT_STRINGS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        long score = (seed >> 8) % ((i % 4) == 0 ? 100000 : 1000);
+        snprintf(font->strings[i], sizeof(font->strings[i]), "%.3ld", score);
+        assert(font_size(font->strings[i]) <= FONT_BUFFER_SIZE);
+    }
+
+    bench_measure(b, "font_size", font_size_run, font, 1000000);
+    bench_measure(b, "font_vertices", font_vertices_run, font, 1000000);
+    bench_measure(b, "font_print", font_print_run, font, 100000);
+
+    free(font->buffer);
+    free(font);
+}
+
+struct world_ctx {
+    struct world world;
+    long tick;
+    long runs;
+};
+
+static void
+world_update_run(void* ctx, long ops)
+{
+    struct world_ctx* w = ctx;
+    for (long i = 0; i < ops; i++) {
+        bool dead = w->world.dead;
+        world_update(&w->world, bench_bot(&w->world, w->tick++), TICK);
+        w->runs += w->world.dead && !dead;
+    }
+    bench_sink = w->world.score;
+}
+
+static void
+bench_world(struct bench* b)
+{
+    if (!bench_enabled(b, "world_update")) return;
+
+    struct world_ctx* w = malloc(sizeof(*w));
+    assert(w != NULL);
+    world_init(&w->world, NULL, 1);
+    w->tick = 0;
+    w->runs = 0;
+
+    // headless game ticks with a bot that plays (and dies) like a person
+    bench_measure(b, "world_update", world_update_run, w, 100000);
+    printf("  %ld ticks, %ld deaths\n", w->tick, w->runs);
+
+    free(w);
+}
+
+static void
+particle_update_run(void* ctx, long ops)
+{
+    // keep the pool full: long-lived particles, topped up every step
+    struct particle_pool* pool = ctx;
+    for (long i = 0; i < ops / PARTICLE_CAPACITY; i++) {
+        particle_update(pool, 9.0f, 1.0f / 120.0f);
+        particle_emit(pool, 0.0f, 0.0f, PARTICLE_CAPACITY, 4.0f, 1000.0f, 0.1f);
+    }
+}
+
+static void
+bench_particles(struct bench* b)
+{
+    if (!bench_enabled(b, "particle_update")) return;
+
+    struct particle_pool* pool = particle_pool_create(1);
+    assert(pool != NULL);
+    particle_emit(pool, 0.0f, 0.0f, PARTICLE_CAPACITY, 4.0f, 1000.0f, 0.1f);
+
+    // per particle
+    bench_measure(b, "particle_update", particle_update_run, pool, 100L * PARTICLE_CAPACITY);
+
+    particle_pool_destroy(pool);
+}
+
+enum {
+    ROLLBACK_LATE = 8,  // remote inputs arrive this many frames late
+};
+
+struct rollback_ctx {
+    struct rollback* rollback;
+    long frame;
+    struct world* worlds;
+};
+
+static void
+rollback_step_run(void* ctx, long ops)
+{
+    // remote flaps contradict the "no flap" prediction, so those steps roll
+    // back and resimulate ROLLBACK_LATE frames
+    struct rollback_ctx* r = ctx;
+    for (long i = 0; i < ops; i++, r->frame++) {
+        if (r->frame >= ROLLBACK_LATE) rollback_add_remote(r->rollback, r->frame - ROLLBACK_LATE, (r->frame % 30) == 0);
+        bool stepped = rollback_step(r->rollback, (r->frame % 40) == 0);
+        assert(stepped);
+        (void)stepped;
+    }
+}
+
+static void
+world_copy_run(void* ctx, long ops)
+{
+    // the state save alone, which runs once for every simulated frame
+    struct rollback_ctx* r = ctx;
+    for (long i = 0; i < ops; i++) {
+        world_copy(&r->worlds[1], &r->worlds[0]);
+    }
+}
+
+static void
+bench_rollback(struct bench* b)
+{
+    if (!bench_enabled(b, "rollback_step") && !bench_enabled(b, "world_copy")) return;
+
+    struct rollback_ctx r = { 0 };
+    r.rollback = rollback_create(0, 0, NULL, 1);
+    r.worlds = malloc(2 * sizeof(*r.worlds));
+    assert(r.rollback != NULL && r.worlds != NULL);
+
+    bench_measure(b, "rollback_step", rollback_step_run, &r, 1000);
+    if (bench_enabled(b, "rollback_step")) {
+        printf("  %ld steps, %ld resimulated\n", r.frame, r.rollback->resimulated);
+    }
+
+    world_copy(&r.worlds[0], rollback_world(r.rollback, 0));
+    bench_measure(b, "world_copy", world_copy_run, &r, 10000);
+
+    free(r.worlds);
+    rollback_destroy(r.rollback);
+}
+
+enum {
+    ENV_COUNT = 256,
+};
+
+struct env_ctx {
+    struct env* env;
+    long dones;
+};
+
+static void
+env_step_run(void* ctx, long ops)
+{
+    // flap whenever the bird drops below the next gap
+    struct env_ctx* e = ctx;
+    struct env* env = e->env;
+    for (long i = 0; i < ops / ENV_COUNT; i++) {
+        for (long j = 0; j < ENV_COUNT; j++) {
+            const float* observation = &env->observations[j * ENV_OBSERVATION_SIZE];
+            env->actions[j] = observation[3] > 0.3f;
+        }
+        env_step(env);
+        for (long j = 0; j < ENV_COUNT; j++) {
+            e->dones += env->dones[j];
+        }
+    }
+}
+
+static void
+bench_env(struct bench* b)
+{
+    if (!bench_enabled(b, "env_step")) return;
+
+    struct env_ctx e = { 0 };
+    e.env = env_create("/flappy-env-bench", ENV_COUNT, 1, NULL, 1);
+    if (e.env == NULL) return;
+
+    // per environment step
+    bench_measure(b, "env_step", env_step_run, &e, 100L * ENV_COUNT);
+    printf("  %d environments, %ld episodes\n", ENV_COUNT, e.dones);
+
+    env_close(e.env);
+}
+
+struct metrics_ctx {
+    struct metrics* metrics;
+    struct metric* counter;
+    struct metric* histogram;
+    char text[16 * 1024];
+    long length;
+};
+
+static void
+metric_add_run(void* ctx, long ops)
+{
+    struct metrics_ctx* m = ctx;
+    for (long i = 0; i < ops; i++) {
+        metric_add(m->counter, 1);
+    }
+}
+
+static void
+metric_observe_run(void* ctx, long ops)
+{
+    struct metrics_ctx* m = ctx;
+    for (long i = 0; i < ops; i++) {
+        metric_observe(m->histogram, (i & 63) * 0.001);
+    }
+}
+
+static void
+metrics_format_run(void* ctx, long ops)
+{
+    struct metrics_ctx* m = ctx;
+    for (long i = 0; i < ops; i++) {
+        m->length = metrics_format(m->metrics, m->text, sizeof(m->text));
+    }
+}
+
+static void
+bench_metrics(struct bench* b)
+{
+    if (!bench_enabled(b, "metric_add") && !bench_enabled(b, "metric_observe") && !bench_enabled(b, "metrics_format")) return;
+
+    static const double bounds[] = { 0.001, 0.002, 0.004, 0.008, 0.0125, 0.0167, 0.025, 0.0334, 0.05, 0.1, 0.25 };
+
+    struct metrics_ctx* m = malloc(sizeof(*m));
+    assert(m != NULL);
+    m->metrics = metrics_create();
+    assert(m->metrics != NULL);
+    m->counter = metrics_counter(m->metrics, "bench_total", "Benchmark counter.");
+    m->histogram = metrics_histogram(m->metrics, "bench_seconds", "Benchmark histogram.",
+        bounds, sizeof(bounds) / sizeof(bounds[0]));
+    m->length = 0;
+
+    bench_measure(b, "metric_add", metric_add_run, m, 1000000);
+    bench_measure(b, "metric_observe", metric_observe_run, m, 1000000);
+    bench_measure(b, "metrics_format", metrics_format_run, m, 100);
+    if (bench_enabled(b, "metrics_format")) {
+        printf("  %ld bytes\n", m->length);
+    }
+
+    metrics_destroy(m->metrics);
+    free(m);
+}
+
+enum {
+    TIMELINE_TICKS = 60 * 120,  // one minute at 120 Hz, the whole history
+};
+
+struct timeline_ctx {
+    struct timeline* timeline;
+    struct world* world;
+    long bytes;
+    long keyframes;
+    unsigned int seed;
+};
+
+static void
+timeline_record_run(void* ctx, long ops)
+{
+    // a fresh minute of play every repetition
+    struct timeline_ctx* t = ctx;
+    timeline_clear(t->timeline);
+    world_init(t->world, NULL, 1);
+    t->bytes = 0;
+    t->keyframes = 0;
+    for (long i = 0; i < ops; i++) {
+        world_update(t->world, bench_bot(t->world, i), TICK);
+        timeline_record(t->timeline, t->world, i);
+
+        const struct timeline_entry* entry = timeline_entry(t->timeline, t->timeline->count - 1);
+        t->bytes += entry->size;
+        t->keyframes += entry->keyframe;
+    }
+}
+
+static void
+timeline_restore_run(void* ctx, long ops)
+{
+    // scrubbing lands anywhere within a keyframe group
+    struct timeline_ctx* t = ctx;
+    for (long i = 0; i < ops; i++) {
+        t->seed = t->seed * 1103515245u + 12345u;
+        bool ok = timeline_restore(t->timeline, (t->seed >> 8) % t->timeline->count, &t->world[1]);
+        assert(ok);
+        (void)ok;
+    }
+}
+
+static void
+bench_timeline(struct bench* b)
+{
+    if (!bench_enabled(b, "timeline_record") && !bench_enabled(b, "timeline_restore")) return;
+
+    struct timeline_ctx t = { 0 };
+    t.timeline = timeline_create();
+    t.world = malloc(3 * sizeof(*t.world));
+    assert(t.timeline != NULL && t.world != NULL);
+    t.seed = 1;
+
+    // per tick; also leaves a full minute of history for the restores
+    timeline_record_run(&t, TIMELINE_TICKS);
+    bench_measure(b, "timeline_record", timeline_record_run, &t, TIMELINE_TICKS);
+    printf("  %ld snapshots kept, %ld bytes (%.1lf B/tick, %ld keyframes), struct timeline is %zu bytes\n",
+        t.timeline->count, t.bytes, (double)t.bytes / TIMELINE_TICKS, t.keyframes, sizeof(struct timeline));
+
+    bench_measure(b, "timeline_restore", timeline_restore_run, &t, 1000);
+
+    // round trip: the middle of the run comes back exactly
+    struct world* restored = &t.world[1];
+    struct world* expected = &t.world[2];
+    world_init(t.world, NULL, 1);
+    timeline_clear(t.timeline);
+    for (long i = 0; i < TIMELINE_TICKS; i++) {
+        world_update(t.world, bench_bot(t.world, i), TICK);
+        timeline_record(t.timeline, t.world, i);
+        if (i == TIMELINE_TICKS / 2) world_copy(expected, t.world);
+    }
+    world_copy(restored, t.world);
+    bool ok = timeline_restore(t.timeline, timeline_find(t.timeline, TIMELINE_TICKS / 2), restored);
+    ok = ok && restored->ticks == expected->ticks && restored->entities.count == expected->entities.count &&
+        restored->entities.pos_y[WORLD_BIRD] == expected->entities.pos_y[WORLD_BIRD];
+    printf("  round trip %s\n", ok ? "ok" : "FAILED");
+
+    free(t.world);
+    timeline_destroy(t.timeline);
+}
+
+enum {
+    TRAJECTORY_WORLDS = 64,
+    TRAJECTORY_ROWS = 4 * TRAJECTORY_CHUNK_ROWS,
+};
+
+struct trajectory_ctx {
+    const char* path;
+    struct trajectory_record* records;
+    struct trajectory_stats stats;
+};
+
+static void
+trajectory_write_run(void* ctx, long ops)
+{
+    // a whole file every repetition: open, append, and the final flush
+    struct trajectory_ctx* t = ctx;
+    struct trajectory* trajectory = trajectory_create(t->path, TRAJECTORY_WORLDS);
+    assert(trajectory != NULL);
+    for (long i = 0; i < ops; i++) {
+        trajectory_append(trajectory, &t->records[i]);
+    }
+    bool ok = trajectory_close(trajectory, &t->stats);
+    assert(ok);
+    (void)ok;
+}
+
+static void
+bench_trajectory(struct bench* b)
+{
+    if (!bench_enabled(b, "trajectory_write")) return;
+
+    // rows as flappy-env logs them: many worlds stepped side by side
+    struct trajectory_ctx t = { 0 };
+    t.path = "bench-trajectory.bin";
+    t.records = malloc(TRAJECTORY_ROWS * sizeof(*t.records));
+    struct world* worlds = malloc(TRAJECTORY_WORLDS * sizeof(*worlds));
+    assert(t.records != NULL && worlds != NULL);
+
+    uint32_t runs[TRAJECTORY_WORLDS];
+    for (long w = 0; w < TRAJECTORY_WORLDS; w++) {
+        world_init(&worlds[w], NULL, w);
+        worlds[w].running = true;
+        runs[w] = w;
+    }
+    uint32_t next_run = TRAJECTORY_WORLDS;
+    for (long i = 0; i < TRAJECTORY_ROWS; i++) {
+        long w = i % TRAJECTORY_WORLDS;
+        bool flap = bench_bot(&worlds[w], i / TRAJECTORY_WORLDS);
+        world_update(&worlds[w], flap, TICK);
+        trajectory_record_world(&t.records[i], &worlds[w], runs[w], flap);
+        if (worlds[w].dead) {
+            world_reset(&worlds[w]);
+            worlds[w].running = true;
+            runs[w] = next_run++;
+        }
+    }
+
+    bench_measure(b, "trajectory_write", trajectory_write_run, &t, TRAJECTORY_ROWS);
+    printf("  %ld rows, %ld bytes (%.2lf B/row, %.1lf raw), %ld stalls in the last repetition\n",
+        t.stats.rows, t.stats.bytes, (double)t.stats.bytes / t.stats.rows,
+        (double)t.stats.raw_bytes / t.stats.rows, t.stats.stalls);
+
+    remove(t.path);
+    free(worlds);
+    free(t.records);
+}
+
+enum {
+    REACH_BENCH_THREADS = 4,
+    REACH_BENCH_PIPES = 3,
+    REACH_BENCH_SEEDS = 64,
+    REACH_BENCH_BUDGET = 10000000,
+};
+
+struct reach_ctx {
+    struct reach reach;
+    struct world* world;
+    struct world* copy;
+    long crashes;  // and ticks played, over warmup and every repetition
+    long ticks;
+    unsigned int seed;
+    long solved;
+};
+
+static void
+reach_bot_run(void* ctx, long ops)
+{
+    struct reach_ctx* r = ctx;
+    for (long i = 0; i < ops; i++) {
+        bool dead = r->world->dead;
+        world_update(r->world, reach_bot(&r->reach, r->world), TICK);
+        r->crashes += r->world->dead && !dead;
+    }
+    r->ticks += ops;
+    bench_sink = r->world->score;
+}
+
+// The same decision by brute force: glide if a search finds a way past the
+// next obstacle after gliding, otherwise flap.
+static void
+reach_search_bot_run(void* ctx, long ops)
+{
+    struct reach_ctx* r = ctx;
+    for (long i = 0; i < ops; i++) {
+        bool flap = !r->world->running || r->world->dead;
+        if (!flap) {
+            world_copy(r->copy, r->world);
+            world_update(r->copy, false, TICK);
+            struct reach_solution solution;
+            flap = r->copy->dead || reach_validate(NULL, r->copy, 1, REACH_BENCH_BUDGET, &solution) != REACH_SOLVED;
+        }
+        bool dead = r->world->dead;
+        world_update(r->world, flap, TICK);
+        r->crashes += r->world->dead && !dead;
+    }
+    r->ticks += ops;
+    bench_sink = r->world->score;
+}
+
+// Play one bot from a fresh seed 1 world and report how often it crashed, per
+// 100k ticks so that the table and brute force bots can be compared.
+static void
+reach_bot_measure(struct bench* b, const char* name, bench_fn fn, struct reach_ctx* r, long ops)
+{
+    world_init(r->world, NULL, 1);
+    r->crashes = 0;
+    r->ticks = 0;
+    bench_measure(b, name, fn, r, ops);
+    if (!bench_enabled(b, name)) return;
+
+    printf("  %ld crashes in %ld ticks: %.1lf per 100k ticks\n", r->crashes, r->ticks,
+        r->crashes * 100000.0 / r->ticks);
+}
+
+static void
+reach_validate_run(void* ctx, long ops)
+{
+    struct reach_ctx* r = ctx;
+    for (long i = 0; i < ops; i++) {
+        world_init(r->world, NULL, r->seed++ % REACH_BENCH_SEEDS);
+        struct reach_solution solution;
+        r->solved += reach_validate(&r->reach, r->world, REACH_BENCH_PIPES, REACH_BENCH_BUDGET, &solution) == REACH_SOLVED;
+    }
+}
+
+static void
+reach_validate_brute_run(void* ctx, long ops)
+{
+    struct reach_ctx* r = ctx;
+    for (long i = 0; i < ops; i++) {
+        world_init(r->world, NULL, r->seed++ % REACH_BENCH_SEEDS);
+        struct reach_solution solution;
+        r->solved += reach_validate(NULL, r->world, REACH_BENCH_PIPES, REACH_BENCH_BUDGET, &solution) == REACH_SOLVED;
+    }
+}
+
+static void
+bench_reach(struct bench* b)
+{
+    if (!bench_enabled(b, "reach_bot") && !bench_enabled(b, "reach_search_bot") &&
+        !bench_enabled(b, "reach_validate")) return;
+
+    struct reach_ctx r = { 0 };
+    r.world = malloc(sizeof(*r.world));
+    r.copy = malloc(sizeof(*r.copy));
+    assert(r.world != NULL && r.copy != NULL);
+
+    // built once: seconds, not worth repeating
+    double start = bench_now();
+    bool ok = reach_generate(&r.reach, REACH_BENCH_THREADS);
+    assert(ok);
+    (void)ok;
+    printf("  reach table: %zu bytes generated in %.2lf s (%d threads)\n", r.reach.size, bench_now() - start,
+        REACH_BENCH_THREADS);
+
+    // whole games, restarting after every crash
+    reach_bot_measure(b, "reach_bot", reach_bot_run, &r, 100000);
+    reach_bot_measure(b, "reach_search_bot", reach_search_bot_run, &r, 20);
+
+    // brute force is too slow for a long sample, so also replay the table bot
+    // over exactly the ticks the search bot played
+    if (bench_enabled(b, "reach_search_bot")) {
+        long ticks = r.ticks;
+        world_init(r.world, NULL, 1);
+        r.crashes = 0;
+        r.ticks = 0;
+        reach_bot_run(&r, ticks);
+        printf("  reach_bot over the same %ld ticks: %ld crashes\n", ticks, r.crashes);
+    }
+
+    // the first REACH_BENCH_PIPES obstacles of seeded worlds
+    r.seed = 0;
+    r.solved = 0;
+    bench_measure(b, "reach_validate", reach_validate_run, &r, REACH_BENCH_SEEDS);
+    if (bench_enabled(b, "reach_validate")) printf("  %ld of %u solved\n", r.solved, r.seed);
+
+    r.seed = 0;
+    r.solved = 0;
+    bench_measure(b, "reach_validate_brute", reach_validate_brute_run, &r, 1);
+    if (bench_enabled(b, "reach_validate_brute")) printf("  %ld of %u solved\n", r.solved, r.seed);
+
+    reach_close(&r.reach);
+    free(r.copy);
+    free(r.world);
+}
+
+static void
+print_usage(const char* arg0)
+{
+    printf("usage: %s [options]\n", arg0);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -h --help         print this help\n");
+    printf("  -r --reps N       timed repetitions per benchmark (default: %d)\n", BENCH_DEFAULT_REPS);
+    printf("  -w --warmup N     untimed repetitions first (default: %d)\n", BENCH_DEFAULT_WARMUP);
+    printf("  -f --filter TEXT  only run benchmarks whose name contains TEXT\n");
+    printf("  -j --json FILE    write results as JSON (compare with scripts/bench_compare.py)\n");
+}
+
+int
+main(int argc, char* argv[])
+{
+    static struct bench b = {
+        .warmup = BENCH_DEFAULT_WARMUP,
+        .reps = BENCH_DEFAULT_REPS,
+    };
+    const char* json = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--reps") == 0) {
+            b.reps = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--warmup") == 0) {
+            b.warmup = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 || strcmp(argv[i], "--filter") == 0) {
+            b.filter = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--json") == 0) {
+            json = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (b.reps < 1 || b.reps > BENCH_MAX_REPS || b.warmup < 0) {
+        fprintf(stderr, "reps must be 1 to %d and warmup at least 0\n", BENCH_MAX_REPS);
+        return EXIT_FAILURE;
+    }
+
+    bench_physics(&b);
+    bench_font(&b);
+    bench_world(&b);
+    bench_particles(&b);
+    bench_rollback(&b);
+    bench_env(&b);
+    bench_metrics(&b);
+    bench_timeline(&b);
+    bench_trajectory(&b);
+    bench_reach(&b);
+
+    if (json != NULL && !bench_write_json(&b, json)) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
@@ -11,14 +11,26 @@ static const float SPEED   = 6.0f;
 static const float SCROLL  = 1.0f;
 static const float GRAVITY = 18.0f;
 
+// fixed simulation step (used wherever runs must replay identically)
+static const float TICK = 1.0f / 120.0f;
+
+// the ceiling and floor only count once the bird is past this x
+static const float WALL_START_X = -4.0f;
+
 static const float BG_WIDTH    = 4.5;
 static const float BG_HEIGHT   = 9.0f;
 static const float BG_LAYER    = 0.0f;
 static const float BIRD_WIDTH  = 1.0f;
 static const float BIRD_HEIGHT = 1.0f;
 static const float BIRD_LAYER  = 0.2f;
+static const float BIRD_RADIUS = 0.3f;
+static const float BIRD_SPIN   = 5.0f;
 static const float PIPE_WIDTH  = 1.0f;
 static const float PIPE_HEIGHT = 8.0f;
 static const float PIPE_LAYER  = 0.1f;
+static const float PIPE_SPACING = 4.0f;
+
+static const float PARTICLE_LAYER   = 0.3f;
+static const float PARTICLE_GRAVITY = 9.0f;
 
 #endif
@@ -0,0 +1,257 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "course.h"
+
+// alignment of the tables in the file (that of their structs)
+#define COURSE_RECORD_ALIGN offsetof(struct { char c; struct course_record r; }, r)
+#define COURSE_INDEX_ALIGN offsetof(struct { char c; struct course_index i; }, i)
+
+#ifndef _WIN32
+
+static void*
+course_map(const char* path, size_t* size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "failed to open course: %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "failed to stat course: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "failed to map course: %s\n", path);
+        return NULL;
+    }
+
+    // access follows the camera: no point in large readahead
+    madvise(data, st.st_size, MADV_RANDOM);
+
+    *size = st.st_size;
+    return data;
+}
+
+static void
+course_unmap(void* data, size_t size)
+{
+    munmap(data, size);
+}
+
+#else
+
+// no mmap on Windows builds: read the whole file instead
+static void*
+course_map(const char* path, size_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "failed to open course: %s\n", path);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    void* data = length > 0 ? malloc(length) : NULL;
+    if (data == NULL || fread(data, 1, length, f) != (size_t)length) {
+        fprintf(stderr, "failed to read course: %s\n", path);
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    *size = length;
+    return data;
+}
+
+static void
+course_unmap(void* data, size_t size)
+{
+    (void)size;
+    free(data);
+}
+
+#endif
+
+static bool
+course_validate(const struct course* course, const char* path)
+{
+    const struct course_header* header = course->header;
+    if (course->size < sizeof(*header) || memcmp(header->magic, COURSE_MAGIC, sizeof(COURSE_MAGIC)) != 0) {
+        fprintf(stderr, "invalid course file: %s\n", path);
+        return false;
+    }
+    if (header->version != COURSE_VERSION) {
+        fprintf(stderr, "unsupported course version: %u\n", (unsigned)header->version);
+        return false;
+    }
+
+    // counts are checked against the file size before they are multiplied,
+    // so a huge one can't wrap around and pass for a small one
+    if (header->record_offset > course->size || header->index_offset > course->size ||
+        header->record_count > (course->size - header->record_offset) / sizeof(struct course_record) ||
+        header->index_count > (course->size - header->index_offset) / sizeof(struct course_index)) {
+        fprintf(stderr, "truncated course file: %s\n", path);
+        return false;
+    }
+
+    // both tables are used in place, straight from the mapping
+    if (header->record_offset % COURSE_RECORD_ALIGN != 0 || header->index_offset % COURSE_INDEX_ALIGN != 0) {
+        fprintf(stderr, "misaligned course file: %s\n", path);
+        return false;
+    }
+
+    uint64_t stride = header->index_stride;
+    if (stride == 0 || (header->record_count + stride - 1) / stride != header->index_count) {
+        fprintf(stderr, "invalid course index: %s\n", path);
+        return false;
+    }
+
+    // course_find relies on entry i pointing at record i * stride, with x
+    // never decreasing from one entry to the next
+    const struct course_index* index =
+        (const struct course_index*)((const unsigned char*)course->data + header->index_offset);
+    for (uint64_t i = 0; i < header->index_count; i++) {
+        bool valid = index[i].record == i * stride && index[i].record < header->record_count;
+        if (i > 0) valid = valid && index[i].x >= index[i - 1].x;
+        if (!valid) {
+            fprintf(stderr, "invalid course index: %s\n", path);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+course_open(struct course* course, const char* path)
+{
+    assert(course != NULL);
+    assert(path != NULL);
+
+    memset(course, 0, sizeof(*course));
+
+    course->data = course_map(path, &course->size);
+    if (course->data == NULL) return false;
+
+    const unsigned char* bytes = course->data;
+    course->header = course->data;
+    if (!course_validate(course, path)) {
+        course_close(course);
+        return false;
+    }
+
+    course->records = (const struct course_record*)(bytes + course->header->record_offset);
+    course->index = (const struct course_index*)(bytes + course->header->index_offset);
+    return true;
+}
+
+void
+course_close(struct course* course)
+{
+    assert(course != NULL);
+
+    if (course->data != NULL) {
+        course_unmap(course->data, course->size);
+    }
+    memset(course, 0, sizeof(*course));
+}
+
+long
+course_count(const struct course* course)
+{
+    assert(course != NULL);
+    return course->header->record_count;
+}
+
+// Index of the first record at or beyond x (course_count if there is none).
+// The sparse index narrows the search to a single stride of records so that
+// only one block of the file is paged in.
+long
+course_find(const struct course* course, float x)
+{
+    assert(course != NULL);
+
+    const struct course_header* header = course->header;
+    if (header->record_count == 0) return 0;
+
+    // last index entry starting at or before x
+    long lo = 0;
+    long hi = header->index_count;
+    while (hi - lo > 1) {
+        long mid = lo + (hi - lo) / 2;
+        if (course->index[mid].x <= x) lo = mid;
+        else hi = mid;
+    }
+
+    // first record within that stride at or beyond x
+    long first = course->index[lo].record;
+    long last = first + header->index_stride;
+    if (last > (long)header->record_count) last = header->record_count;
+    while (first < last) {
+        long mid = first + (last - first) / 2;
+        if (course->records[mid].x < x) first = mid + 1;
+        else last = mid;
+    }
+
+    return first;
+}
+
+const struct course_record*
+course_record(const struct course* course, long i)
+{
+    assert(course != NULL);
+
+    if (i < 0 || i >= (long)course->header->record_count) return NULL;
+    return &course->records[i];
+}
+
+// Hand back pages that only hold records before the given one. The camera
+// never moves backwards, so they won't be needed again this run (and would
+// simply fault back in if they were).
+void
+course_release(struct course* course, long first)
+{
+    assert(course != NULL);
+
+#if !defined(_WIN32) && defined(MADV_DONTNEED)
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) return;
+
+    size_t end = course->header->record_offset + first * sizeof(struct course_record);
+    end -= end % page;
+
+    // a new run started from the beginning of the course
+    if (end < course->released) course->released = end;
+    if (end == course->released) return;
+
+    madvise((unsigned char*)course->data + course->released, end - course->released, MADV_DONTNEED);
+    course->released = end;
+#else
+    (void)first;
+#endif
+}
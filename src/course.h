@@ -0,0 +1,68 @@
+#ifndef FLAPPY_COURSE_H_INCLUDED
+#define FLAPPY_COURSE_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary course files (little-endian, written by scripts/course.py):
+//
+//   header   struct course_header
+//   records  struct course_record[record_count], sorted by x
+//   index    struct course_index[index_count], one per index_stride records
+//
+// Files are memory-mapped and only the records around the camera are ever
+// touched, so resident memory follows the visible window, not the file size.
+
+enum {
+    COURSE_VERSION = 1,
+};
+
+static const char COURSE_MAGIC[4] = { 'F', 'L', 'P', 'C' };
+
+struct course_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t record_count;
+    uint64_t record_offset;
+    uint64_t index_offset;
+    uint32_t index_count;
+    uint32_t index_stride;
+};
+
+struct course_record {
+    float x;
+    float gap;        // center of the opening
+    float gap_size;   // height of the opening
+    float amplitude;  // vertical motion (0.0 for a static obstacle)
+    float frequency;  // oscillations per second
+    uint32_t flags;   // reserved
+};
+
+struct course_index {
+    float x;
+    uint32_t reserved;
+    uint64_t record;
+};
+
+struct course {
+    void* data;
+    size_t size;
+
+    const struct course_header* header;
+    const struct course_record* records;
+    const struct course_index* index;
+
+    // bytes at the front of the mapping already handed back to the OS
+    size_t released;
+};
+
+bool course_open(struct course* course, const char* path);
+void course_close(struct course* course);
+
+long course_count(const struct course* course);
+long course_find(const struct course* course, float x);
+const struct course_record* course_record(const struct course* course, long i);
+void course_release(struct course* course, long first);
+
+#endif
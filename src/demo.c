@@ -0,0 +1,90 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "course.h"
+#include "demo.h"
+#include "entity.h"
+#include "particle.h"
+#include "world.h"
+
+// Flap whenever the bird drops below the middle of the next gap.
+static bool
+demo_bot_flap(const struct world* world)
+{
+    const struct entity_store* entities = &world->entities;
+    float bird_x = entities->pos_x[WORLD_BIRD];
+    float bird_y = entities->pos_y[WORLD_BIRD];
+
+    // pipes are spawned in top/bottom pairs, in order of x
+    float target = 0.0f;
+    for (long i = 1; i + 1 < entities->count; i++) {
+        if (entities->sprite[i] != SPRITE_PIPE_TOP || entities->sprite[i + 1] != SPRITE_PIPE_BOT) continue;
+        if (entities->pos_x[i] + PIPE_WIDTH <= bird_x) continue;  // already cleared
+
+        float top = entities->pos_y[i] - entities->size_y[i] / 2.0f;
+        float bottom = entities->pos_y[i + 1] + entities->size_y[i + 1] / 2.0f;
+        target = (top + bottom) / 2.0f;
+        break;
+    }
+
+    return bird_y < target - 0.5f && entities->vel_y[WORLD_BIRD] <= 0.0f;
+}
+
+struct demo*
+demo_create(struct course* course, unsigned int seed)
+{
+    struct demo* demo = calloc(1, sizeof(*demo));
+    if (demo == NULL) {
+        fprintf(stderr, "failed to allocate demo\n");
+        return NULL;
+    }
+
+    demo->particles = particle_pool_create(seed);
+    if (demo->particles == NULL) {
+        free(demo);
+        return NULL;
+    }
+
+    world_init(&demo->world, course, seed);
+    demo->world.running = true;
+    demo->runs = 1;
+    return demo;
+}
+
+void
+demo_destroy(struct demo* demo)
+{
+    if (demo == NULL) return;
+
+    particle_pool_destroy(demo->particles);
+    free(demo);
+}
+
+void
+demo_step(struct demo* demo)
+{
+    assert(demo != NULL);
+
+    struct world* world = &demo->world;
+    for (long t = 0; t < DEMO_TICKS_PER_FRAME; t++) {
+        world_update(world, demo_bot_flap(world), TICK);
+        if (world->dead) {
+            world_reset(world);
+            world->running = true;
+            particle_clear(demo->particles);
+            demo->runs++;
+        }
+    }
+
+    // trail of dust behind the bird
+    const struct entity_store* entities = &world->entities;
+    demo->dust_timer += DEMO_TICKS_PER_FRAME * TICK * DEMO_DUST_RATE;
+    long dust = demo->dust_timer;
+    demo->dust_timer -= dust;
+    particle_emit(demo->particles, entities->pos_x[WORLD_BIRD] - BIRD_WIDTH / 2.0f, entities->pos_y[WORLD_BIRD],
+        dust, 0.5f, 0.5f, 0.1f);
+    particle_update(demo->particles, PARTICLE_GRAVITY, DEMO_TICKS_PER_FRAME * TICK);
+}
@@ -0,0 +1,34 @@
+#ifndef FLAPPY_DEMO_H_INCLUDED
+#define FLAPPY_DEMO_H_INCLUDED
+
+#include "course.h"
+#include "particle.h"
+#include "world.h"
+
+// A run played by a simple bot, stepped one 60 fps video frame at a time:
+// the same seed (and course) always gives the same world and particles.
+// flappy-render draws it with the software backend and flappy --dump-frame
+// with GL, so frames of the two can be compared pixel by pixel.
+
+enum {
+    // simulation ticks per frame
+    DEMO_TICKS_PER_FRAME = 2,
+
+    // particles per second while flying (as in the game)
+    DEMO_DUST_RATE = 60,
+};
+
+struct demo {
+    struct world world;
+    struct particle_pool* particles;
+    float dust_timer;
+    long runs;  // started so far, a new one after every crash
+};
+
+// The course (optional) must outlive the demo.
+struct demo* demo_create(struct course* course, unsigned int seed);
+void demo_destroy(struct demo* demo);
+
+void demo_step(struct demo* demo);
+
+#endif
@@ -0,0 +1,175 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "entity.h"
+
+void
+entity_clear(struct entity_store* store)
+{
+    assert(store != NULL);
+    store->count = 0;
+}
+
+// Copy only the live prefix of every component array (a fraction of the
+// store's full size) so that saving and restoring state stays cheap.
+void
+entity_copy(struct entity_store* dst, const struct entity_store* src)
+{
+    assert(dst != NULL);
+    assert(src != NULL);
+
+    long count = src->count;
+    dst->count = count;
+    memcpy(dst->pos_x, src->pos_x, count * sizeof(src->pos_x[0]));
+    memcpy(dst->pos_y, src->pos_y, count * sizeof(src->pos_y[0]));
+    memcpy(dst->vel_x, src->vel_x, count * sizeof(src->vel_x[0]));
+    memcpy(dst->vel_y, src->vel_y, count * sizeof(src->vel_y[0]));
+    memcpy(dst->gravity, src->gravity, count * sizeof(src->gravity[0]));
+    memcpy(dst->anchor_y, src->anchor_y, count * sizeof(src->anchor_y[0]));
+    memcpy(dst->spring, src->spring, count * sizeof(src->spring[0]));
+    memcpy(dst->collider_w, src->collider_w, count * sizeof(src->collider_w[0]));
+    memcpy(dst->collider_h, src->collider_h, count * sizeof(src->collider_h[0]));
+    memcpy(dst->solid, src->solid, count * sizeof(src->solid[0]));
+    memcpy(dst->sprite, src->sprite, count * sizeof(src->sprite[0]));
+    memcpy(dst->size_x, src->size_x, count * sizeof(src->size_x[0]));
+    memcpy(dst->size_y, src->size_y, count * sizeof(src->size_y[0]));
+    memcpy(dst->spin, src->spin, count * sizeof(src->spin[0]));
+    memcpy(dst->layer, src->layer, count * sizeof(src->layer[0]));
+}
+
+long
+entity_spawn(struct entity_store* store, const struct entity_desc* desc)
+{
+    assert(store != NULL);
+    assert(desc != NULL);
+
+    if (store->count >= ENTITY_CAPACITY) {
+        fprintf(stderr, "entity store is full: %d\n", ENTITY_CAPACITY);
+        return -1;
+    }
+
+    long i = store->count++;
+    store->pos_x[i] = desc->pos_x;
+    store->pos_y[i] = desc->pos_y;
+    store->vel_x[i] = desc->vel_x;
+    store->vel_y[i] = desc->vel_y;
+    store->gravity[i] = desc->gravity;
+    store->anchor_y[i] = desc->anchor_y;
+    store->spring[i] = desc->spring;
+    store->collider_w[i] = desc->collider_w;
+    store->collider_h[i] = desc->collider_h;
+    store->solid[i] = desc->solid ? 1 : 0;
+    store->sprite[i] = desc->sprite;
+    store->size_x[i] = desc->size_x;
+    store->size_y[i] = desc->size_y;
+    store->spin[i] = desc->spin;
+    store->layer[i] = desc->layer;
+    return i;
+}
+
+// Velocities and positions are integrated in two passes, so that the world
+// can override a velocity (a flap) in between.
+void
+entity_accelerate(struct entity_store* store, float delta)
+{
+    assert(store != NULL);
+
+    long count = store->count;
+    for (long i = 0; i < count; i++) {
+        float spring = store->spring[i] * (store->pos_y[i] - store->anchor_y[i]);
+        store->vel_y[i] -= (store->gravity[i] + spring) * delta;
+    }
+}
+
+void
+entity_move(struct entity_store* store, float delta)
+{
+    assert(store != NULL);
+
+    long count = store->count;
+    for (long i = 0; i < count; i++) {
+        store->pos_x[i] += store->vel_x[i] * delta;
+        store->pos_y[i] += store->vel_y[i] * delta;
+    }
+}
+
+// Same test as physics_intersect_circle_rect but written without branches
+// (clamp via fminf / fmaxf, compare squared distances) so that the loop
+// vectorizes. Returns the number of solid entities touching the circle.
+long
+entity_collide(const struct entity_store* store, float cx, float cy, float cr)
+{
+    assert(store != NULL);
+
+    long hits = 0;
+    long count = store->count;
+    for (long i = 0; i < count; i++) {
+        float half_w = store->collider_w[i] / 2.0f;
+        float half_h = store->collider_h[i] / 2.0f;
+        float test_x = fminf(fmaxf(cx, store->pos_x[i] - half_w), store->pos_x[i] + half_w);
+        float test_y = fminf(fmaxf(cy, store->pos_y[i] - half_h), store->pos_y[i] + half_h);
+
+        float dist_x = cx - test_x;
+        float dist_y = cy - test_y;
+        int touching = (dist_x * dist_x) + (dist_y * dist_y) <= cr * cr;
+        hits += touching & store->solid[i];
+    }
+
+    return hits;
+}
+
+// Drop every entity whose right edge is behind min_x. Compaction is stable so
+// entities spawned first (the birds) keep their indices.
+long
+entity_cull(struct entity_store* store, float min_x)
+{
+    assert(store != NULL);
+
+    long count = store->count;
+    long keep = 0;
+    for (long i = 0; i < count; i++) {
+        store->pos_x[keep] = store->pos_x[i];
+        store->pos_y[keep] = store->pos_y[i];
+        store->vel_x[keep] = store->vel_x[i];
+        store->vel_y[keep] = store->vel_y[i];
+        store->gravity[keep] = store->gravity[i];
+        store->anchor_y[keep] = store->anchor_y[i];
+        store->spring[keep] = store->spring[i];
+        store->collider_w[keep] = store->collider_w[i];
+        store->collider_h[keep] = store->collider_h[i];
+        store->solid[keep] = store->solid[i];
+        store->sprite[keep] = store->sprite[i];
+        store->size_x[keep] = store->size_x[i];
+        store->size_y[keep] = store->size_y[i];
+        store->spin[keep] = store->spin[i];
+        store->layer[keep] = store->layer[i];
+        keep += store->pos_x[i] + store->size_x[i] / 2.0f >= min_x;
+    }
+
+    store->count = keep;
+    return count - keep;
+}
+
+long
+entity_emit(const struct entity_store* store, float camera, struct entity_instance* instances, long capacity)
+{
+    assert(store != NULL);
+    assert(instances != NULL);
+
+    long count = store->count < capacity ? store->count : capacity;
+    for (long i = 0; i < count; i++) {
+        instances[i].x = store->pos_x[i] - camera;
+        instances[i].y = store->pos_y[i];
+        instances[i].z = store->layer[i];
+        instances[i].r = store->vel_y[i] * store->spin[i];
+        instances[i].sx = store->size_x[i];
+        instances[i].sy = store->size_y[i];
+        instances[i].sprite = store->sprite[i];
+    }
+
+    return count;
+}
@@ -0,0 +1,90 @@
+#ifndef FLAPPY_ENTITY_H_INCLUDED
+#define FLAPPY_ENTITY_H_INCLUDED
+
+#include <stdbool.h>
+
+// Structure-of-arrays storage for game objects. Every kind of object (birds,
+// pipes, and whatever comes next) is described purely by its component values
+// so that the system passes below can walk each array linearly without ever
+// branching on what "type" an entity is.
+
+enum {
+    ENTITY_CAPACITY = 1024,
+};
+
+enum sprite {
+    SPRITE_NONE = 0,
+    SPRITE_BIRD,
+    SPRITE_PIPE_TOP,
+    SPRITE_PIPE_BOT,
+    SPRITE_COUNT,
+};
+
+struct entity_store {
+    long count;
+
+    // position and velocity (world units)
+    float pos_x[ENTITY_CAPACITY];
+    float pos_y[ENTITY_CAPACITY];
+    float vel_x[ENTITY_CAPACITY];
+    float vel_y[ENTITY_CAPACITY];
+    float gravity[ENTITY_CAPACITY];
+
+    // spring pulling pos_y back towards anchor_y (0.0 for no motion)
+    float anchor_y[ENTITY_CAPACITY];
+    float spring[ENTITY_CAPACITY];
+
+    // rect collider centered on the position (solid is 0 or 1)
+    float collider_w[ENTITY_CAPACITY];
+    float collider_h[ENTITY_CAPACITY];
+    unsigned char solid[ENTITY_CAPACITY];
+
+    // sprite, draw size, and degrees of rotation per unit of vertical velocity
+    unsigned char sprite[ENTITY_CAPACITY];
+    float size_x[ENTITY_CAPACITY];
+    float size_y[ENTITY_CAPACITY];
+    float spin[ENTITY_CAPACITY];
+
+    // depth layer
+    float layer[ENTITY_CAPACITY];
+};
+
+struct entity_desc {
+    float pos_x;
+    float pos_y;
+    float vel_x;
+    float vel_y;
+    float gravity;
+    float anchor_y;
+    float spring;
+    float collider_w;
+    float collider_h;
+    bool solid;
+    int sprite;
+    float size_x;
+    float size_y;
+    float spin;
+    float layer;
+};
+
+struct entity_instance {
+    float x;
+    float y;
+    float z;
+    float r;
+    float sx;
+    float sy;
+    int sprite;
+};
+
+void entity_clear(struct entity_store* store);
+void entity_copy(struct entity_store* dst, const struct entity_store* src);
+long entity_spawn(struct entity_store* store, const struct entity_desc* desc);
+
+void entity_accelerate(struct entity_store* store, float delta);
+void entity_move(struct entity_store* store, float delta);
+long entity_collide(const struct entity_store* store, float cx, float cy, float cr);
+long entity_cull(struct entity_store* store, float min_x);
+long entity_emit(const struct entity_store* store, float camera, struct entity_instance* instances, long capacity);
+
+#endif
@@ -0,0 +1,491 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "config.h"
+#include "course.h"
+#include "entity.h"
+#include "env.h"
+#include "trajectory.h"
+#include "world.h"
+
+enum {
+    ENV_ALIGN = 64,  // keep every array on its own cache lines
+
+    // busy-wait this many times before sleeping on the futex
+    ENV_SPIN = 4096,
+};
+
+struct env_worker {
+    struct env* env;
+    long first;
+    long last;
+    pthread_t thread;
+    bool started;
+};
+
+// stand-in for pipes beyond the end of a course: far away and wide open
+static const float ENV_FAR = 100.0f;
+static const float ENV_OPEN = 9.0f;
+
+static uint32_t
+env_load(const uint32_t* word)
+{
+    return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+}
+
+static void
+env_store(uint32_t* word, uint32_t value)
+{
+    __atomic_store_n(word, value, __ATOMIC_RELEASE);
+}
+
+static void
+env_pause(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#endif
+}
+
+// Wait until *word no longer holds `value` (or shutdown is requested). Steps
+// are short, so spin first; then sleep, waking up now and then in case the
+// other side has gone away.
+static void
+env_wait(uint32_t* word, uint32_t value, const uint32_t* shutdown)
+{
+    for (long i = 0; i < ENV_SPIN; i++) {
+        if (env_load(word) != value) return;
+        env_pause();
+    }
+
+    while (env_load(word) == value && !env_load(shutdown)) {
+#if defined(__linux__)
+        struct timespec timeout = { 0, 100 * 1000 * 1000 };
+        syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0);
+#else
+        sched_yield();
+#endif
+    }
+}
+
+static void
+env_wake(uint32_t* word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+static uint64_t
+env_align(uint64_t offset)
+{
+    return (offset + ENV_ALIGN - 1) & ~(uint64_t)(ENV_ALIGN - 1);
+}
+
+static void
+env_bind(struct env* env)
+{
+    unsigned char* bytes = env->region;
+    env->header = env->region;
+    env->actions = bytes + env->header->actions_offset;
+    env->observations = (float*)(bytes + env->header->observations_offset);
+    env->rewards = (float*)(bytes + env->header->rewards_offset);
+    env->dones = bytes + env->header->dones_offset;
+}
+
+// Start a new episode that is already under way (no waiting for a flap).
+static void
+env_reset_world(struct world* world)
+{
+    world_reset(world);
+    world->running = true;
+}
+
+static void
+env_observe(const struct world* world, float* observation)
+{
+    const struct entity_store* entities = &world->entities;
+    float bird_x = entities->pos_x[WORLD_BIRD];
+    float bird_y = entities->pos_y[WORLD_BIRD];
+
+    observation[0] = bird_y;
+    observation[1] = entities->vel_y[WORLD_BIRD];
+
+    // pipes are spawned in top/bottom pairs, in order of x
+    long seen = 0;
+    for (long i = 1; i + 1 < entities->count && seen < ENV_PIPES_OBSERVED; i++) {
+        if (entities->sprite[i] != SPRITE_PIPE_TOP || entities->sprite[i + 1] != SPRITE_PIPE_BOT) continue;
+        if (entities->pos_x[i] + PIPE_WIDTH <= bird_x) continue;  // already cleared
+
+        float top = entities->pos_y[i];
+        float bot = entities->pos_y[i + 1];
+        float* pipe = &observation[2 + 3 * seen];
+        pipe[0] = entities->pos_x[i] - bird_x;
+        pipe[1] = (top + bot) / 2.0f - bird_y;
+        pipe[2] = top - bot - PIPE_HEIGHT;
+        seen++;
+        i++;
+    }
+
+    for (; seen < ENV_PIPES_OBSERVED; seen++) {
+        float* pipe = &observation[2 + 3 * seen];
+        pipe[0] = ENV_FAR;
+        pipe[1] = 0.0f;
+        pipe[2] = ENV_OPEN;
+    }
+}
+
+static void
+env_step_range(struct env* env, long first, long last)
+{
+    for (long i = first; i < last; i++) {
+        struct world* world = &env->worlds[i];
+
+        long score = world->score;
+        world_update(world, env->actions[i] != 0, TICK);
+
+        float reward = (world->score - score) * ENV_REWARD_PIPE;
+        bool done = world->dead;
+
+        // logged before a crashed world is replaced by its next run
+        if (env->records != NULL) {
+            trajectory_record_world(&env->records[i], world, env->runs[i], env->actions[i] != 0);
+        }
+
+        if (done) {
+            reward += ENV_REWARD_DEATH;
+            env_reset_world(world);
+        }
+
+        env->rewards[i] = reward;
+        env->dones[i] = done;
+        env_observe(world, &env->observations[i * ENV_OBSERVATION_SIZE]);
+    }
+}
+
+static void*
+env_worker_run(void* arg)
+{
+    struct env_worker* worker = arg;
+    struct env* env = worker->env;
+
+    uint32_t generation = 0;
+    for (;;) {
+        env_wait(&env->generation, generation, &env->stop);
+        if (env_load(&env->stop)) return NULL;
+        generation = env_load(&env->generation);
+
+        env_step_range(env, worker->first, worker->last);
+        __atomic_add_fetch(&env->finished, 1, __ATOMIC_ACQ_REL);
+        env_wake(&env->finished);
+    }
+}
+
+// Create (replacing any stale one) and initialize the shared region, then
+// publish the first observation of every environment.
+struct env*
+env_create(const char* name, long count, long threads, struct course* course, unsigned int seed)
+{
+    assert(name != NULL);
+
+    if (name[0] != '/' || strlen(name) >= ENV_NAME_SIZE) {
+        fprintf(stderr, "invalid shared memory name (expected /name): %s\n", name);
+        return NULL;
+    }
+    if (count <= 0 || count > UINT32_MAX) {
+        fprintf(stderr, "invalid environment count: %ld\n", count);
+        return NULL;
+    }
+
+    struct env* env = calloc(1, sizeof(*env));
+    if (env == NULL) {
+        fprintf(stderr, "failed to allocate env\n");
+        return NULL;
+    }
+    strcpy(env->name, name);
+    env->count = count;
+    env->threads = threads < 1 ? 1 : threads > count ? count : threads;
+
+    env->worlds = calloc(count, sizeof(*env->worlds));
+    env->workers = calloc(env->threads, sizeof(*env->workers));
+    if (env->worlds == NULL || env->workers == NULL) {
+        fprintf(stderr, "failed to allocate %ld worlds\n", count);
+        env_close(env);
+        return NULL;
+    }
+
+    struct env_header header = { 0 };
+    memcpy(header.magic, ENV_MAGIC, sizeof(header.magic));
+    header.version = ENV_VERSION;
+    header.count = count;
+    header.observation_size = ENV_OBSERVATION_SIZE;
+    header.actions_offset = env_align(sizeof(header));
+    header.observations_offset = env_align(header.actions_offset + count);
+    header.rewards_offset = env_align(header.observations_offset + count * ENV_OBSERVATION_SIZE * sizeof(float));
+    header.dones_offset = env_align(header.rewards_offset + count * sizeof(float));
+    header.size = env_align(header.dones_offset + count);
+
+    // a region left behind by a crashed server is simply replaced
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        fprintf(stderr, "failed to create shared memory: %s: %s\n", name, strerror(errno));
+        env_close(env);
+        return NULL;
+    }
+    env->owner = true;
+
+    if (ftruncate(fd, header.size) != 0) {
+        fprintf(stderr, "failed to size shared memory: %s\n", name);
+        close(fd);
+        env_close(env);
+        return NULL;
+    }
+
+    env->region = mmap(NULL, header.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (env->region == MAP_FAILED) {
+        fprintf(stderr, "failed to map shared memory: %s\n", name);
+        env->region = NULL;
+        env_close(env);
+        return NULL;
+    }
+    env->size = header.size;
+
+    memcpy(env->region, &header, sizeof(header));
+    env_bind(env);
+
+    for (long i = 0; i < count; i++) {
+        world_init(&env->worlds[i], course, seed + i);
+        env->worlds[i].running = true;
+        env_observe(&env->worlds[i], &env->observations[i * ENV_OBSERVATION_SIZE]);
+    }
+
+    // contiguous slices so that each thread streams through its own worlds
+    for (long t = 0; t < env->threads; t++) {
+        struct env_worker* worker = &env->workers[t];
+        worker->env = env;
+        worker->first = count * t / env->threads;
+        worker->last = count * (t + 1) / env->threads;
+        if (t == 0) continue;
+
+        if (pthread_create(&worker->thread, NULL, env_worker_run, worker) != 0) {
+            fprintf(stderr, "failed to start env worker thread\n");
+            env_close(env);
+            return NULL;
+        }
+        worker->started = true;
+    }
+
+    return env;
+}
+
+struct env*
+env_attach(const char* name)
+{
+    assert(name != NULL);
+
+    if (strlen(name) >= ENV_NAME_SIZE) {
+        fprintf(stderr, "invalid shared memory name: %s\n", name);
+        return NULL;
+    }
+
+    struct env* env = calloc(1, sizeof(*env));
+    if (env == NULL) {
+        fprintf(stderr, "failed to allocate env\n");
+        return NULL;
+    }
+    strcpy(env->name, name);
+
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd == -1) {
+        fprintf(stderr, "failed to open shared memory: %s: %s\n", name, strerror(errno));
+        free(env);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct env_header)) {
+        fprintf(stderr, "shared memory is too small: %s\n", name);
+        close(fd);
+        free(env);
+        return NULL;
+    }
+
+    env->region = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (env->region == MAP_FAILED) {
+        fprintf(stderr, "failed to map shared memory: %s\n", name);
+        free(env);
+        return NULL;
+    }
+    env->size = st.st_size;
+
+    const struct env_header* header = env->region;
+    if (memcmp(header->magic, ENV_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ENV_VERSION ||
+        header->observation_size != ENV_OBSERVATION_SIZE ||
+        header->size > env->size) {
+        fprintf(stderr, "shared memory is not a flappy-env region (or a different version): %s\n", name);
+        munmap(env->region, env->size);
+        free(env);
+        return NULL;
+    }
+
+    env_bind(env);
+    env->count = header->count;
+    return env;
+}
+
+void
+env_close(struct env* env)
+{
+    if (env == NULL) return;
+
+    if (env->workers != NULL) {
+        env_store(&env->stop, 1);
+        env_wake(&env->generation);
+        for (long t = 0; t < env->threads; t++) {
+            if (env->workers[t].started) pthread_join(env->workers[t].thread, NULL);
+        }
+    }
+
+    if (env->region != NULL) munmap(env->region, env->size);
+    if (env->owner) shm_unlink(env->name);
+    free(env->workers);
+    free(env->worlds);
+    free(env->records);
+    free(env->runs);
+    free(env);
+}
+
+// Log every environment step to `trajectory` from now on (see trajectory.h).
+// Runs are numbered in the order they start, the first `count` in order of
+// environment.
+bool
+env_record(struct env* env, struct trajectory* trajectory)
+{
+    assert(env != NULL);
+    assert(env->worlds != NULL);
+    assert(trajectory != NULL);
+
+    env->records = calloc(env->count, sizeof(*env->records));
+    env->runs = calloc(env->count, sizeof(*env->runs));
+    if (env->records == NULL || env->runs == NULL) {
+        fprintf(stderr, "failed to allocate %ld trajectory records\n", env->count);
+        free(env->records);
+        free(env->runs);
+        env->records = NULL;
+        env->runs = NULL;
+        return false;
+    }
+
+    for (long i = 0; i < env->count; i++) {
+        env->runs[i] = i;
+    }
+    env->next_run = env->count;
+    env->trajectory = trajectory;
+    return true;
+}
+
+// Append the rows of the step that just finished. This stays on the calling
+// thread so that rows come out in the same order however many workers step.
+static void
+env_append(struct env* env)
+{
+    for (long i = 0; i < env->count; i++) {
+        trajectory_append(env->trajectory, &env->records[i]);
+        if (env->dones[i]) env->runs[i] = env->next_run++;
+    }
+}
+
+// Step every environment once (fixed tick) with the current actions, and
+// restart the ones that died. Worker 0 is the calling thread.
+void
+env_step(struct env* env)
+{
+    assert(env != NULL);
+    assert(env->worlds != NULL);
+
+    if (env->threads <= 1) {
+        env_step_range(env, 0, env->count);
+        if (env->records != NULL) env_append(env);
+        return;
+    }
+
+    env_store(&env->finished, 0);
+    env_store(&env->generation, env->generation + 1);
+    env_wake(&env->generation);
+
+    env_step_range(env, env->workers[0].first, env->workers[0].last);
+
+    uint32_t finished;
+    while ((finished = env_load(&env->finished)) < env->threads - 1) {
+        env_wait(&env->finished, finished, &env->stop);
+    }
+    if (env->records != NULL) env_append(env);
+}
+
+// Serve one step request. Returns false once shutdown has been requested.
+bool
+env_serve(struct env* env)
+{
+    assert(env != NULL);
+
+    struct env_header* header = env->header;
+    uint32_t response = header->response;
+    env_wait(&header->request, response, &header->shutdown);
+    if (env_load(&header->shutdown)) return false;
+
+    env_step(env);
+
+    env_store(&header->response, env_load(&header->request));
+    env_wake(&header->response);
+    return true;
+}
+
+void
+env_shutdown(struct env* env)
+{
+    assert(env != NULL);
+
+    env_store(&env->header->shutdown, 1);
+    env_wake(&env->header->request);
+    env_wake(&env->header->response);
+}
+
+// Client side: publish the actions already written to env->actions and wait
+// for the results.
+void
+env_request(struct env* env)
+{
+    assert(env != NULL);
+
+    struct env_header* header = env->header;
+    uint32_t request = header->request + 1;
+    env_store(&header->request, request);
+    env_wake(&header->request);
+    env_wait(&header->response, request - 1, &header->shutdown);
+}
@@ -0,0 +1,108 @@
+#ifndef FLAPPY_ENV_H_INCLUDED
+#define FLAPPY_ENV_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "course.h"
+#include "trajectory.h"
+#include "world.h"
+
+// Vectorized training environment: N worlds stepped together, exchanging
+// actions and observations with another process through a POSIX
+// shared-memory region (no copies, no sockets).
+//
+// Region layout (offsets in the header, every array 64-byte aligned):
+//
+//   header        struct env_header
+//   actions       uint8_t[count]       written by the client, 1 to flap
+//   observations  float[count][ENV_OBSERVATION_SIZE]
+//   rewards       float[count]         for the last step
+//   dones         uint8_t[count]       episode ended (and was reset)
+//
+// Step protocol: the client writes actions and increments `request`; the
+// server steps every world and then stores `response = request`. Both words
+// are futexes on Linux (spin then sleep) and are spun on elsewhere.
+//
+// Observation (all relative to the bird, in world units):
+//
+//   [0] bird height  [1] bird vertical velocity
+//   then for each of the next ENV_PIPES_OBSERVED pipes not yet cleared:
+//   [+0] horizontal distance  [+1] gap center (relative)  [+2] gap height
+
+enum {
+    ENV_VERSION = 1,
+    ENV_PIPES_OBSERVED = 2,
+    ENV_OBSERVATION_SIZE = 2 + 3 * ENV_PIPES_OBSERVED,
+    ENV_NAME_SIZE = 256,
+};
+
+static const char ENV_MAGIC[4] = { 'F', 'L', 'P', 'E' };
+
+// rewards
+static const float ENV_REWARD_PIPE = 1.0f;    // per pipe cleared
+static const float ENV_REWARD_DEATH = -1.0f;
+
+struct env_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t observation_size;
+    uint64_t size;
+    uint64_t actions_offset;
+    uint64_t observations_offset;
+    uint64_t rewards_offset;
+    uint64_t dones_offset;
+
+    // step handshake (see above)
+    uint32_t request;
+    uint32_t response;
+    uint32_t shutdown;
+    uint32_t reserved;
+};
+
+struct env_worker;
+
+struct env {
+    char name[ENV_NAME_SIZE];
+    bool owner;  // created the region (and unlinks it on close)
+
+    void* region;
+    size_t size;
+    struct env_header* header;
+    uint8_t* actions;
+    float* observations;
+    float* rewards;
+    uint8_t* dones;
+
+    long count;
+
+    // server side only: the worlds, split across worker threads
+    struct world* worlds;
+    long threads;
+    struct env_worker* workers;
+    uint32_t generation;  // bumped to start a step
+    uint32_t finished;    // workers done with the current step
+    uint32_t stop;
+
+    // server side only, optional: per-step logging (see env_record)
+    struct trajectory* trajectory;
+    struct trajectory_record* records;
+    uint32_t* runs;
+    uint32_t next_run;
+};
+
+struct env* env_create(const char* name, long count, long threads, struct course* course, unsigned int seed);
+struct env* env_attach(const char* name);
+void env_close(struct env* env);
+
+bool env_record(struct env* env, struct trajectory* trajectory);
+
+void env_step(struct env* env);
+bool env_serve(struct env* env);
+void env_shutdown(struct env* env);
+
+void env_request(struct env* env);
+
+#endif
@@ -0,0 +1,121 @@
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "course.h"
+#include "env.h"
+#include "trajectory.h"
+
+// Headless training server: hosts N worlds in a shared-memory region that an
+// external process steps (see env.h and scripts/env_client.py).
+
+static struct env* server;
+
+static void
+handle_signal(int sig)
+{
+    (void)sig;
+    if (server != NULL) env_shutdown(server);
+}
+
+static void
+print_usage(const char* arg0)
+{
+    printf("usage: %s [options]\n", arg0);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -h --help         print this help\n");
+    printf("  -n --envs N       number of environments (default: 64)\n");
+    printf("  -t --threads N    threads stepping the environments (default: 1)\n");
+    printf("  -m --name NAME    shared memory name (default: /flappy-env)\n");
+    printf("  -c --course FILE  play a course file\n");
+    printf("  --seed SEED       seed of the first environment (default: random)\n");
+    printf("  --trajectory FILE log every environment step (see scripts/trajectory.py)\n");
+}
+
+int
+main(int argc, char* argv[])
+{
+    long count = 64;
+    long threads = 1;
+    const char* name = "/flappy-env";
+    const char* course_path = NULL;
+    unsigned int seed = time(NULL);
+    const char* trajectory_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--envs") == 0) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) {
+            threads = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--name") == 0) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--course") == 0) {
+            course_path = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--trajectory") == 0) {
+            trajectory_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct course course = { 0 };
+    if (course_path != NULL && !course_open(&course, course_path)) {
+        return EXIT_FAILURE;
+    }
+
+    server = env_create(name, count, threads, course_path != NULL ? &course : NULL, seed);
+    if (server == NULL) {
+        course_close(&course);
+        return EXIT_FAILURE;
+    }
+
+    struct trajectory* trajectory = NULL;
+    if (trajectory_path != NULL) {
+        trajectory = trajectory_create(trajectory_path, count);
+        if (trajectory == NULL || !env_record(server, trajectory)) {
+            trajectory_close(trajectory, NULL);
+            env_close(server);
+            course_close(&course);
+            return EXIT_FAILURE;
+        }
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    printf("flappy-env: serving %ld environments at %s\n", count, name);
+
+    long steps = 0;
+    while (env_serve(server)) {
+        steps++;
+    }
+
+    printf("flappy-env: %ld steps (%ld environment steps)\n", steps, steps * count);
+
+    int status = EXIT_SUCCESS;
+    if (trajectory != NULL) {
+        struct trajectory_stats stats;
+        if (!trajectory_close(trajectory, &stats)) status = EXIT_FAILURE;
+        printf("flappy-env: %ld trajectory rows in %ld chunks, %.1f bytes per row (%.1f raw), %ld stalls\n",
+            stats.rows, stats.chunks, stats.rows > 0 ? (double)stats.bytes / stats.rows : 0.0,
+            stats.rows > 0 ? (double)stats.raw_bytes / stats.rows : 0.0, stats.stalls);
+    }
+
+    env_close(server);
+    course_close(&course);
+    return status;
+}
@@ -0,0 +1,193 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "course.h"
+#include "reach.h"
+#include "world.h"
+
+// Reachability tables (see reach.h): generate and save one, let the table
+// bot play, and check that seeded (or course) pipe sequences are solvable.
+
+enum {
+    PLAY_MAX_TICKS = 10 * 60 * 120,  // ten minutes of play per run at most
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+print_usage(const char* arg0)
+{
+    printf("usage: %s [options]\n", arg0);
+    printf("\n");
+    printf("Generates a table unless one is given with --table.\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -h --help          print this help\n");
+    printf("  -o --output FILE   save the table\n");
+    printf("  -r --table FILE    use a saved table\n");
+    printf("  -t --threads N     threads generating the table (default: 1)\n");
+    printf("  -c --course FILE   play a course file\n");
+    printf("  --seed SEED        seed of the first run (default: 0)\n");
+    printf("  --runs N           runs, one seed after another (default: 1)\n");
+    printf("  --play             let the table bot play every run until it crashes\n");
+    printf("  --validate PIPES   search flaps past the first PIPES obstacles of every run\n");
+    printf("  --brute            validate by brute force instead of with the table\n");
+    printf("  --budget N         states a validation may look at (default: 10000000)\n");
+}
+
+static const char*
+result_name(int result)
+{
+    switch (result) {
+    case REACH_SOLVED: return "solved";
+    case REACH_UNSOLVABLE: return "unsolvable";
+    case REACH_UNKNOWN: return "unknown";
+    default: return "unsupported";
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    const char* output = NULL;
+    const char* table = NULL;
+    long threads = 1;
+    const char* course_path = NULL;
+    unsigned int seed = 0;
+    long runs = 1;
+    bool play = false;
+    long pipes = 0;
+    bool brute = false;
+    long budget = 10000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (strcmp(argv[i], "--play") == 0) {
+            play = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--brute") == 0) {
+            brute = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--table") == 0) {
+            table = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) {
+            threads = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--course") == 0) {
+            course_path = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--runs") == 0) {
+            runs = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--validate") == 0) {
+            pipes = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--budget") == 0) {
+            budget = atol(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (runs < 1 || pipes < 0 || budget < 1) {
+        fprintf(stderr, "runs and budget must be at least 1 and pipes at least 0\n");
+        return EXIT_FAILURE;
+    }
+
+    // brute force validation is the only thing that needs no table
+    struct reach reach = { 0 };
+    bool need_table = output != NULL || play || (pipes > 0 && !brute);
+    if (table != NULL) {
+        if (!reach_open(&reach, table)) return EXIT_FAILURE;
+    } else if (need_table) {
+        double start = now();
+        if (!reach_generate(&reach, threads)) return EXIT_FAILURE;
+        printf("flappy-reach: generated %zu bytes in %.2f s\n", reach.size, now() - start);
+    }
+    if (output != NULL && !reach_save(&reach, output)) {
+        reach_close(&reach);
+        return EXIT_FAILURE;
+    }
+
+    struct course course = { 0 };
+    if (course_path != NULL && !course_open(&course, course_path)) {
+        reach_close(&reach);
+        return EXIT_FAILURE;
+    }
+
+    struct world* world = malloc(sizeof(*world));
+    if (world == NULL) {
+        fprintf(stderr, "failed to allocate world\n");
+        course_close(&course);
+        reach_close(&reach);
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    if (play) {
+        long total = 0;
+        long best = 0;
+        long ticks = 0;
+        double start = now();
+        for (long r = 0; r < runs; r++) {
+            world_init(world, course_path != NULL ? &course : NULL, seed + r);
+            for (long t = 0; t < PLAY_MAX_TICKS && !world->dead; t++) {
+                world_update(world, reach_bot(&reach, world), TICK);
+                ticks++;
+            }
+            total += world->score;
+            if (world->score > best) best = world->score;
+        }
+        double elapsed = now() - start;
+        printf("flappy-reach: played %ld runs, mean score %.1f, best %ld, %.1f ns per tick\n",
+            runs, (double)total / runs, best, ticks > 0 ? elapsed * 1e9 / ticks : 0.0);
+    }
+
+    if (pipes > 0) {
+        long counts[REACH_UNSUPPORTED + 1] = { 0 };
+        long visited = 0;
+        double start = now();
+        for (long r = 0; r < runs; r++) {
+            world_init(world, course_path != NULL ? &course : NULL, seed + r);
+            struct reach_solution solution;
+            int result = reach_validate(brute ? NULL : &reach, world, pipes, budget, &solution);
+            counts[result]++;
+            visited += solution.visited;
+            printf("seed %u: %s", seed + (unsigned int)r, result_name(result));
+            if (result == REACH_SOLVED) printf(" in %ld ticks with %ld flaps", solution.ticks, solution.flaps);
+            printf(" (%ld states)\n", solution.visited);
+        }
+        double elapsed = now() - start;
+        printf("flappy-reach: %ld solved, %ld unsolvable, %ld unknown, %ld unsupported, %.2f ms per run\n",
+            counts[REACH_SOLVED], counts[REACH_UNSOLVABLE], counts[REACH_UNKNOWN], counts[REACH_UNSUPPORTED],
+            elapsed * 1e3 / runs);
+        if (counts[REACH_SOLVED] < runs) status = EXIT_FAILURE;
+    }
+
+    free(world);
+    course_close(&course);
+    reach_close(&reach);
+    return status;
+}
@@ -0,0 +1,146 @@
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "course.h"
+#include "demo.h"
+#include "image.h"
+#include "render.h"
+#include "softrender.h"
+#include "world.h"
+
+// generated resource headers
+#include "textures/bg.h"
+#include "textures/bird.h"
+#include "textures/pipe_bot.h"
+#include "textures/pipe_top.h"
+
+// Headless renderer: plays a run with a simple bot (see demo.h) and draws it
+// with the software backend (no window, no GL), optionally writing every
+// frame out as a PPM image. Prints how fast frames were rendered.
+
+enum {
+    FRAME_ARENA_SIZE = 256 * 1024,
+};
+
+static double
+now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+print_usage(const char* arg0)
+{
+    printf("usage: %s [options]\n", arg0);
+    printf("\n");
+    printf("Options:\n");
+    printf("  -h --help        print this help\n");
+    printf("  -W --width N     framebuffer width (default: 256)\n");
+    printf("  -H --height N    framebuffer height (default: 144)\n");
+    printf("  -n --frames N    frames to render (default: 600)\n");
+    printf("  -t --threads N   rendering threads (default: one per CPU)\n");
+    printf("  -o --output DIR  write frames to DIR/frame_NNNNN.ppm\n");
+    printf("  -c --course FILE play a course file\n");
+    printf("  --seed SEED      world seed (default: random)\n");
+}
+
+int
+main(int argc, char* argv[])
+{
+    long width = 256;
+    long height = 144;
+    long frames = 600;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* output = NULL;
+    const char* course_path = NULL;
+    unsigned int seed = time(NULL);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (strcmp(argv[i], "-W") == 0 || strcmp(argv[i], "--width") == 0) {
+            width = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-H") == 0 || strcmp(argv[i], "--height") == 0) {
+            height = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--frames") == 0) {
+            frames = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) {
+            threads = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--course") == 0) {
+            course_path = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct course course = { 0 };
+    if (course_path != NULL && !course_open(&course, course_path)) {
+        return EXIT_FAILURE;
+    }
+
+    struct softrender* sr = softrender_create(threads);
+    struct demo* demo = demo_create(course_path != NULL ? &course : NULL, seed);
+    struct arena frame = { 0 };
+    bool ok = sr != NULL && demo != NULL && arena_init(&frame, FRAME_ARENA_SIZE);
+    ok = ok && softrender_resize(sr, width, height);
+    ok = ok && softrender_texture(sr, RENDER_TEXTURE_BG, TEXTURE_BG_FORMAT, TEXTURE_BG_WIDTH, TEXTURE_BG_HEIGHT, TEXTURE_BG_PIXELS);
+    ok = ok && softrender_texture(sr, RENDER_TEXTURE_BIRD, TEXTURE_BIRD_FORMAT, TEXTURE_BIRD_WIDTH, TEXTURE_BIRD_HEIGHT, TEXTURE_BIRD_PIXELS);
+    ok = ok && softrender_texture(sr, RENDER_TEXTURE_PIPE_TOP, TEXTURE_PIPE_TOP_FORMAT, TEXTURE_PIPE_TOP_WIDTH, TEXTURE_PIPE_TOP_HEIGHT, TEXTURE_PIPE_TOP_PIXELS);
+    ok = ok && softrender_texture(sr, RENDER_TEXTURE_PIPE_BOT, TEXTURE_PIPE_BOT_FORMAT, TEXTURE_PIPE_BOT_WIDTH, TEXTURE_PIPE_BOT_HEIGHT, TEXTURE_PIPE_BOT_PIXELS);
+    if (!ok) {
+        arena_free(&frame);
+        demo_destroy(demo);
+        softrender_destroy(sr);
+        course_close(&course);
+        return EXIT_FAILURE;
+    }
+
+    double render_time = 0.0;
+    for (long f = 0; f < frames && ok; f++) {
+        demo_step(demo);
+
+        double start = now_seconds();
+        struct render_scene scene;
+        render_scene_build(&scene, &frame, &demo->world, NULL, demo->particles, demo->world.time);
+        ok = softrender_draw(sr, &scene);
+        render_time += now_seconds() - start;
+        arena_reset(&frame);
+
+        if (ok && output != NULL) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s/frame_%05ld.ppm", output, f);
+            ok = image_write_ppm(path, softrender_pixels(sr), width, height);
+        }
+    }
+
+    if (ok && frames > 0) {
+        printf("flappy-render: %ld frames at %ldx%ld (%ld runs): %.3lf ms/frame, %.0lf fps\n",
+            frames, width, height, demo->runs, 1000.0 * render_time / frames, frames / render_time);
+    }
+
+    arena_free(&frame);
+    demo_destroy(demo);
+    softrender_destroy(sr);
+    course_close(&course);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
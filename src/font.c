@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -106,6 +107,18 @@ static const float quads[QUADS_PER_GLYPH][FLOATS_PER_QUAD] = {
     [15] = { -0.25f,  0.50f, -0.50f,  0.50f, -0.50f,  0.25f, -0.25f,  0.50f, -0.50f,  0.25f, -0.25f,  0.25f },
 };
 
+// digits plus the little punctuation needed to print numbers
+static unsigned short
+font_glyph(char c)
+{
+    if (c >= '0' && c <= '9') return font[c - '0'];
+    if (c == '.') return 0x0040;
+    if (c == ' ') return 0x0000;
+
+    assert(false && "unsupported character");
+    return 0x0000;
+}
+
 long
 font_size(const char* str)
 {
@@ -114,10 +127,7 @@ font_size(const char* str)
 
     char c;
     while ((c = *str++) != '\0') {
-        c = c - '0';
-        assert(c >= 0 && c <= 9);
-
-        unsigned short glyph = font[(unsigned char)c];
+        unsigned short glyph = font_glyph(c);
         for (long i = 0; i < 4*4; i++) {
             char quad = (glyph >> i) & 1;
             if (quad) {
@@ -137,10 +147,7 @@ font_vertices(const char* str)
 
     char c;
     while ((c = *str++) != '\0') {
-        c = c - '0';
-        assert(c >= 0 && c <= 9);
-
-        unsigned short glyph = font[(unsigned char)c];
+        unsigned short glyph = font_glyph(c);
         for (long i = 0; i < 4*4; i++) {
             char quad = (glyph >> i) & 1;
             if (!quad) continue;
@@ -164,10 +171,7 @@ font_print(const char* str, float* buffer, long size)
 
     char c;
     while ((c = *str++) != '\0') {
-        c = c - '0';
-        assert(c >= 0 && c <= 9);
-
-        unsigned short glyph = font[(unsigned char)c];
+        unsigned short glyph = font_glyph(c);
         for (long i = 0; i < 4*4; i++) {
             char quad = (glyph >> i) & 1;
             if (!quad) continue;
@@ -181,3 +185,16 @@ font_print(const char* str, float* buffer, long size)
         x += 1;
     }
 }
+
+// Scale and then move vertices written by font_print (size in bytes).
+void
+font_place(float* buffer, long size, float x, float y, float sx, float sy)
+{
+    assert(buffer != NULL);
+
+    long count = size / (FLOATS_PER_VERTEX * sizeof(float));
+    for (long v = 0; v < count; v++) {
+        buffer[v*2 + 0] = buffer[v*2 + 0] * sx + x;
+        buffer[v*2 + 1] = buffer[v*2 + 1] * sy + y;
+    }
+}
@@ -1,8 +1,14 @@
 #ifndef FLAPPY_FONT_H_INCLUDED
 #define FLAPPY_FONT_H_INCLUDED
 
+enum {
+    // bytes font_print writes for the largest glyph (16 quads of 2 triangles)
+    FONT_GLYPH_MAX_SIZE = 16 * 6 * 2 * sizeof(float),
+};
+
 long font_size(const char* str);
 long font_vertices(const char* str);
 void font_print(const char* str, float* buffer, long size);
+void font_place(float* buffer, long size, float x, float y, float sx, float sy);
 
 #endif
@@ -0,0 +1,111 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image.h"
+#include "jpeg.h"
+#include "png.h"
+
+enum {
+    IMAGE_FILE_MAX = 64 * 1024 * 1024,
+};
+
+// Read a whole file into memory (the decoders work on buffers).
+static unsigned char*
+image_read(const char* path, long* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "failed to open image: %s\n", path);
+        return NULL;
+    }
+
+    long length = -1;
+    if (fseek(f, 0, SEEK_END) == 0) length = ftell(f);
+    if (length < 0 || length > IMAGE_FILE_MAX || fseek(f, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "failed to read image: %s\n", path);
+        fclose(f);
+        return NULL;
+    }
+
+    unsigned char* data = malloc(length > 0 ? length : 1);
+    if (data == NULL) {
+        fprintf(stderr, "failed to allocate image: %s\n", path);
+        fclose(f);
+        return NULL;
+    }
+    if (fread(data, 1, length, f) != (size_t)length) {
+        fprintf(stderr, "failed to read image: %s\n", path);
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    *size = length;
+    return data;
+}
+
+bool
+image_load(struct image* image, const char* path)
+{
+    assert(image != NULL);
+    assert(path != NULL);
+
+    memset(image, 0, sizeof(*image));
+
+    long size = 0;
+    unsigned char* data = image_read(path, &size);
+    if (data == NULL) return false;
+
+    // the format is whatever the signature says, not the file extension
+    bool ok = false;
+    if (size >= 8 && memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0) {
+        ok = png_decode(image, data, size, path);
+    } else if (size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff) {
+        ok = jpeg_decode(image, data, size, path);
+    } else {
+        fprintf(stderr, "unsupported image format (expected PNG or JPEG): %s\n", path);
+    }
+
+    free(data);
+    return ok;
+}
+
+void
+image_free(struct image* image)
+{
+    assert(image != NULL);
+
+    free(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
+
+bool
+image_write_ppm(const char* path, const unsigned char* pixels, long width, long height)
+{
+    assert(path != NULL);
+    assert(pixels != NULL);
+
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "failed to open file: %s\n", path);
+        return false;
+    }
+
+    // PPM rows go top to bottom
+    fprintf(f, "P6\n%ld %ld\n255\n", width, height);
+    for (long y = height - 1; y >= 0; y--) {
+        const unsigned char* row = pixels + y * width * 4;
+        for (long x = 0; x < width; x++) {
+            fwrite(row + x * 4, 1, 3, f);
+        }
+    }
+
+    bool ok = ferror(f) == 0;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "failed to write file: %s\n", path);
+    return ok;
+}
@@ -0,0 +1,29 @@
+#ifndef FLAPPY_IMAGE_H_INCLUDED
+#define FLAPPY_IMAGE_H_INCLUDED
+
+#include <stdbool.h>
+
+// Texture images on disk, the PNG and JPEG art under res/textures/ as it
+// is (see png.h and jpeg.h for what each decoder takes). Loading flips rows
+// to bottom first, the layout texture_create and the generated resource
+// headers use, so pixels go to GL as they are.
+
+enum {
+    IMAGE_SIZE_MAX = 16384,  // per side, keeps corrupt headers from huge allocations
+};
+
+struct image {
+    int format;  // enum texture_format
+    long width;
+    long height;
+    unsigned char* pixels;
+};
+
+bool image_load(struct image* image, const char* path);
+void image_free(struct image* image);
+
+// Write RGBA8 pixels, bottom row first (as glReadPixels and the software
+// renderer give them), as a binary PPM with the alpha dropped.
+bool image_write_ppm(const char* path, const unsigned char* pixels, long width, long height);
+
+#endif
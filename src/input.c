@@ -0,0 +1,54 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "input.h"
+
+// The producer only writes tail and the consumer only writes head, so the
+// queue needs no lock: just acquire/release ordering on the two counters.
+#if defined(__GNUC__)
+#define input_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define input_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define input_load(p) (*(volatile unsigned long*)(p))
+#define input_store(p, v) (*(volatile unsigned long*)(p) = (v))
+#endif
+
+void
+input_clear(struct input_queue* queue)
+{
+    assert(queue != NULL);
+    memset(queue, 0, sizeof(*queue));
+}
+
+// Returns false (and counts the event as dropped) when the queue is full.
+bool
+input_push(struct input_queue* queue, const struct input_event* event)
+{
+    assert(queue != NULL);
+    assert(event != NULL);
+
+    unsigned long tail = queue->tail;
+    if (tail - input_load(&queue->head) >= INPUT_QUEUE_SIZE) {
+        queue->dropped++;
+        return false;
+    }
+
+    queue->events[tail & (INPUT_QUEUE_SIZE - 1)] = *event;
+    input_store(&queue->tail, tail + 1);
+    return true;
+}
+
+bool
+input_pop(struct input_queue* queue, struct input_event* event)
+{
+    assert(queue != NULL);
+    assert(event != NULL);
+
+    unsigned long head = queue->head;
+    if (head == input_load(&queue->tail)) return false;
+
+    *event = queue->events[head & (INPUT_QUEUE_SIZE - 1)];
+    input_store(&queue->head, head + 1);
+    return true;
+}
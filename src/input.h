@@ -0,0 +1,37 @@
+#ifndef FLAPPY_INPUT_H_INCLUDED
+#define FLAPPY_INPUT_H_INCLUDED
+
+#include <stdbool.h>
+
+// Lock-free single-producer / single-consumer queue of timestamped input
+// events. The window system pushes events as they arrive (from its key
+// callback) and the game pops them once per frame, so every press keeps
+// the exact time it happened instead of being sampled at the next frame.
+
+enum {
+    INPUT_QUEUE_SIZE = 256,  // power of two
+};
+
+enum input_action {
+    INPUT_RELEASE = 0,
+    INPUT_PRESS,
+};
+
+struct input_event {
+    double time;  // seconds, same clock as the frame loop
+    int key;
+    int action;
+};
+
+struct input_queue {
+    struct input_event events[INPUT_QUEUE_SIZE];
+    unsigned long head;  // next event to pop (written by the consumer)
+    unsigned long tail;  // next free slot (written by the producer)
+    unsigned long dropped;
+};
+
+void input_clear(struct input_queue* queue);
+bool input_push(struct input_queue* queue, const struct input_event* event);
+bool input_pop(struct input_queue* queue, struct input_event* event);
+
+#endif
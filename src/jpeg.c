@@ -0,0 +1,526 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image.h"
+#include "jpeg.h"
+#include "texture.h"
+
+enum {
+    JPEG_MAX_COMPONENTS = 3,
+    JPEG_MAX_SAMPLING = 4,
+    JPEG_MAX_TABLES = 4,
+
+    // codes up to this long are decoded with a single table lookup
+    JPEG_FAST_BITS = 9,
+};
+
+// zigzag position of each coefficient in natural (row major) order
+static const unsigned char JPEG_ZIGZAG[64] = {
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// C(u) / 2 * cos((2x + 1) u pi / 16), the inverse DCT basis by [x][u]
+static const float JPEG_IDCT[8][8] = {
+    { 0.353553391f, 0.490392640f, 0.461939766f, 0.415734806f, 0.353553391f, 0.277785117f, 0.191341716f, 0.097545161f },
+    { 0.353553391f, 0.415734806f, 0.191341716f, -0.097545161f, -0.353553391f, -0.490392640f, -0.461939766f, -0.277785117f },
+    { 0.353553391f, 0.277785117f, -0.191341716f, -0.490392640f, -0.353553391f, 0.097545161f, 0.461939766f, 0.415734806f },
+    { 0.353553391f, 0.097545161f, -0.461939766f, -0.277785117f, 0.353553391f, 0.415734806f, -0.191341716f, -0.490392640f },
+    { 0.353553391f, -0.097545161f, -0.461939766f, 0.277785117f, 0.353553391f, -0.415734806f, -0.191341716f, 0.490392640f },
+    { 0.353553391f, -0.277785117f, -0.191341716f, 0.490392640f, -0.353553391f, -0.097545161f, 0.461939766f, -0.415734806f },
+    { 0.353553391f, -0.415734806f, 0.191341716f, 0.097545161f, -0.353553391f, 0.490392640f, -0.461939766f, 0.277785117f },
+    { 0.353553391f, -0.490392640f, 0.461939766f, -0.415734806f, 0.353553391f, -0.277785117f, 0.191341716f, -0.097545161f },
+};
+
+// Canonical Huffman code (see the DHT segment): values sorted by code
+// length, and a lookup table (value << 4 | length, 0 for longer codes)
+// indexed by the next bits.
+struct jpeg_huffman {
+    bool defined;
+    uint16_t fast[1 << JPEG_FAST_BITS];
+    int32_t maxcode[17];  // largest code of each length, -1 for none
+    int32_t offset[17];   // index of a length's first value minus its first code
+    unsigned char values[256];
+};
+
+struct jpeg_component {
+    int id;
+    int h;  // sampling factors
+    int v;
+    int quant;
+    int dc;  // table indices of the current scan
+    int ac;
+    int pred;
+
+    long stride;
+    unsigned char* plane;  // whole MCUs of samples, top row first
+};
+
+struct jpeg {
+    uint16_t quant[JPEG_MAX_TABLES][64];  // natural order
+    bool quant_defined[JPEG_MAX_TABLES];
+    struct jpeg_huffman dc[JPEG_MAX_TABLES];
+    struct jpeg_huffman ac[JPEG_MAX_TABLES];
+    long restart_interval;
+
+    long width;
+    long height;
+    int hmax;
+    int vmax;
+    long mcus_x;
+    long mcus_y;
+    int count;
+    struct jpeg_component components[JPEG_MAX_COMPONENTS];
+    long scans;
+};
+
+// Entropy coded bits come most significant first, with 0xFF bytes stuffed
+// as 0xFF 0x00. At a marker (or the end) the reader stops and feeds zeros,
+// counting them so that a scan reading into them can be told corrupt.
+struct jpeg_bits {
+    const unsigned char* data;
+    long size;
+    long pos;
+    uint32_t buffer;  // next bits at the top
+    int count;
+    long padding;
+};
+
+static void
+jpeg_bits_fill(struct jpeg_bits* bits)
+{
+    while (bits->count <= 24) {
+        uint32_t byte = 0;
+        if (bits->padding > 0 || bits->pos >= bits->size) {
+            bits->padding++;
+        } else if (bits->data[bits->pos] != 0xff) {
+            byte = bits->data[bits->pos++];
+        } else if (bits->pos + 1 < bits->size && bits->data[bits->pos + 1] == 0x00) {
+            byte = 0xff;
+            bits->pos += 2;
+        } else {
+            bits->padding++;
+        }
+        bits->buffer |= byte << (24 - bits->count);
+        bits->count += 8;
+    }
+}
+
+static bool
+jpeg_bits_overrun(const struct jpeg_bits* bits)
+{
+    return bits->padding * 8 > bits->count;
+}
+
+static int
+jpeg_bits_get(struct jpeg_bits* bits, int n)
+{
+    if (n == 0) return 0;
+    jpeg_bits_fill(bits);
+    int value = bits->buffer >> (32 - n);
+    bits->buffer <<= n;
+    bits->count -= n;
+    return value;
+}
+
+// Read an n bit magnitude category value as the signed number it stands for.
+static int
+jpeg_bits_signed(struct jpeg_bits* bits, int n)
+{
+    int value = jpeg_bits_get(bits, n);
+    if (n > 0 && value < 1 << (n - 1)) value += 1 - (1 << n);
+    return value;
+}
+
+static bool
+jpeg_huffman_build(struct jpeg_huffman* h, const unsigned char counts[16], const unsigned char* values, int n)
+{
+    memset(h, 0, sizeof(*h));
+    memcpy(h->values, values, n);
+
+    int32_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++) {
+        // the all ones code of each length stays unused
+        if (code + counts[len - 1] >= (int32_t)1 << len) return false;
+
+        h->offset[len] = k - code;
+        for (int i = 0; i < counts[len - 1]; i++, code++, k++) {
+            if (len > JPEG_FAST_BITS) continue;
+            int shift = JPEG_FAST_BITS - len;
+            for (int fill = 0; fill < 1 << shift; fill++) {
+                h->fast[(code << shift) + fill] = (uint16_t)(values[k] << 4 | len);
+            }
+        }
+        h->maxcode[len] = counts[len - 1] > 0 ? code - 1 : -1;
+        code <<= 1;
+    }
+    h->defined = true;
+    return true;
+}
+
+static int
+jpeg_huffman_decode(struct jpeg_bits* bits, const struct jpeg_huffman* h)
+{
+    jpeg_bits_fill(bits);
+    uint16_t entry = h->fast[bits->buffer >> (32 - JPEG_FAST_BITS)];
+    if (entry != 0) {
+        int len = entry & 15;
+        bits->buffer <<= len;
+        bits->count -= len;
+        return entry >> 4;
+    }
+
+    // longer codes one bit at a time
+    int32_t code = 0;
+    for (int len = 1; len <= 16; len++) {
+        code = code << 1 | bits->buffer >> 31;
+        bits->buffer <<= 1;
+        bits->count--;
+        if (code <= h->maxcode[len]) return h->values[h->offset[len] + code];
+    }
+    return -1;
+}
+
+// Decode, dequantize and inverse transform one 8x8 block into `out`.
+static bool
+jpeg_decode_block(struct jpeg* jpeg, struct jpeg_bits* bits, struct jpeg_component* c, unsigned char* out)
+{
+    const uint16_t* quant = jpeg->quant[c->quant];
+    float coef[64] = { 0 };
+
+    int size = jpeg_huffman_decode(bits, &jpeg->dc[c->dc]);
+    if (size < 0 || size > 11) return false;
+    c->pred += jpeg_bits_signed(bits, size);
+    coef[0] = (float)c->pred * quant[0];
+
+    bool flat = true;
+    for (int k = 1; k < 64; k++) {
+        int rs = jpeg_huffman_decode(bits, &jpeg->ac[c->ac]);
+        if (rs < 0) return false;
+        int run = rs >> 4;
+        size = rs & 15;
+        if (size == 0) {
+            if (run != 15) break;  // end of block
+            k += 15;
+            continue;
+        }
+        k += run;
+        if (k > 63 || size > 10) return false;
+        int z = JPEG_ZIGZAG[k];
+        coef[z] = (float)jpeg_bits_signed(bits, size) * quant[z];
+        flat = false;
+    }
+
+    // only the DC term: every sample is the same
+    if (flat) {
+        float sum = 128.5f + coef[0] / 8.0f;
+        unsigned char value = sum <= 0.0f ? 0 : sum >= 255.0f ? 255 : (unsigned char)sum;
+        for (int y = 0; y < 8; y++) memset(out + y * c->stride, value, 8);
+        return true;
+    }
+
+    // rows, then columns
+    float rows[64];
+    for (int v = 0; v < 8; v++) {
+        for (int x = 0; x < 8; x++) {
+            float sum = 0.0f;
+            for (int u = 0; u < 8; u++) sum += JPEG_IDCT[x][u] * coef[v * 8 + u];
+            rows[v * 8 + x] = sum;
+        }
+    }
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            float sum = 128.5f;
+            for (int v = 0; v < 8; v++) sum += JPEG_IDCT[y][v] * rows[v * 8 + x];
+            out[y * c->stride + x] = sum <= 0.0f ? 0 : sum >= 255.0f ? 255 : (unsigned char)sum;
+        }
+    }
+    return true;
+}
+
+static unsigned
+jpeg_u16(const unsigned char* p)
+{
+    return (unsigned)p[0] << 8 | p[1];
+}
+
+static bool
+jpeg_read_frame(struct jpeg* jpeg, const unsigned char* body, long length)
+{
+    if (jpeg->count != 0 || length < 6 || body[0] != 8) return false;
+    jpeg->height = jpeg_u16(body + 1);
+    jpeg->width = jpeg_u16(body + 3);
+    jpeg->count = body[5];
+    if (jpeg->count != 1 && jpeg->count != 3) return false;
+    if (length != 6 + 3 * jpeg->count) return false;
+    if (jpeg->width == 0 || jpeg->width > IMAGE_SIZE_MAX || jpeg->height == 0 || jpeg->height > IMAGE_SIZE_MAX) {
+        return false;
+    }
+
+    jpeg->hmax = 1;
+    jpeg->vmax = 1;
+    for (int i = 0; i < jpeg->count; i++) {
+        struct jpeg_component* c = &jpeg->components[i];
+        const unsigned char* p = body + 6 + 3 * i;
+        c->id = p[0];
+        c->h = p[1] >> 4;
+        c->v = p[1] & 15;
+        c->quant = p[2];
+        if (c->h < 1 || c->h > JPEG_MAX_SAMPLING || c->v < 1 || c->v > JPEG_MAX_SAMPLING) return false;
+        if (c->quant >= JPEG_MAX_TABLES) return false;
+        if (c->h > jpeg->hmax) jpeg->hmax = c->h;
+        if (c->v > jpeg->vmax) jpeg->vmax = c->v;
+    }
+
+    jpeg->mcus_x = (jpeg->width + 8 * jpeg->hmax - 1) / (8 * jpeg->hmax);
+    jpeg->mcus_y = (jpeg->height + 8 * jpeg->vmax - 1) / (8 * jpeg->vmax);
+    for (int i = 0; i < jpeg->count; i++) {
+        struct jpeg_component* c = &jpeg->components[i];
+        c->stride = jpeg->mcus_x * c->h * 8;
+        c->plane = calloc(c->stride, jpeg->mcus_y * c->v * 8);
+        if (c->plane == NULL) return false;
+    }
+    return true;
+}
+
+static bool
+jpeg_read_huffman(struct jpeg* jpeg, const unsigned char* body, long length)
+{
+    while (length > 0) {
+        if (length < 17) return false;
+        int class = body[0] >> 4;
+        int index = body[0] & 15;
+        if (class > 1 || index >= JPEG_MAX_TABLES) return false;
+
+        int n = 0;
+        for (int i = 0; i < 16; i++) n += body[1 + i];
+        if (n > 256 || 17 + n > length) return false;
+
+        struct jpeg_huffman* h = class == 0 ? &jpeg->dc[index] : &jpeg->ac[index];
+        if (!jpeg_huffman_build(h, body + 1, body + 17, n)) return false;
+        body += 17 + n;
+        length -= 17 + n;
+    }
+    return true;
+}
+
+static bool
+jpeg_read_quant(struct jpeg* jpeg, const unsigned char* body, long length)
+{
+    while (length > 0) {
+        int precision = body[0] >> 4;
+        int index = body[0] & 15;
+        long size = 1 + 64 * (precision + 1);
+        if (precision > 1 || index >= JPEG_MAX_TABLES || size > length) return false;
+
+        for (int k = 0; k < 64; k++) {
+            unsigned value = precision == 0 ? body[1 + k] : jpeg_u16(body + 1 + 2 * k);
+            jpeg->quant[index][JPEG_ZIGZAG[k]] = value;
+        }
+        jpeg->quant_defined[index] = true;
+        body += size;
+        length -= size;
+    }
+    return true;
+}
+
+// Scan header, then the entropy coded data after it up to the next marker.
+// Returns the position of that marker, or -1.
+static long
+jpeg_read_scan(struct jpeg* jpeg, const unsigned char* body, long length, const unsigned char* data, long size, long pos)
+{
+    if (jpeg->count == 0 || length < 1) return -1;
+    int count = body[0];
+    if (count < 1 || count > jpeg->count || length != 4 + 2 * count) return -1;
+
+    struct jpeg_component* scan[JPEG_MAX_COMPONENTS];
+    long blocks = 0;
+    for (int i = 0; i < count; i++) {
+        const unsigned char* p = body + 1 + 2 * i;
+        scan[i] = NULL;
+        for (int j = 0; j < jpeg->count; j++) {
+            if (jpeg->components[j].id == p[0]) scan[i] = &jpeg->components[j];
+        }
+        if (scan[i] == NULL) return -1;
+
+        struct jpeg_component* c = scan[i];
+        c->dc = p[1] >> 4;
+        c->ac = p[1] & 15;
+        c->pred = 0;
+        if (c->dc >= JPEG_MAX_TABLES || c->ac >= JPEG_MAX_TABLES) return -1;
+        if (!jpeg->dc[c->dc].defined || !jpeg->ac[c->ac].defined || !jpeg->quant_defined[c->quant]) return -1;
+        blocks += c->h * c->v;
+    }
+
+    // spectral selection and successive approximation are progressive only
+    const unsigned char* p = body + 1 + 2 * count;
+    if (p[0] != 0 || p[1] != 63 || p[2] != 0 || blocks > 10) return -1;
+
+    // A single component scan covers just that component's blocks, one at a
+    // time; otherwise each MCU holds h by v blocks of every component.
+    long mcus_x = jpeg->mcus_x;
+    long mcus_y = jpeg->mcus_y;
+    if (count == 1) {
+        struct jpeg_component* c = scan[0];
+        mcus_x = ((jpeg->width * c->h + jpeg->hmax - 1) / jpeg->hmax + 7) / 8;
+        mcus_y = ((jpeg->height * c->v + jpeg->vmax - 1) / jpeg->vmax + 7) / 8;
+    }
+
+    struct jpeg_bits bits = { data, size, pos, 0, 0, 0 };
+    long mcu = 0;
+    for (long my = 0; my < mcus_y; my++) {
+        for (long mx = 0; mx < mcus_x; mx++, mcu++) {
+            if (jpeg->restart_interval > 0 && mcu > 0 && mcu % jpeg->restart_interval == 0) {
+                // byte aligned RSTn, then fresh bits and predictions
+                if (bits.pos + 1 >= size || data[bits.pos] != 0xff || (data[bits.pos + 1] & 0xf8) != 0xd0) return -1;
+                bits = (struct jpeg_bits){ data, size, bits.pos + 2, 0, 0, 0 };
+                for (int i = 0; i < count; i++) scan[i]->pred = 0;
+            }
+
+            for (int i = 0; i < count; i++) {
+                struct jpeg_component* c = scan[i];
+                int h = count == 1 ? 1 : c->h;
+                int v = count == 1 ? 1 : c->v;
+                for (int by = 0; by < v; by++) {
+                    for (int bx = 0; bx < h; bx++) {
+                        long x = (mx * h + bx) * 8;
+                        long y = (my * v + by) * 8;
+                        if (!jpeg_decode_block(jpeg, &bits, c, c->plane + y * c->stride + x)) return -1;
+                    }
+                }
+            }
+            if (jpeg_bits_overrun(&bits)) return -1;
+        }
+    }
+
+    jpeg->scans++;
+    return bits.pos;
+}
+
+static void
+jpeg_free(struct jpeg* jpeg)
+{
+    for (int i = 0; i < JPEG_MAX_COMPONENTS; i++) free(jpeg->components[i].plane);
+}
+
+bool
+jpeg_decode(struct image* image, const unsigned char* data, long size, const char* path)
+{
+    assert(image != NULL);
+    assert(data != NULL);
+
+    memset(image, 0, sizeof(*image));
+    struct jpeg* jpeg = calloc(1, sizeof(*jpeg));
+    if (jpeg == NULL) {
+        fprintf(stderr, "failed to allocate image: %s\n", path);
+        return false;
+    }
+
+    // markers: 0xFF (padded with more 0xFF) and a code, most with a segment
+    bool ok = size >= 2 && data[0] == 0xff && data[1] == 0xd8;
+    bool ended = false;
+    long pos = 2;
+    while (ok && !ended) {
+        while (pos < size && data[pos] == 0xff && pos + 1 < size && data[pos + 1] == 0xff) pos++;
+        if (pos + 1 >= size || data[pos] != 0xff) {
+            ok = false;
+            break;
+        }
+        int marker = data[pos + 1];
+        pos += 2;
+
+        if (marker == 0xd9) {
+            ended = true;
+            continue;
+        }
+        if (marker >= 0xd0 && marker <= 0xd7) continue;  // a stray RSTn
+
+        if (size - pos < 2 || jpeg_u16(data + pos) < 2 || jpeg_u16(data + pos) > size - pos) {
+            ok = false;
+            break;
+        }
+        long length = jpeg_u16(data + pos) - 2;
+        const unsigned char* body = data + pos + 2;
+        pos += 2 + length;
+
+        if (marker == 0xc0 || marker == 0xc1) {
+            ok = jpeg_read_frame(jpeg, body, length);
+        } else if (marker == 0xc4) {
+            ok = jpeg_read_huffman(jpeg, body, length);
+        } else if (marker == 0xdb) {
+            ok = jpeg_read_quant(jpeg, body, length);
+        } else if (marker == 0xdd) {
+            ok = length == 2;
+            if (ok) jpeg->restart_interval = jpeg_u16(body);
+        } else if (marker == 0xda) {
+            pos = jpeg_read_scan(jpeg, body, length, data, size, pos);
+            ok = pos >= 0;
+        } else if (marker >= 0xc2 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            fprintf(stderr, "unsupported JPEG image (only baseline is): %s\n", path);
+            jpeg_free(jpeg);
+            free(jpeg);
+            return false;
+        }
+        // anything else (APPn, COM, ...) is skipped
+    }
+
+    if (!ok || !ended || jpeg->scans == 0) {
+        fprintf(stderr, "invalid JPEG image: %s\n", path);
+        jpeg_free(jpeg);
+        free(jpeg);
+        return false;
+    }
+
+    unsigned char* pixels = malloc(jpeg->width * jpeg->height * 3);
+    if (pixels == NULL) {
+        fprintf(stderr, "failed to allocate image: %s\n", path);
+        jpeg_free(jpeg);
+        free(jpeg);
+        return false;
+    }
+
+    // YCbCr (or gray) to RGB, bottom row first
+    const struct jpeg_component* c = jpeg->components;
+    for (long y = 0; y < jpeg->height; y++) {
+        unsigned char* out = pixels + (jpeg->height - 1 - y) * jpeg->width * 3;
+        for (long x = 0; x < jpeg->width; x++, out += 3) {
+            float s[JPEG_MAX_COMPONENTS];
+            for (int i = 0; i < jpeg->count; i++) {
+                long sx = x * c[i].h / jpeg->hmax;
+                long sy = y * c[i].v / jpeg->vmax;
+                s[i] = c[i].plane[sy * c[i].stride + sx];
+            }
+            if (jpeg->count == 1) {
+                out[0] = out[1] = out[2] = (unsigned char)s[0];
+                continue;
+            }
+
+            float cb = s[1] - 128.0f;
+            float cr = s[2] - 128.0f;
+            float rgb[3] = {
+                s[0] + 1.402f * cr,
+                s[0] - 0.344136f * cb - 0.714136f * cr,
+                s[0] + 1.772f * cb,
+            };
+            for (int i = 0; i < 3; i++) {
+                float v = rgb[i] + 0.5f;
+                out[i] = v <= 0.0f ? 0 : v >= 255.0f ? 255 : (unsigned char)v;
+            }
+        }
+    }
+
+    image->format = TEXTURE_FORMAT_RGB;
+    image->width = jpeg->width;
+    image->height = jpeg->height;
+    image->pixels = pixels;
+    jpeg_free(jpeg);
+    free(jpeg);
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef FLAPPY_JPEG_H_INCLUDED
+#define FLAPPY_JPEG_H_INCLUDED
+
+#include <stdbool.h>
+
+#include "image.h"
+
+// Baseline JPEG decoding for runtime textures: 8-bit Huffman coded
+// sequential frames (SOF0 and SOF1) with one (gray) or three (YCbCr)
+// components, any sampling factors and restart intervals. Progressive and
+// lossless files are refused. The result is always RGB; subsampled chroma
+// is replicated, not interpolated. `path` is only used in error messages.
+bool jpeg_decode(struct image* image, const unsigned char* data, long size, const char* path);
+
+#endif
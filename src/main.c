@@ -1,5 +1,9 @@
+#define _DEFAULT_SOURCE
+
 #include <assert.h>
+#include <errno.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,20 +12,40 @@
 #include <GLFW/glfw3.h>
 #include <linmath/linmath.h>
 
+#include "arena.h"
+#include "assets.h"
+#include "audit.h"
 #include "config.h"
-#include "font.h"
+#include "course.h"
+#include "demo.h"
+#include "entity.h"
+#include "image.h"
+#include "input.h"
+#include "metrics.h"
 #include "model.h"
 #include "opengl.h"
+#include "particle.h"
+#include "perf.h"
 #include "physics.h"
+#include "race.h"
+#include "render.h"
+#include "resolution.h"
 #include "shader.h"
+#include "stats.h"
 #include "texture.h"
+#include "timeline.h"
+#include "trajectory.h"
+#include "world.h"
 
 // game resources
 #include "models/sprite.h"
 #include "shaders/font_frag.h"
 #include "shaders/font_vert.h"
 #include "shaders/sprite_frag.h"
+#include "shaders/sprite_frag_cutout.h"
+#include "shaders/sprite_frag_opaque.h"
 #include "shaders/sprite_vert.h"
+#include "shaders/sprite_vert_scroll.h"
 #include "textures/bg.h"
 #include "textures/bird.h"
 #include "textures/pipe_bot.h"
@@ -31,9 +55,74 @@
 #define M_PI 3.141592653589793
 #endif
 
+enum {
+    FEATHER_COUNT = 256,
+    DUST_RATE = 60,  // particles per second while flying
+
+    // transient data for one frame (reset once it has been presented)
+    FRAME_ARENA_SIZE = 256 * 1024,
+
+    // streamed text vertices (orphaned and refilled from the start when full)
+    TEXT_BUFFER_SIZE = 64 * 1024,
+
+    // frames to skip before the allocation audit starts (see --audit)
+    AUDIT_WARMUP_FRAMES = 60,
+
+    // redraw rate while nothing moves but the background (see --idle-fps)
+    IDLE_FPS = 10,
+};
+
+// metric histogram buckets (seconds per frame, points per run)
+static const double METRICS_FRAME_BOUNDS[] = {
+    0.001, 0.002, 0.004, 0.008, 0.0125, 0.0167, 0.025, 0.0334, 0.05, 0.1, 0.25,
+};
+static const double METRICS_SCORE_BOUNDS[] = {
+    0, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000,
+};
+
+// sprite shader variants, one per way a sprite is composited
+enum sprite_shader_kind {
+    SPRITE_SHADER_BLEND = 0,   // alpha blended (transparent pass)
+    SPRITE_SHADER_CUTOUT,      // alpha tested, no blending (opaque pass)
+    SPRITE_SHADER_BACKGROUND,  // scrolling UVs, no alpha at all (opaque pass)
+    SPRITE_SHADER_COUNT,
+};
+
+struct sprite_shader {
+    unsigned int program;
+    int uniform_model;
+    int uniform_projection;
+    int uniform_uv_transform;  // SPRITE_SHADER_BACKGROUND only
+};
+
+// particles are drawn as untextured squares, tinted only by their alpha
+static const unsigned char TEXTURE_PARTICLE_PIXELS[] = { 0xff, 0xff, 0xff, 0xff };
 
+// images loaded by --assets DIR (the art under res/textures/), one for each
+// sprite texture from RENDER_TEXTURE_BG on
+static const char* const ASSET_TEXTURE_FILES[] = { "bg.jpg", "bird.png", "pipe_top.png", "pipe_bot.png" };
 enum {
-    PIPE_COUNT = 512,
+    ASSET_TEXTURE_COUNT = sizeof(ASSET_TEXTURE_FILES) / sizeof(ASSET_TEXTURE_FILES[0]),
+};
+
+// Time to first frame by stage, in seconds on the startup_now clock.
+struct startup {
+    double launch;
+    double glfw;         // glfwInit done
+    double window;       // window and context made current
+    double game;         // shaders, models and buffers created
+    double textures;     // every sprite texture created
+    double first_frame;  // first frame swapped
+
+    // time spent in the textures stage blocked on decode, and uploading
+    double texture_wait;
+    double texture_upload;
+
+    // images decoded in the background (see --assets)
+    long decoded;
+    long decode_threads;
+    double decode_elapsed;  // until the last image was done (starts at launch)
+    double decode_work;     // summed over the threads
 };
 
 struct game {
@@ -43,79 +132,188 @@ struct game {
     int font_shader_uniform_model;
     int font_shader_uniform_projection;
 
-    // shader for sprite rendering
-    unsigned int sprite_shader;
-    int sprite_shader_uniform_model;
-    int sprite_shader_uniform_projection;
+    // HUD vertices, appended to by every draw_hud
+    unsigned int text_buffer;
+    unsigned int text_model;
+    long text_offset;
+
+    // shaders for sprite rendering (indexed by enum sprite_shader_kind)
+    struct sprite_shader sprite_shaders[SPRITE_SHADER_COUNT];
     unsigned int sprite_buffer;
     unsigned int sprite_model;
     unsigned int sprite_model_vertex_count;
 
-    // texture handles
-    unsigned int texture_bg;
-    unsigned int texture_bird;
-    unsigned int texture_pipe_bot;
-    unsigned int texture_pipe_top;
+    // texture handles (indexed by enum render_texture)
+    unsigned int textures[RENDER_TEXTURE_COUNT];
+
+    // particle effects, drawn as instances of the sprite model
+    struct particle_pool* particles;
+    unsigned int particle_buffer;
+    unsigned int particle_model;
+    float dust_timer;
 
     // timing vars
     double last_second;
     double last_frame;
     long frame_count;
 
-    // game state
-    bool running;
-    bool dead;
-    bool space;
-    long score;
-
-    // game objects
-    float camera;
-    float bird_pos_x;
-    float bird_pos_y;
-    float bird_vel_x;
-    float bird_vel_y;
-    float pipes[PIPE_COUNT];
+    // key events from the window thread (see key_callback)
+    struct input_queue input;
+
+    // flaps applied but not yet on screen, and their input-to-response latency
+    long input_pending;
+    double input_pending_time;    // sum of event times
+    double input_pending_oldest;
+    long input_latency_count;
+    double input_latency_sum;
+    double input_latency_max;
+
+    // run history (optional)
+    struct stats* stats;
+
+    // per-tick log of single player runs (optional, see trajectory.h)
+    struct trajectory* trajectory;
+    uint32_t trajectory_run;
+
+    // live metrics export (optional, every metric stays NULL without it)
+    struct metrics* metrics;
+    struct metric* metric_frames;
+    struct metric* metric_frame_seconds;
+    struct metric* metric_fps;
+    struct metric* metric_render_scale;
+    struct metric* metric_idle;
+    struct metric* metric_ticks;
+    struct metric* metric_runs_started;
+    struct metric* metric_runs_ended;
+    struct metric* metric_score;
+
+    // simulation state
+    struct world world;
+
+    // snapshots of the world above for rewinding (hold R to scrub back)
+    struct timeline* timeline;
+    double timeline_time;          // simulated seconds, the timeline's clock
+    unsigned long timeline_tick;   // TICKs of that clock at the newest snapshot
+    bool timeline_died;            // the run on the timeline crashed (and was counted)
+    bool rewinding;
+    double rewind_tick;
+    long rewind_index;
+
+    // head-to-head race (optional, replaces the world above once started)
+    struct race* race;
+
+    // frame timing history and whether to show it (toggled with F3)
+    struct perf perf;
+    bool perf_overlay;
+
+    // per-frame allocations (render instances, text vertices, ...)
+    struct arena frame;
+
+    // offscreen scene target for dynamic resolution (sized to the viewport,
+    // only the scaled-down corner of it is rendered to)
+    struct resolution resolution;
+    unsigned int scene_framebuffer;
+    unsigned int scene_color;
+    unsigned int scene_depth;
+    long scene_width;
+    long scene_height;
 };
 
-bool game_init(struct game* game);
+bool game_init(struct game* game, struct course* course);
 void game_free(struct game* game);
 void game_reset(struct game* game);
-void game_update(struct game* game, GLFWwindow* window, double delta);
+void game_update(struct game* game, double now, double delta);
+void game_present(struct game* game, double now);
 void game_render(struct game* game, long width, long height);
 
 static void
-draw_sprite(struct game* game, unsigned t, float x, float y, float z, float r, float sx, float sy)
+draw_sprite(struct game* game, const struct render_sprite* sprite)
 {
-    // bind the shader
-    glUseProgram(game->sprite_shader);
+    // bind the shader variant for the sprite's blend mode
+    enum sprite_shader_kind kind = SPRITE_SHADER_BLEND;
+    if (sprite->mode == RENDER_MODE_OPAQUE) kind = SPRITE_SHADER_BACKGROUND;
+    if (sprite->mode == RENDER_MODE_CUTOUT) kind = SPRITE_SHADER_CUTOUT;
+    const struct sprite_shader* shader = &game->sprite_shaders[kind];
+    glUseProgram(shader->program);
+    if (kind == SPRITE_SHADER_BACKGROUND) {
+        glUniform4f(shader->uniform_uv_transform, sprite->uv[0], sprite->uv[1], sprite->uv[2], sprite->uv[3]);
+    }
 
     // setup model matrix
     mat4x4 m = {{ 0 }};
-    mat4x4_translate(m, x, y, z);
-    mat4x4_rotate_Z(m, m, r * (M_PI / 180.0));  // convert deg to rad
-    mat4x4_scale_aniso(m, m, sx, sy, 1.0f);
-    glUniformMatrix4fv(game->sprite_shader_uniform_model, 1, GL_FALSE, (const float*)m);
+    mat4x4_translate(m, sprite->x, sprite->y, sprite->z);
+    mat4x4_rotate_Z(m, m, sprite->r * (M_PI / 180.0));  // convert deg to rad
+    mat4x4_scale_aniso(m, m, sprite->sx, sprite->sy, 1.0f);
+    glUniformMatrix4fv(shader->uniform_model, 1, GL_FALSE, (const float*)m);
 
     // setup projection matrix
     mat4x4 p = {{ 0 }};
     mat4x4_identity(p);
     mat4x4_ortho(p, -(WIDTH / 2.0f), (WIDTH / 2.0f), -(HEIGHT / 2.0f), (HEIGHT / 2.0f), -1.0f, 1.0f);
-    glUniformMatrix4fv(game->sprite_shader_uniform_projection, 1, GL_FALSE, (const float*)p);
+    glUniformMatrix4fv(shader->uniform_projection, 1, GL_FALSE, (const float*)p);
 
     // bind the texture
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, t);
+    glBindTexture(GL_TEXTURE_2D, game->textures[sprite->texture]);
 
     // bind the model
     glBindVertexArray(game->sprite_model);
 
-    // draw the sprite!
+    // draw the sprite! (faded through the constant a_instance alpha)
+    if (sprite->alpha != 1.0f) glVertexAttrib4f(2, 0.0f, 0.0f, 1.0f, sprite->alpha);
     glDrawArrays(GL_TRIANGLES, 0, game->sprite_model_vertex_count);
+    if (sprite->alpha != 1.0f) glVertexAttrib4f(2, 0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+static void
+draw_particles(struct game* game, const struct particle_pool* particles, float camera)
+{
+    long count = particles->count;
+    if (count == 0) return;
+
+    // stream this frame's instances straight into the (orphaned) buffer
+    glBindBuffer(GL_ARRAY_BUFFER, game->particle_buffer);
+    float* buf = glMapBufferRange(GL_ARRAY_BUFFER, 0, count * PARTICLE_FLOATS_PER_INSTANCE * sizeof(float),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (buf == NULL) {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+    particle_instances(particles, buf, count);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // bind the shader (particles fade out, so they are always blended)
+    const struct sprite_shader* shader = &game->sprite_shaders[SPRITE_SHADER_BLEND];
+    glUseProgram(shader->program);
+
+    // setup model matrix (particles live in world space)
+    mat4x4 m = {{ 0 }};
+    mat4x4_translate(m, -camera, 0.0f, PARTICLE_LAYER);
+    glUniformMatrix4fv(shader->uniform_model, 1, GL_FALSE, (const float*)m);
+
+    // setup projection matrix
+    mat4x4 p = {{ 0 }};
+    mat4x4_identity(p);
+    mat4x4_ortho(p, -(WIDTH / 2.0f), (WIDTH / 2.0f), -(HEIGHT / 2.0f), (HEIGHT / 2.0f), -1.0f, 1.0f);
+    glUniformMatrix4fv(shader->uniform_projection, 1, GL_FALSE, (const float*)p);
+
+    // bind the texture
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, game->textures[RENDER_TEXTURE_WHITE]);
+
+    // draw every particle in one call
+    glBindVertexArray(game->particle_model);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, game->sprite_model_vertex_count, count);
 }
 
+// Draw HUD vertices (in the format of font_print, already placed in view
+// units) in a single call.
 static void
-draw_text(struct game* game, const char* str, float x, float y, float z, float sx, float sy)
+draw_hud(struct game* game, const float* buf, long size, float z)
 {
+    if (size == 0 || size > TEXT_BUFFER_SIZE) return;
+
     // bind the shader
     glUseProgram(game->font_shader);
 
@@ -124,8 +322,7 @@ draw_text(struct game* game, const char* str, float x, float y, float z, float s
 
     // setup model matrix
     mat4x4 m = {{ 0 }};
-    mat4x4_translate(m, x, y, 0.0f);
-    mat4x4_scale_aniso(m, m, sx, sy, 1.0f);
+    mat4x4_identity(m);
     glUniformMatrix4fv(game->font_shader_uniform_model, 1, GL_FALSE, (const float*)m);
 
     // setup projection matrix
@@ -134,39 +331,48 @@ draw_text(struct game* game, const char* str, float x, float y, float z, float s
     mat4x4_ortho(p, -(WIDTH / 2.0f), (WIDTH / 2.0f), -(HEIGHT / 2.0f), (HEIGHT / 2.0f), -1.0f, 1.0f);
     glUniformMatrix4fv(game->font_shader_uniform_projection, 1, GL_FALSE, (const float*)p);
 
-    long vertices = font_vertices(str);
-
-    long size = font_size(str);
-    float* buf = malloc(size);
-    assert(buf != NULL);
-
-    // amazing 4x4 bitmap font clarity
-    font_print(str, buf, size);
-
-    unsigned vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    unsigned vbo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    // append after the text already drawn (no new buffers, no stalls)
+    glBindBuffer(GL_ARRAY_BUFFER, game->text_buffer);
+    if (game->text_offset + size > TEXT_BUFFER_SIZE) {
+        glBufferData(GL_ARRAY_BUFFER, TEXT_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+        game->text_offset = 0;
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, game->text_offset, size, buf);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glBufferData(GL_ARRAY_BUFFER, size, buf, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const void*)0);
-    glEnableVertexAttribArray(0);
+    glBindVertexArray(game->text_model);
+    glDrawArrays(GL_TRIANGLES, game->text_offset / (2 * sizeof(float)), size / (2 * sizeof(float)));
+    game->text_offset += size;
+}
 
-    free(buf);
+static void
+sprite_shader_create(struct sprite_shader* shader, const char* vert_source, const char* frag_source)
+{
+    shader->program = shader_compile_and_link(vert_source, frag_source);
+    shader->uniform_model = glGetUniformLocation(shader->program, "u_model");
+    shader->uniform_projection = glGetUniformLocation(shader->program, "u_projection");
+    shader->uniform_uv_transform = glGetUniformLocation(shader->program, "u_uv_transform");
 
-    glUseProgram(game->font_shader);
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, vertices);
+    // set texture uniform location
+    glUseProgram(shader->program);
+    glUniform1i(glGetUniformLocation(shader->program, "u_texture"), 0);
+    glUseProgram(0);
+}
 
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+// The world the local player is in: their side of a race, once one has
+// started, otherwise the single player world.
+static const struct world*
+game_world(const struct game* game)
+{
+    if (game->race != NULL) {
+        const struct world* world = race_world(game->race, race_local(game->race));
+        if (world != NULL) return world;
+    }
+    return &game->world;
 }
 
 bool
-game_init(struct game* game)
+game_init(struct game* game, struct course* course)
 {
     assert(game != NULL);
 
@@ -176,45 +382,188 @@ game_init(struct game* game)
     game->font_shader_uniform_model = glGetUniformLocation(game->font_shader, "u_model");
     game->font_shader_uniform_projection = glGetUniformLocation(game->font_shader, "u_projection");
 
-    // create shader for rendering sprites
-    game->sprite_shader = shader_compile_and_link(SHADER_SPRITE_VERT_SOURCE, SHADER_SPRITE_FRAG_SOURCE);
-    game->sprite_shader_uniform_model = glGetUniformLocation(game->sprite_shader, "u_model");
-    game->sprite_shader_uniform_projection = glGetUniformLocation(game->sprite_shader, "u_projection");
+    // create the streaming buffer for text (2 floats per vertex)
+    glGenVertexArrays(1, &game->text_model);
+    glBindVertexArray(game->text_model);
+    glGenBuffers(1, &game->text_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, game->text_buffer);
+    glBufferData(GL_ARRAY_BUFFER, TEXT_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // set texture uniform location
-    glUseProgram(game->sprite_shader);
-    glUniform1i(glGetUniformLocation(game->sprite_shader, "u_texture"), 0);
-    glUseProgram(0);
+    // create shaders for rendering sprites
+    sprite_shader_create(&game->sprite_shaders[SPRITE_SHADER_BLEND],
+        SHADER_SPRITE_VERT_SOURCE, SHADER_SPRITE_FRAG_SOURCE);
+    sprite_shader_create(&game->sprite_shaders[SPRITE_SHADER_CUTOUT],
+        SHADER_SPRITE_VERT_SOURCE, SHADER_SPRITE_FRAG_CUTOUT_SOURCE);
+    sprite_shader_create(&game->sprite_shaders[SPRITE_SHADER_BACKGROUND],
+        SHADER_SPRITE_VERT_SCROLL_SOURCE, SHADER_SPRITE_FRAG_OPAQUE_SOURCE);
 
     // create model for rendering sprites
     game->sprite_buffer = model_buffer_create(MODEL_SPRITE_FORMAT, MODEL_SPRITE_VERTEX_COUNT, MODEL_SPRITE_VERTICES);
     game->sprite_model = model_buffer_config(MODEL_SPRITE_FORMAT, game->sprite_buffer);
     game->sprite_model_vertex_count = MODEL_SPRITE_VERTEX_COUNT;
 
-    // create textures
-    game->texture_bg = texture_create(TEXTURE_BG_FORMAT, TEXTURE_BG_WIDTH, TEXTURE_BG_HEIGHT, TEXTURE_BG_PIXELS);
-    game->texture_bird = texture_create(TEXTURE_BIRD_FORMAT, TEXTURE_BIRD_WIDTH, TEXTURE_BIRD_HEIGHT, TEXTURE_BIRD_PIXELS);
-    game->texture_pipe_bot = texture_create(TEXTURE_PIPE_BOT_FORMAT, TEXTURE_PIPE_BOT_WIDTH, TEXTURE_PIPE_BOT_HEIGHT, TEXTURE_PIPE_BOT_PIXELS);
-    game->texture_pipe_top = texture_create(TEXTURE_PIPE_TOP_FORMAT, TEXTURE_PIPE_TOP_WIDTH, TEXTURE_PIPE_TOP_HEIGHT, TEXTURE_PIPE_TOP_PIXELS);
+    // create textures (sprite textures come later, see game_load_textures)
+    game->textures[RENDER_TEXTURE_WHITE] = texture_create(TEXTURE_FORMAT_RGBA, 1, 1, TEXTURE_PARTICLE_PIXELS);
+
+    // create particle pool and its per-instance buffer
+    game->particles = particle_pool_create(rand());
+    if (game->particles == NULL) return false;
+
+    glGenBuffers(1, &game->particle_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, game->particle_buffer);
+    glBufferData(GL_ARRAY_BUFFER, PARTICLE_CAPACITY * PARTICLE_FLOATS_PER_INSTANCE * sizeof(float), NULL, GL_STREAM_DRAW);
+
+    // particles share the sprite model but advance a_instance once per instance
+    game->particle_model = model_buffer_config(MODEL_SPRITE_FORMAT, game->sprite_buffer);
+    glBindVertexArray(game->particle_model);
+    glBindBuffer(GL_ARRAY_BUFFER, game->particle_buffer);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, PARTICLE_FLOATS_PER_INSTANCE * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // single sprites leave a_instance disabled and read this constant instead
+    glVertexAttrib4f(2, 0.0f, 0.0f, 1.0f, 1.0f);
+
+    if (!arena_init(&game->frame, FRAME_ARENA_SIZE)) return false;
+
+    game->timeline = timeline_create();
+    if (game->timeline == NULL) return false;
+
+    // create the offscreen scene target (storage comes with the first frame)
+    glGenFramebuffers(1, &game->scene_framebuffer);
+    glGenTextures(1, &game->scene_color);
+    glGenRenderbuffers(1, &game->scene_depth);
+    resolution_init(&game->resolution, 60.0, 0.0f);
 
     // reset
+    world_init(&game->world, course, rand());
     game_reset(game);
     return true;
 }
 
+static double
+startup_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Create the sprite textures, either from the baked resource headers or
+// from the images `assets` is decoding, uploading each one as soon as it is
+// done. Images that fail to load fall back to their baked version.
+static void
+game_load_textures(struct game* game, struct assets* assets, struct startup* startup)
+{
+    const struct baked_texture {
+        int format;
+        long width;
+        long height;
+        const unsigned char* pixels;
+    } baked[ASSET_TEXTURE_COUNT] = {
+        { TEXTURE_BG_FORMAT, TEXTURE_BG_WIDTH, TEXTURE_BG_HEIGHT, TEXTURE_BG_PIXELS },
+        { TEXTURE_BIRD_FORMAT, TEXTURE_BIRD_WIDTH, TEXTURE_BIRD_HEIGHT, TEXTURE_BIRD_PIXELS },
+        { TEXTURE_PIPE_TOP_FORMAT, TEXTURE_PIPE_TOP_WIDTH, TEXTURE_PIPE_TOP_HEIGHT, TEXTURE_PIPE_TOP_PIXELS },
+        { TEXTURE_PIPE_BOT_FORMAT, TEXTURE_PIPE_BOT_WIDTH, TEXTURE_PIPE_BOT_HEIGHT, TEXTURE_PIPE_BOT_PIXELS },
+    };
+
+    if (assets == NULL) {
+        for (long i = 0; i < ASSET_TEXTURE_COUNT; i++) {
+            const struct baked_texture* b = &baked[i];
+            game->textures[RENDER_TEXTURE_BG + i] = texture_create(b->format, b->width, b->height, b->pixels);
+        }
+        return;
+    }
+
+    // in whatever order the decodes finish
+    for (;;) {
+        double start = startup_now();
+        long index = assets_next(assets);
+        double ready = startup_now();
+        startup->texture_wait += ready - start;
+        if (index < 0) break;
+
+        const struct asset* asset = assets_get(assets, index);
+        unsigned int* texture = &game->textures[RENDER_TEXTURE_BG + index];
+        if (asset->ok) {
+            const struct image* image = &asset->image;
+            *texture = texture_create(image->format, image->width, image->height, image->pixels);
+        } else {
+            const struct baked_texture* b = &baked[index];
+            fprintf(stderr, "using the built-in texture for %s\n", asset->path);
+            *texture = texture_create(b->format, b->width, b->height, b->pixels);
+        }
+        startup->texture_upload += startup_now() - ready;
+
+        startup->decoded += asset->ok;
+        startup->decode_work += asset->decode_seconds;
+    }
+    startup->decode_threads = assets_threads(assets);
+    startup->decode_elapsed = assets_elapsed(assets);
+}
+
+static void
+startup_print(const struct startup* startup)
+{
+    printf("Startup: %.1lf ms to first frame\n", 1000.0 * (startup->first_frame - startup->launch));
+    printf("  glfwInit    %8.1lf ms\n", 1000.0 * (startup->glfw - startup->launch));
+    printf("  window      %8.1lf ms\n", 1000.0 * (startup->window - startup->glfw));
+    printf("  game init   %8.1lf ms  (shaders, models, buffers)\n", 1000.0 * (startup->game - startup->window));
+    if (startup->decode_threads > 0) {
+        printf("  textures    %8.1lf ms  (%.1lf ms waiting on decode, %.1lf ms uploading)\n",
+            1000.0 * (startup->textures - startup->game),
+            1000.0 * startup->texture_wait, 1000.0 * startup->texture_upload);
+    } else {
+        printf("  textures    %8.1lf ms  (built in)\n", 1000.0 * (startup->textures - startup->game));
+    }
+    printf("  first frame %8.1lf ms\n", 1000.0 * (startup->first_frame - startup->textures));
+    if (startup->decode_threads > 0) {
+        printf("  decode      %8.1lf ms  (%ld images on %ld threads, %.1lf ms of work, overlapping the above)\n",
+            1000.0 * startup->decode_elapsed, startup->decoded, startup->decode_threads,
+            1000.0 * startup->decode_work);
+    }
+}
+
 void
 game_free(struct game* game)
 {
     assert(game != NULL);
 
     glDeleteProgram(game->font_shader);
-    glDeleteProgram(game->sprite_shader);
+    glDeleteBuffers(1, &game->text_buffer);
+    glDeleteVertexArrays(1, &game->text_model);
+    for (long i = 0; i < SPRITE_SHADER_COUNT; i++) {
+        glDeleteProgram(game->sprite_shaders[i].program);
+    }
     glDeleteBuffers(1, &game->sprite_buffer);
     glDeleteVertexArrays(1, &game->sprite_model);
-    glDeleteTextures(1, &game->texture_bg);
-    glDeleteTextures(1, &game->texture_bird);
-    glDeleteTextures(1, &game->texture_pipe_bot);
-    glDeleteTextures(1, &game->texture_pipe_top);
+    glDeleteTextures(RENDER_TEXTURE_COUNT, game->textures);
+    glDeleteBuffers(1, &game->particle_buffer);
+    glDeleteVertexArrays(1, &game->particle_model);
+    particle_pool_destroy(game->particles);
+    arena_free(&game->frame);
+    timeline_destroy(game->timeline);
+    glDeleteFramebuffers(1, &game->scene_framebuffer);
+    glDeleteTextures(1, &game->scene_color);
+    glDeleteRenderbuffers(1, &game->scene_depth);
+}
+
+// Start the timeline over for a new run: snapshots of the last one must
+// not be reachable by rewinding from this one.
+static void
+game_timeline_clear(struct game* game)
+{
+    timeline_clear(game->timeline);
+    game->timeline_time = 0.0;
+    game->timeline_tick = 0;
+    game->timeline_died = false;
+    game->rewinding = false;
 }
 
 void
@@ -222,88 +571,333 @@ game_reset(struct game* game)
 {
     assert(game != NULL);
 
-    // game state
-    game->running = false;
-    game->dead = false;
-    game->space = false;
-    game->score = 0;
+    game->dust_timer = 0.0f;
+    world_reset(&game->world);
+    particle_clear(game->particles);
+    game_timeline_clear(game);
+}
 
-    // game objects
-    game->camera = -3.0f;
-    game->bird_pos_x = -6.0f;
-    game->bird_pos_y = 0.0f;
-    game->bird_vel_x = SPEED;
-    game->bird_vel_y = 0.0f;
-    for (long i = 0; i < PIPE_COUNT; i++) {
-        float gap = (float)rand() / (float)RAND_MAX;  // [0.0, 1.0]
-        gap -= 0.5f;  // [-0.5, 0.5]
-        game->pipes[i] = gap * 4.0f;  // [-2.0, 2.0]
+// Register the metrics and start exporting them on `address` (see metrics.h).
+static bool
+game_metrics_init(struct game* game, const char* address)
+{
+    struct metrics* metrics = metrics_create();
+    if (metrics == NULL) return false;
+
+    game->metric_frames = metrics_counter(metrics, "flappy_frames_total", "Frames presented.");
+    game->metric_frame_seconds = metrics_histogram(metrics, "flappy_frame_seconds", "Time between frames.",
+        METRICS_FRAME_BOUNDS, sizeof(METRICS_FRAME_BOUNDS) / sizeof(METRICS_FRAME_BOUNDS[0]));
+    game->metric_fps = metrics_gauge(metrics, "flappy_fps", "Frames presented in the last second.");
+    game->metric_render_scale = metrics_gauge(metrics, "flappy_render_scale", "Fraction of the window size rendered.");
+    game->metric_idle = metrics_gauge(metrics, "flappy_idle", "Fraction of the last second spent asleep while idle.");
+    game->metric_ticks = metrics_counter(metrics, "flappy_sim_ticks_total", "Simulation ticks of the local world.");
+    game->metric_runs_started = metrics_counter(metrics, "flappy_runs_started_total", "Runs started.");
+    game->metric_runs_ended = metrics_counter(metrics, "flappy_runs_ended_total", "Runs ended by a crash.");
+    game->metric_score = metrics_histogram(metrics, "flappy_score", "Score of each finished run.",
+        METRICS_SCORE_BOUNDS, sizeof(METRICS_SCORE_BOUNDS) / sizeof(METRICS_SCORE_BOUNDS[0]));
+
+    if (!metrics_serve(metrics, address)) {
+        metrics_destroy(metrics);
+        game->metric_frames = NULL;
+        game->metric_frame_seconds = NULL;
+        game->metric_fps = NULL;
+        game->metric_render_scale = NULL;
+        game->metric_idle = NULL;
+        game->metric_ticks = NULL;
+        game->metric_runs_started = NULL;
+        game->metric_runs_ended = NULL;
+        game->metric_score = NULL;
+        return false;
     }
+
+    game->metrics = metrics;
+    return true;
 }
 
-void
-game_update(struct game* game, GLFWwindow* window, double delta)
+// Advance the simulation by delta seconds, with a flap (if any) at the start.
+static void
+game_step(struct game* game, bool flap, double delta)
 {
-    // can game_update be detached from the GLFWwindow* ?
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, GLFW_TRUE);
+    const struct world* before = game_world(game);
+    bool was_dead = before->dead;
+    bool was_running = before->running;
+    long ticks = before->ticks;
+    if (game->race != NULL) {
+        race_update(game->race, flap, delta);
+    } else {
+        world_update(&game->world, flap, delta);
     }
 
-    // only allow single flaps (not continuous)
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-        if (game->dead) game_reset(game);
-
-        game->running = true;
-        if (!game->space) {
-            game->bird_vel_y = FLAP;
-            game->space = true;
-        } else {
-            game->bird_vel_y -= delta * GRAVITY;
+    // a new run (a flap after death restarts inside world_update)
+    const struct world* world = game_world(game);
+    bool started = world->running && (was_dead || !was_running);
+    bool died = world->dead && !was_dead;
+    if (started && game->race == NULL) game_timeline_clear(game);
+
+    // snapshot the single player world at most once per TICK, and always at
+    // the moment of death
+    if (game->race == NULL && world->running) {
+        game->timeline_time += delta;
+        unsigned long tick = game->timeline_time / TICK;
+        if (tick > game->timeline_tick || game->timeline->count == 0 || died) {
+            timeline_record(game->timeline, world, tick);
+            game->timeline_tick = tick;
         }
-    } else {
-        if (game->running) {
-            game->bird_vel_y -= delta * GRAVITY;
+        if (died) game->timeline_died = true;
+    }
+
+    // a new run counts its ticks from zero
+    if (started) {
+        metric_add(game->metric_runs_started, 1);
+        if (ticks > 0) game->trajectory_run++;
+        ticks = 0;
+    }
+    if (world->ticks > ticks) metric_add(game->metric_ticks, world->ticks - ticks);
+
+    // one row per step that moved the bird (steps follow input, not TICK)
+    if (game->trajectory != NULL && game->race == NULL && world->ticks > ticks) {
+        struct trajectory_record record;
+        trajectory_record_world(&record, world, game->trajectory_run, flap);
+        trajectory_append(game->trajectory, &record);
+    }
+
+    // burst of feathers (and a history entry) on death
+    if (died) {
+        const struct entity_store* entities = &world->entities;
+        particle_emit(game->particles, entities->pos_x[WORLD_BIRD], entities->pos_y[WORLD_BIRD],
+            FEATHER_COUNT, 4.0f, 1.5f, 0.15f);
+
+        metric_add(game->metric_runs_ended, 1);
+        metric_observe(game->metric_score, world->score);
+
+        if (game->stats != NULL) {
+            struct stats_run run = {
+                .seed = world->seed,
+                .score = world->score,
+                .duration = world->time,
+                .ticks = world->ticks,
+                .cause = world->death,
+            };
+            stats_record(game->stats, &run);
         }
-        game->space = false;
     }
+}
+
+static void
+game_rewind_start(struct game* game)
+{
+    if (game->rewinding || game->timeline->count == 0) return;
+
+    game->rewinding = true;
+    game->rewind_tick = game->timeline_tick;
+    game->rewind_index = game->timeline->count - 1;
+}
+
+// Scrub back through the timeline in real time.
+static void
+game_rewind(struct game* game, double delta)
+{
+    struct timeline* timeline = game->timeline;
+    double oldest = timeline_entry(timeline, 0)->tick;
+
+    game->rewind_tick -= delta / TICK;
+    if (game->rewind_tick < oldest) game->rewind_tick = oldest;
 
-    // update bird and camera positions
-    if (game->running) {
-        game->bird_pos_x += (game->bird_vel_x * delta);
-        game->bird_pos_y += (game->bird_vel_y * delta);
-        game->camera += (game->bird_vel_x * delta);
+    long index = timeline_find(timeline, game->rewind_tick);
+    if (index != game->rewind_index && timeline_restore(timeline, index, &game->world)) {
+        game->rewind_index = index;
     }
+}
+
+// Resume from the snapshot on screen, forgetting the future it replaced.
+static void
+game_rewind_stop(struct game* game)
+{
+    if (!game->rewinding) return;
+
+    game->rewinding = false;
+    timeline_truncate(game->timeline, game->rewind_index + 1);
+    game->timeline_tick = timeline_entry(game->timeline, game->rewind_index)->tick;
+    game->timeline_time = game->timeline_tick * TICK;
+
+    // carrying on from before a crash that stats and metrics already counted
+    // is a new run (with its own id, and its own record once it ends)
+    if (game->timeline_died && !game->world.dead) {
+        game->timeline_died = false;
+        game->trajectory_run++;
+        metric_add(game->metric_runs_started, 1);
+    }
+}
 
-    // check collision
-    if (game->bird_pos_x >= -4.0f) {
-        // determine index of the next approaching pipe
-        long pipe_index = (game->bird_pos_x + 2.0f) / 4.0f;
-        float gap = game->pipes[pipe_index % PIPE_COUNT];
-        float top = gap + GAP;
-        float bot = gap - GAP;
+// Simulate the frame that ends at `now`. Every flap is applied at the moment
+// its key was pressed, so taps are never late by a frame or merged together.
+void
+game_update(struct game* game, double now, double delta)
+{
+    double cursor = now - delta;
+    bool flap = false;
 
-        bool collision = false;
-        if (physics_intersect_circle_rect(game->bird_pos_x, game->bird_pos_y, 0.3f,
-                                          pipe_index * 4.0f, top, PIPE_WIDTH, PIPE_HEIGHT)) {
-            collision = true;
+    struct input_event event;
+    while (input_pop(&game->input, &event)) {
+        if (event.key == GLFW_KEY_F3 && event.action == INPUT_PRESS) {
+            game->perf_overlay = !game->perf_overlay;
         }
-        if (physics_intersect_circle_rect(game->bird_pos_x, game->bird_pos_y, 0.3f,
-                                          pipe_index * 4.0f, bot, PIPE_WIDTH, PIPE_HEIGHT)) {
-            collision = true;
+
+        double time = event.time;
+        if (time < cursor) time = cursor;
+        if (time > now) time = now;
+
+        // rewinding pauses the simulation until R is let go
+        if (event.key == GLFW_KEY_R && game->race == NULL) {
+            if (event.action == INPUT_PRESS) {
+                game_rewind_start(game);
+            } else if (game->rewinding) {
+                game_rewind_stop(game);
+                cursor = time;
+                flap = false;
+            }
         }
-        if (game->bird_pos_y > 4.5f || game->bird_pos_y < -4.5f) {
-            collision = true;
+
+        // flaps are ignored while scrubbing
+        if (game->rewinding) continue;
+        if (event.key != GLFW_KEY_SPACE || event.action != INPUT_PRESS) continue;
+
+        // a race steps on its own fixed tick, so it just needs the flap
+        if (game->race == NULL && (flap || time > cursor)) {
+            game_step(game, flap, time - cursor);
+            cursor = time;
         }
+        flap = true;
 
-        if (collision && !game->dead) {
-            game->dead = true;
-            game->bird_vel_x = 0.0f;
-            game->bird_vel_y = 8.0f;
+        if (game->input_pending == 0 || event.time < game->input_pending_oldest) {
+            game->input_pending_oldest = event.time;
         }
+        game->input_pending++;
+        game->input_pending_time += event.time;
+    }
+    if (game->rewinding) {
+        game_rewind(game, delta);
+    } else {
+        game_step(game, flap, now - cursor);
+    }
+
+    const struct world* world = game_world(game);
+    const struct entity_store* entities = &world->entities;
+    float bird_x = entities->pos_x[WORLD_BIRD];
+    float bird_y = entities->pos_y[WORLD_BIRD];
+
+    // trail of dust while flying
+    if (world->running && !world->dead && !game->rewinding) {
+        game->dust_timer += delta * DUST_RATE;
+        long dust = game->dust_timer;
+        game->dust_timer -= dust;
+        particle_emit(game->particles, bird_x - BIRD_WIDTH / 2.0f, bird_y, dust, 0.5f, 0.5f, 0.1f);
     }
 
-    // determine score based on bird's position
-    game->score = (game->bird_pos_x + 3.0f) / 4.0f;
+    particle_update(game->particles, PARTICLE_GRAVITY, delta);
+}
+
+// The frame just rendered reached the screen at `now`: every flap it
+// applied has now been answered.
+void
+game_present(struct game* game, double now)
+{
+    if (game->input_pending == 0) return;
+
+    game->input_latency_count += game->input_pending;
+    game->input_latency_sum += game->input_pending * now - game->input_pending_time;
+    if (now - game->input_pending_oldest > game->input_latency_max) {
+        game->input_latency_max = now - game->input_pending_oldest;
+    }
+
+    game->input_pending = 0;
+    game->input_pending_time = 0.0;
+}
+
+// Whether frames differ only by the background scroll: nothing simulated
+// moves on screen (the title screen, or after a crash once the bird has
+// dropped out of view and the feathers have settled).
+static bool
+game_idle(const struct game* game)
+{
+    if (game->race != NULL || game->rewinding) return false;
+    if (game->particles->count > 0) return false;
+
+    const struct world* world = &game->world;
+    if (!world->running) return true;
+    return world->dead && world->entities.pos_y[WORLD_BIRD] < -(HEIGHT + BIRD_HEIGHT) / 2.0f;
+}
+
+// Size the offscreen scene target to match the viewport. Storage is only
+// reallocated when the window changes size, never while scaling.
+static bool
+scene_target_resize(struct game* game, long width, long height)
+{
+    if (game->scene_width == width && game->scene_height == height) {
+        return game->scene_width > 0;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, game->scene_color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, game->scene_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, game->scene_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, game->scene_color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, game->scene_depth);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        fprintf(stderr, "scene framebuffer is incomplete, rendering at full size\n");
+        width = 0;
+        height = 0;
+    }
+
+    game->scene_width = width;
+    game->scene_height = height;
+    return complete;
+}
+
+// Draw a scene (see render.h) into the bound, cleared framebuffer.
+static void
+game_draw_scene(struct game* game, const struct render_scene* scene)
+{
+    // opaque pass: front to back with blending off, so that everything
+    // hidden behind what's already drawn fails the depth test before shading
+    glDisable(GL_BLEND);
+
+    // draw the HUD (the font is solid white)
+    if (scene->hud != NULL) {
+        draw_hud(game, scene->hud, scene->hud_size, 0.5f);
+    }
+
+    // draw pipes (hard edges, alpha tested) and the background
+    for (long i = scene->count - 1; i >= 0; i--) {
+        if (scene->sprites[i].mode == RENDER_MODE_BLEND) continue;
+        draw_sprite(game, &scene->sprites[i]);
+    }
+
+    // transparent pass: back to front, tested against but not writing depth
+    glEnable(GL_BLEND);
+    glDepthMask(GL_FALSE);
+
+    // draw birds (the rival's ghost among them)
+    for (long i = 0; i < scene->count; i++) {
+        if (scene->sprites[i].mode != RENDER_MODE_BLEND) continue;
+        draw_sprite(game, &scene->sprites[i]);
+    }
+
+    // draw particles
+    draw_particles(game, scene->particles, scene->camera);
+
+    // depth writes must be on again for the next clear
+    glDepthMask(GL_TRUE);
 }
 
 void
@@ -323,46 +917,98 @@ game_render(struct game* game, long width, long height)
         width = height * ASPECT;
     }
 
-    // set viewport every frame (is this bad?)
-    glViewport(x_offset, y_offset, width, height);
+    if (width <= 0 || height <= 0) return;
+
+    // render the scene at a fraction of the viewport size when over budget
+    float scale = game->resolution.scale;
+    long scene_width = width * scale;
+    long scene_height = height * scale;
+    if (scene_width < 1) scene_width = 1;
+    if (scene_height < 1) scene_height = 1;
+
+    bool offscreen = scale < 1.0f && scene_target_resize(game, width, height);
+    if (offscreen) {
+        glBindFramebuffer(GL_FRAMEBUFFER, game->scene_framebuffer);
+        glViewport(0, 0, scene_width, scene_height);
+    } else {
+        // set viewport every frame (is this bad?)
+        glViewport(x_offset, y_offset, width, height);
+    }
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    const struct world* world = game_world(game);
+
+    // describe the frame (shared with the software renderer, see render.h)
+    const struct world* ghost = NULL;
+    if (game->race != NULL && world != &game->world) {
+        ghost = race_world(game->race, 1 - race_local(game->race));
+    }
+    struct render_scene scene;
+    render_scene_build(&scene, &game->frame, world, ghost, game->particles, glfwGetTime());
+
+    // the performance overlay goes out with the score, in the same draw
+    if (scene.hud != NULL && game->perf_overlay) {
+        scene.hud_size += perf_overlay_build(&game->perf, game->resolution.budget,
+            scene.hud + scene.hud_size / sizeof(float), RENDER_HUD_SIZE - scene.hud_size);
+    }
+    game_draw_scene(game, &scene);
+
+    // upscale the scene into the letterboxed viewport with a single blit
+    if (offscreen) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, game->scene_framebuffer);
+        glBlitFramebuffer(0, 0, scene_width, scene_height,
+            x_offset, y_offset, x_offset + width, y_offset + height,
+            GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+// Render one frame of the bot played demo (see demo.h) offscreen at exactly
+// width x height and save it as a PPM, read back with glReadPixels. The
+// frame is the same as flappy-render's frame number `frame` for the same
+// seed and size, so the GL and software backends can be compared directly.
+static bool
+game_dump_frame(struct game* game, struct course* course, unsigned int seed, long frame,
+    long width, long height, const char* path)
+{
+    struct demo* demo = demo_create(course, seed);
+    unsigned char* pixels = malloc(width * height * 4);
+    if (demo == NULL || pixels == NULL || !scene_target_resize(game, width, height)) {
+        if (pixels == NULL) fprintf(stderr, "failed to allocate frame\n");
+        free(pixels);
+        demo_destroy(demo);
+        return false;
+    }
+
+    for (long f = 0; f <= frame; f++) {
+        demo_step(demo);
+    }
 
+    glBindFramebuffer(GL_FRAMEBUFFER, game->scene_framebuffer);
+    glViewport(0, 0, width, height);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // draw background (scrolls independently of game objects)
-    double bg_scroll = glfwGetTime() * SCROLL;
-    double bg_offset = fmod(bg_scroll, 4.5);
-    for (float x = -9.0f; x <= 13.5f; x += 4.5f) {
-        draw_sprite(game, game->texture_bg,
-            x - bg_offset, 0.0f, BG_LAYER,
-            0.0f, BG_WIDTH, BG_HEIGHT);
-    }
-
-    // draw pipes (every 4.0f units starting at 0.0f)
-    for (float x = game->camera - 8.0f; x <= game->camera + 12.0f; x += 4.0f) {
-        if (x < 0.0f) continue;
-        long pipe_index = x / 4.0f;
-        float gap = game->pipes[pipe_index % PIPE_COUNT];
-        float top = gap + GAP;
-        float bot = gap - GAP;
-        float pipe_x = pipe_index * 4.0f;
-        draw_sprite(game, game->texture_pipe_top,
-            pipe_x - game->camera, top, PIPE_LAYER,
-            0.0f, PIPE_WIDTH, PIPE_HEIGHT);
-        draw_sprite(game, game->texture_pipe_bot,
-            pipe_x - game->camera, bot, PIPE_LAYER,
-            0.0f, PIPE_WIDTH, PIPE_HEIGHT);
-    }
-
-    // draw bird
-    draw_sprite(game, game->texture_bird,
-        game->bird_pos_x - game->camera, game->bird_pos_y, BIRD_LAYER,
-        game->bird_vel_y * 5.0f, BIRD_WIDTH, BIRD_HEIGHT);
-
-    // draw score
-    char score_text[16] = { 0 };
-    snprintf(score_text, 16, "%.3ld", game->score);
-    draw_text(game, score_text, -WIDTH / 2.0f + 1.0f, HEIGHT / 2.0f - 1.0f, 0.5f, 0.5f, 0.5f);
+    struct render_scene scene;
+    render_scene_build(&scene, &game->frame, &demo->world, NULL, demo->particles, demo->world.time);
+    game_draw_scene(game, &scene);
+    arena_reset(&game->frame);
+
+    // RGBA rows are always 4-byte aligned, bottom row first
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    bool ok = image_write_ppm(path, pixels, width, height);
+    if (ok) printf("Dumped frame %ld (seed %u, %ldx%ld) to %s\n", frame, seed, width, height, path);
+
+    free(pixels);
+    demo_destroy(demo);
+    return ok;
 }
 
 static void
@@ -374,13 +1020,333 @@ print_usage(const char* arg0)
     printf("  -h --help        print this help\n");
     printf("  -f --fullscreen  fullscreen window\n");
     printf("  -v --vsync       enable vsync\n");
+    printf("  -c --course FILE play a course file\n");
+    printf("  -s --stats FILE  keep run history in FILE\n");
+    printf("  -n --frames N    quit after N frames\n");
+    printf("  --render-scale S render at a fixed scale in [0.25, 1.0]\n");
+    printf("  --target-fps N   adapt the render scale to hold N fps (default: 60)\n");
+    printf("  --audit          fail if steady-state frames allocate\n");
+    printf("  --perf           show the performance overlay (toggle with F3)\n");
+    printf("  --metrics ADDR   export metrics on unix:PATH, tcp:PORT or file:PATH\n");
+    printf("  --idle-fps N     redraw rate when nothing moves (default: 10, 0: on input only)\n");
+    printf("  --no-idle        always redraw at full rate\n");
+    printf("  --assets DIR     load textures from the PNG and JPEG images in DIR\n");
+    printf("  --trajectory FILE log every step of every run (see scripts/trajectory.py)\n");
+    printf("\n");
+    printf("Frame dump options (compare with flappy-render, see scripts/frame_compare.py):\n");
+    printf("  --dump-frame N FILE  draw frame N of the bot played demo with GL, save it as PPM and quit\n");
+    printf("  --dump-size W H      size of the dumped frame (default: 256 144)\n");
+    printf("  --dump-seed SEED     world seed of the demo (default: 0)\n");
+    printf("\n");
+    printf("Race options:\n");
+    printf("  --host PORT      host a two player race\n");
+    printf("  --join HOST:PORT join a two player race\n");
+    printf("  --delay FRAMES   input delay, 0 to %d (default: 2)\n", ROLLBACK_MAX_DELAY);
+    printf("  --latency MS     add outgoing latency (testing)\n");
+    printf("  --loss PERCENT   drop outgoing packets (testing)\n");
+}
+
+// State shared between the window (main) thread and the frame loop thread.
+struct frame_loop {
+    GLFWwindow* window;
+    struct game* game;
+    bool vsync;
+    long frame_limit;  // stop after this many frames (0 for no limit)
+
+    // frames past warmup that allocated (see --audit)
+    bool audit;
+    long audit_failures;
+
+    // filled in up to the first frame, which prints it
+    struct startup* startup;
+
+    // redraw rate while the game is idle (0 for only on window events), or
+    // negative to never idle
+    double idle_fps;
+
+    // framebuffer size and a count of window events, updated by the window
+    // thread (which signals `wake` after every batch of events)
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    long events;
+    int width;
+    int height;
+};
+
+// Runs on the window thread as soon as the OS delivers a key, so the event
+// is stamped with the time it actually happened.
+static void
+key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    (void)scancode;
+    (void)mods;
+
+    if (action == GLFW_REPEAT) return;
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
+
+    struct game* game = glfwGetWindowUserPointer(window);
+    struct input_event event = {
+        .time = glfwGetTime(),
+        .key = key,
+        .action = action == GLFW_PRESS ? INPUT_PRESS : INPUT_RELEASE,
+    };
+    input_push(&game->input, &event);
+}
+
+// CPU seconds used by the calling thread alone (the frame loop shares the
+// process with the window, metrics, asset and trajectory threads).
+static double
+thread_cpu_time(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0.0;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The frame loop's idle deadlines are on the monotonic clock, so setting the
+// wall clock neither stalls nor spins the idle loop. macOS has no
+// pthread_condattr_setclock: it waits with a relative timeout instead.
+static void
+frame_loop_wake_init(pthread_cond_t* wake)
+{
+#ifndef __APPLE__
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(wake, &attr);
+    pthread_condattr_destroy(&attr);
+#else
+    pthread_cond_init(wake, NULL);
+#endif
+}
+
+// Wait on the wake condition for up to `wait` seconds from `start` (both
+// on the monotonic clock). Returns ETIMEDOUT once the time is up.
+static int
+frame_loop_wait(struct frame_loop* loop, const struct timespec* start, double wait)
+{
+#ifndef __APPLE__
+    struct timespec deadline = *start;
+    deadline.tv_sec += (time_t)wait;
+    deadline.tv_nsec += (long)((wait - (time_t)wait) * 1e9);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(&loop->wake, &loop->lock, &deadline);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double left = wait - ((now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9);
+    if (left <= 0.0) return ETIMEDOUT;
+    struct timespec timeout = { (time_t)left, (long)((left - (time_t)left) * 1e9) };
+    return pthread_cond_timedwait_relative_np(&loop->wake, &loop->lock, &timeout);
+#endif
+}
+
+// Sleep until the next idle frame is due (an idle frame interval after
+// `last_frame`) or until the window thread hands over an event, whichever
+// comes first. GLFW only waits for events on the main thread, so this waits
+// on the window thread instead. Returns the seconds spent asleep.
+static double
+frame_loop_idle(struct frame_loop* loop, double last_frame, long* events_seen)
+{
+    double start = glfwGetTime();
+    double wait = loop->idle_fps > 0.0 ? last_frame + 1.0 / loop->idle_fps - start : 0.0;
+    if (loop->idle_fps > 0.0 && wait <= 0.0) return 0.0;
+
+    struct timespec wait_start;
+    clock_gettime(CLOCK_MONOTONIC, &wait_start);
+
+    pthread_mutex_lock(&loop->lock);
+    while (loop->events == *events_seen && !glfwWindowShouldClose(loop->window)) {
+        if (loop->idle_fps == 0.0) {
+            pthread_cond_wait(&loop->wake, &loop->lock);
+        } else if (frame_loop_wait(loop, &wait_start, wait) == ETIMEDOUT) {
+            break;
+        }
+    }
+    *events_seen = loop->events;
+    pthread_mutex_unlock(&loop->lock);
+
+    return glfwGetTime() - start;
+}
+
+// Simulates and renders on its own thread while the main thread waits on
+// window events (GLFW only delivers those on the main thread).
+static void*
+frame_loop_run(void* arg)
+{
+    struct frame_loop* loop = arg;
+    struct game* game = loop->game;
+
+    glfwMakeContextCurrent(loop->window);
+    glfwSwapInterval(loop->vsync ? 1 : 0);
+
+    // timing vars
+    double last_second = glfwGetTime();
+    double last_frame = last_second;
+    long frame_count = 0;
+    long frame_total = 0;
+
+    // wall and CPU time (of this thread) of idle and of active frames, to
+    // report the savings
+    long events_seen = 0;
+    double asleep_second = 0.0;
+    double idle_wall = 0.0;
+    double idle_cpu = 0.0;
+    double active_wall = 0.0;
+    double active_cpu = 0.0;
+
+    // loop til exit or ESCAPE key
+    while (!glfwWindowShouldClose(loop->window)) {
+        double frame_start = glfwGetTime();
+        double frame_cpu = thread_cpu_time();
+
+        // only the background scrolls: redraw at the idle rate (or on input)
+        bool idle = loop->idle_fps >= 0.0 && game_idle(game);
+        if (idle) {
+            asleep_second += frame_loop_idle(loop, last_frame, &events_seen);
+        }
+
+        struct audit_counts before;
+        audit_read(&before);
+
+        double now = glfwGetTime();
+        double delta = now - last_frame;
+        last_frame = now;
+
+        // idle frames are slow on purpose, they say nothing about the budget
+        game_update(game, now, delta);
+        if (!idle) resolution_update(&game->resolution, delta);
+        double updated = glfwGetTime();
+
+        pthread_mutex_lock(&loop->lock);
+        int width = loop->width;
+        int height = loop->height;
+        pthread_mutex_unlock(&loop->lock);
+        game_render(game, width, height);
+        double rendered = glfwGetTime();
+
+        // shown by the overlay from the next frame on
+        struct audit_counts drawn;
+        audit_read(&drawn);
+        struct perf_sample sample = {
+            .frame = delta,
+            .update = updated - now,
+            .render = rendered - updated,
+            .draw_calls = drawn.draw_calls - before.draw_calls,
+        };
+        perf_record(&game->perf, &sample);
+        metric_add(game->metric_frames, 1);
+        metric_observe(game->metric_frame_seconds, delta);
+
+        frame_count++;
+        if (glfwGetTime() - last_second >= 1.0) {
+            metric_set(game->metric_fps, frame_count);
+            metric_set(game->metric_render_scale, game->resolution.scale);
+            metric_set(game->metric_idle, asleep_second);
+            printf("FPS: %ld  (%lf ms/frame)  render scale: %.0f%%\n",
+                frame_count, 1000.0/frame_count, game->resolution.scale * 100.0f);
+            if (asleep_second > 0.0) {
+                printf("Idle: %.0f%% of the last second asleep\n", asleep_second * 100.0);
+            }
+            asleep_second = 0.0;
+            if (game->input_latency_count > 0) {
+                printf("Input: %ld flaps  %.2lf ms avg  %.2lf ms max (key to screen)\n",
+                    game->input_latency_count,
+                    1000.0 * game->input_latency_sum / game->input_latency_count,
+                    1000.0 * game->input_latency_max);
+                game->input_latency_count = 0;
+                game->input_latency_sum = 0.0;
+                game->input_latency_max = 0.0;
+            }
+            if (game->race != NULL && game->race->rollback != NULL) {
+                printf("Race: %ld rollbacks  %ld frames resimulated  %ld stalls\n",
+                    game->race->rollback->rollbacks, game->race->rollback->resimulated, game->race->stalls);
+            }
+            frame_count = 0;
+            last_second += 1.0;
+        }
+
+        glfwSwapBuffers(loop->window);
+        game_present(game, glfwGetTime());
+        if (frame_total == 0) {
+            loop->startup->first_frame = startup_now();
+            startup_print(loop->startup);
+        }
+        arena_reset(&game->frame);
+
+        // steady-state frames must not touch the heap or create GL objects
+        struct audit_counts after;
+        audit_read(&after);
+        long allocations = after.allocations - before.allocations;
+        long gl_objects = after.gl_objects - before.gl_objects;
+        if (loop->audit && frame_total >= AUDIT_WARMUP_FRAMES && (allocations > 0 || gl_objects > 0)) {
+            fprintf(stderr, "audit: frame %ld made %ld heap allocations and %ld GL objects\n",
+                frame_total, allocations, gl_objects);
+            loop->audit_failures++;
+        }
+
+        double frame_wall = glfwGetTime() - frame_start;
+        double frame_cpu_seconds = thread_cpu_time() - frame_cpu;
+        if (idle) {
+            idle_wall += frame_wall;
+            idle_cpu += frame_cpu_seconds;
+        } else {
+            active_wall += frame_wall;
+            active_cpu += frame_cpu_seconds;
+        }
+
+        frame_total++;
+        if (loop->frame_limit > 0 && frame_total >= loop->frame_limit) break;
+    }
+
+    // CPU saved: what the idle time would have cost at the active rate
+    if (idle_wall > 0.0 && active_wall > 0.0) {
+        double active_rate = active_cpu / active_wall;
+        printf("Idle: %.1lf s at %.1lf%% CPU (%.1lf%% when active), about %.1lf CPU seconds saved\n",
+            idle_wall, 100.0 * idle_cpu / idle_wall, 100.0 * active_rate, idle_wall * active_rate - idle_cpu);
+    }
+
+    // let the window thread stop waiting
+    glfwMakeContextCurrent(NULL);
+    glfwSetWindowShouldClose(loop->window, GLFW_TRUE);
+    glfwPostEmptyEvent();
+    return NULL;
 }
 
 int
 main(int argc, char* argv[])
 {
+    struct startup startup = { 0 };
+    startup.launch = startup_now();
+
     bool fullscreen = false;
     bool vsync = false;
+    const char* course_path = NULL;
+    const char* stats_path = NULL;
+    const char* trajectory_path = NULL;
+    long frame_limit = 0;
+    float render_scale = 0.0f;
+    double target_fps = 60.0;
+    bool audit = false;
+    bool perf_overlay = false;
+    const char* metrics_address = NULL;
+    const char* race_host_port = NULL;
+    const char* race_join_address = NULL;
+    double idle_fps = IDLE_FPS;
+    const char* assets_dir = NULL;
+    long race_delay = 2;
+    double race_latency = 0.0;
+    double race_loss = 0.0;
+    const char* dump_path = NULL;
+    long dump_frame = 0;
+    long dump_width = 256;
+    long dump_height = 144;
+    unsigned int dump_seed = 0;
 
     // process CLI args and update corresponding flags
     for (int i = 1; i < argc; i++) {
@@ -394,6 +1360,148 @@ main(int argc, char* argv[])
         if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--vsync") == 0) {
             vsync = true;
         }
+        if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--course") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            course_path = argv[++i];
+        }
+        if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--stats") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            stats_path = argv[++i];
+        }
+        if (strcmp(argv[i], "--trajectory") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            trajectory_path = argv[++i];
+        }
+        if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--frames") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            frame_limit = atol(argv[++i]);
+        }
+        if (strcmp(argv[i], "--render-scale") == 0 || strcmp(argv[i], "--target-fps") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            const char* value = argv[i + 1];
+            if (strcmp(argv[i], "--render-scale") == 0) render_scale = atof(value);
+            if (strcmp(argv[i], "--target-fps") == 0) target_fps = atof(value);
+            if (render_scale < 0.0f || target_fps <= 0.0) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            i++;
+        }
+        if (strcmp(argv[i], "--audit") == 0) {
+            audit = true;
+        }
+        if (strcmp(argv[i], "--perf") == 0) {
+            perf_overlay = true;
+        }
+        if (strcmp(argv[i], "--idle-fps") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            idle_fps = atof(argv[++i]);
+            if (idle_fps < 0.0) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        if (strcmp(argv[i], "--no-idle") == 0) {
+            idle_fps = -1.0;
+        }
+        if (strcmp(argv[i], "--assets") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            assets_dir = argv[++i];
+        }
+        if (strcmp(argv[i], "--metrics") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            metrics_address = argv[++i];
+        }
+        if (strcmp(argv[i], "--dump-frame") == 0 || strcmp(argv[i], "--dump-size") == 0) {
+            if (i + 2 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (strcmp(argv[i], "--dump-frame") == 0) {
+                dump_frame = atol(argv[i + 1]);
+                dump_path = argv[i + 2];
+            } else {
+                dump_width = atol(argv[i + 1]);
+                dump_height = atol(argv[i + 2]);
+            }
+            if (dump_frame < 0 || dump_width < 1 || dump_height < 1) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            i += 2;
+        }
+        if (strcmp(argv[i], "--dump-seed") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            dump_seed = strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "--host") == 0 || strcmp(argv[i], "--join") == 0 ||
+            strcmp(argv[i], "--delay") == 0 || strcmp(argv[i], "--latency") == 0 ||
+            strcmp(argv[i], "--loss") == 0) {
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            const char* value = argv[i + 1];
+            if (strcmp(argv[i], "--host") == 0) race_host_port = value;
+            if (strcmp(argv[i], "--join") == 0) race_join_address = value;
+            if (strcmp(argv[i], "--delay") == 0) {
+                char* end;
+                errno = 0;
+                race_delay = strtol(value, &end, 10);
+                if (errno != 0 || end == value || *end != '\0' || race_delay < 0 || race_delay > ROLLBACK_MAX_DELAY) {
+                    fprintf(stderr, "--delay must be a whole number of frames within [0, %d]\n", ROLLBACK_MAX_DELAY);
+                    print_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            }
+            if (strcmp(argv[i], "--latency") == 0) race_latency = atof(value) / 1000.0;
+            if (strcmp(argv[i], "--loss") == 0) race_loss = atof(value) / 100.0;
+            i++;
+        }
+    }
+
+    struct course course = { 0 };
+    if (course_path != NULL && !course_open(&course, course_path)) {
+        return EXIT_FAILURE;
+    }
+
+    // decode textures in the background while GLFW and GL start up
+    static char asset_paths[ASSET_TEXTURE_COUNT][4096];
+    const char* asset_path_list[ASSET_TEXTURE_COUNT];
+    struct assets* assets = NULL;
+    if (assets_dir != NULL) {
+        for (long i = 0; i < ASSET_TEXTURE_COUNT; i++) {
+            snprintf(asset_paths[i], sizeof(asset_paths[i]), "%s/%s", assets_dir, ASSET_TEXTURE_FILES[i]);
+            asset_path_list[i] = asset_paths[i];
+        }
+        assets = assets_start(asset_path_list, ASSET_TEXTURE_COUNT, 0);
     }
 
     srand(time(NULL));
@@ -402,11 +1510,16 @@ main(int argc, char* argv[])
         const char* error = NULL;
         glfwGetError(&error);
         fprintf(stderr, "failed to init GLFW3: %s\n", error);
+        assets_destroy(assets);
         return EXIT_FAILURE;
     }
+    startup.glfw = startup_now();
 
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
+    // frame dumps render offscreen, the window only carries the context
+    if (dump_path != NULL) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     // ask for an OpenGL 3.3 Core profile
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -433,62 +1546,141 @@ main(int argc, char* argv[])
         glfwGetError(&error);
         fprintf(stderr, "failed to create GLFW3 window: %s\n", error);
 
+        assets_destroy(assets);
         glfwTerminate();
         return EXIT_FAILURE;
     }
 
-    glfwSetInputMode(window, GLFW_STICKY_KEYS, GLFW_TRUE);
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(vsync ? 1 : 0);
     opengl_load_functions();
+    startup.window = startup_now();
 
     printf("OpenGL Vendor:   %s\n", glGetString(GL_VENDOR));
     printf("OpenGL Renderer: %s\n", glGetString(GL_RENDERER));
     printf("OpenGL Version:  %s\n", glGetString(GL_VERSION));
     printf("GLSL Version:    %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 
-    glEnable(GL_BLEND);
+    // blending itself is toggled per render pass (see game_render)
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
 
     struct game game = { 0 };
-    game_init(&game);
+    game_init(&game, course_path != NULL ? &course : NULL);
+    startup.game = startup_now();
+    game_load_textures(&game, assets, &startup);
+    startup.textures = startup_now();
+    assets_destroy(assets);
+    resolution_init(&game.resolution, target_fps, render_scale);
+    game.perf_overlay = perf_overlay;
+
+    if (dump_path != NULL) {
+        bool ok = game_dump_frame(&game, course_path != NULL ? &course : NULL, dump_seed, dump_frame,
+            dump_width, dump_height, dump_path);
+        game_free(&game);
+        course_close(&course);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    // timing vars
-    double last_second = glfwGetTime();
-    double last_frame = last_second;
-    long frame_count = 0;
+    if (race_host_port != NULL) {
+        game.race = race_host(atoi(race_host_port), race_delay, course_path != NULL ? &course : NULL, rand());
+    } else if (race_join_address != NULL) {
+        game.race = race_join(race_join_address, race_delay, course_path != NULL ? &course : NULL);
+    }
+    if ((race_host_port != NULL || race_join_address != NULL) && game.race == NULL) {
+        game_free(&game);
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    if (game.race != NULL) {
+        race_simulate_network(game.race, race_latency, race_loss);
+    }
 
-    // loop til exit or ESCAPE key
-    while (!glfwWindowShouldClose(window)) {
-        double now = glfwGetTime();
-        double delta = now - last_frame;
-        last_frame = now;
+    if (stats_path != NULL) {
+        game.stats = stats_open(stats_path);
+        if (game.stats != NULL) {
+            struct stats_summary summary;
+            stats_summary(game.stats, &summary);
+            printf("Runs: %llu  Best: %lld\n", (unsigned long long)summary.runs, (long long)summary.best.score);
+        }
+    }
 
-        game_update(&game, window, delta);
+    if (trajectory_path != NULL) {
+        game.trajectory = trajectory_create(trajectory_path, 1);
+    }
+
+    if (metrics_address != NULL && game_metrics_init(&game, metrics_address)) {
+        printf("Metrics: %s\n", metrics_address);
+    }
+
+    // input arrives through callbacks on this thread from now on
+    glfwSetWindowUserPointer(window, &game);
+    glfwSetKeyCallback(window, key_callback);
+
+    // hand the context over to the frame loop
+    struct frame_loop loop = {
+        .window = window,
+        .game = &game,
+        .vsync = vsync,
+        .frame_limit = frame_limit,
+        .audit = audit,
+        .idle_fps = idle_fps,
+        .startup = &startup,
+    };
+    pthread_mutex_init(&loop.lock, NULL);
+    frame_loop_wake_init(&loop.wake);
+    glfwGetFramebufferSize(window, &loop.width, &loop.height);
+    glfwMakeContextCurrent(NULL);
+
+    pthread_t frame_thread;
+    bool frame_thread_started = pthread_create(&frame_thread, NULL, frame_loop_run, &loop) == 0;
+    if (!frame_thread_started) {
+        fprintf(stderr, "failed to start frame loop thread\n");
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
+
+    // wait on window events (and stamp them) while the frame loop runs
+    while (!glfwWindowShouldClose(window)) {
+        glfwWaitEvents();
 
         int width, height;
         glfwGetFramebufferSize(window, &width, &height);
-        game_render(&game, width, height);
+        pthread_mutex_lock(&loop.lock);
+        loop.width = width;
+        loop.height = height;
+        loop.events++;
+        pthread_cond_signal(&loop.wake);
+        pthread_mutex_unlock(&loop.lock);
+    }
 
-        frame_count++;
-        if (glfwGetTime() - last_second >= 1.0) {
-            printf("FPS: %ld  (%lf ms/frame)\n", frame_count, 1000.0/frame_count);
-            frame_count = 0;
-            last_second += 1.0;
-        }
+    if (frame_thread_started) pthread_join(frame_thread, NULL);
+    pthread_cond_destroy(&loop.wake);
+    pthread_mutex_destroy(&loop.lock);
+    glfwMakeContextCurrent(window);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    race_close(game.race);
+    stats_close(game.stats);
+    if (game.trajectory != NULL) {
+        struct trajectory_stats trajectory_stats;
+        trajectory_close(game.trajectory, &trajectory_stats);
+        printf("Trajectory: %ld rows, %ld bytes\n", trajectory_stats.rows, trajectory_stats.bytes);
     }
-
+    metrics_destroy(game.metrics);
     game_free(&game);
+    course_close(&course);
 
     // Cleanup GLFW3 resources
     glfwDestroyWindow(window);
     glfwTerminate();
 
+    if (loop.audit_failures > 0) {
+        fprintf(stderr, "audit: %ld steady-state frames allocated\n", loop.audit_failures);
+        return EXIT_FAILURE;
+    }
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,531 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "metrics.h"
+
+enum {
+    METRICS_TEXT_SIZE = 32 * 1024,
+    METRICS_REQUEST_SIZE = 4096,
+    METRICS_PATH_SIZE = 256,
+
+    // how often the exporter thread checks whether it should stop (ms)
+    METRICS_POLL_INTERVAL = 100,
+
+    // file exports are rewritten this often (ms)
+    METRICS_FILE_INTERVAL = 1000,
+};
+
+enum metrics_export {
+    METRICS_EXPORT_NONE = 0,
+    METRICS_EXPORT_UNIX,
+    METRICS_EXPORT_TCP,
+    METRICS_EXPORT_FILE,
+};
+
+struct metrics {
+    long count;
+    struct metric items[METRICS_CAPACITY];
+
+    // background exporter
+    enum metrics_export export;
+    char path[METRICS_PATH_SIZE];
+    int sock;
+    bool started;
+    int stop;
+    pthread_t thread;
+
+    // only touched by the exporter thread
+    char text[METRICS_TEXT_SIZE];
+};
+
+// Samples are recorded with relaxed atomics: every value is only ever read
+// whole, and nothing else is ordered against it.
+#if defined(__GNUC__)
+#define metrics_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define metrics_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define metrics_fetch_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#else
+#define metrics_load(p) (*(p))
+#define metrics_store(p, v) (*(p) = (v))
+#define metrics_fetch_add(p, v) (*(p) += (v))
+#endif
+
+static double
+metrics_load_double(const double* p)
+{
+#if defined(__GNUC__)
+    double value;
+    __atomic_load(p, &value, __ATOMIC_RELAXED);
+    return value;
+#else
+    return *(volatile const double*)p;
+#endif
+}
+
+static void
+metrics_store_double(double* p, double value)
+{
+#if defined(__GNUC__)
+    __atomic_store(p, &value, __ATOMIC_RELAXED);
+#else
+    *(volatile double*)p = value;
+#endif
+}
+
+static void
+metrics_add_double(double* p, double value)
+{
+#if defined(__GNUC__)
+    double old = metrics_load_double(p);
+    double sum = old + value;
+    while (!__atomic_compare_exchange(p, &old, &sum, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        sum = old + value;
+    }
+#else
+    *p += value;
+#endif
+}
+
+static void
+metrics_sleep(long ms)
+{
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+struct metrics*
+metrics_create(void)
+{
+    struct metrics* metrics = calloc(1, sizeof(*metrics));
+    if (metrics == NULL) {
+        fprintf(stderr, "failed to allocate metrics\n");
+        return NULL;
+    }
+
+    metrics->sock = -1;
+    return metrics;
+}
+
+void
+metrics_destroy(struct metrics* metrics)
+{
+    if (metrics == NULL) return;
+
+    if (metrics->started) {
+        metrics_store(&metrics->stop, 1);
+        pthread_join(metrics->thread, NULL);
+    }
+
+#ifndef _WIN32
+    if (metrics->sock >= 0) close(metrics->sock);
+    if (metrics->export == METRICS_EXPORT_UNIX) unlink(metrics->path);
+#endif
+
+    free(metrics);
+}
+
+static struct metric*
+metrics_register(struct metrics* metrics, const char* name, const char* help, enum metric_type type)
+{
+    assert(metrics != NULL);
+    assert(name != NULL);
+    assert(help != NULL);
+    assert(!metrics->started);
+
+    if (metrics->count >= METRICS_CAPACITY) {
+        fprintf(stderr, "too many metrics: %s\n", name);
+        return NULL;
+    }
+
+    struct metric* metric = &metrics->items[metrics->count++];
+    metric->name = name;
+    metric->help = help;
+    metric->type = type;
+    return metric;
+}
+
+struct metric*
+metrics_counter(struct metrics* metrics, const char* name, const char* help)
+{
+    return metrics_register(metrics, name, help, METRIC_COUNTER);
+}
+
+struct metric*
+metrics_gauge(struct metrics* metrics, const char* name, const char* help)
+{
+    return metrics_register(metrics, name, help, METRIC_GAUGE);
+}
+
+struct metric*
+metrics_histogram(struct metrics* metrics, const char* name, const char* help,
+    const double* bounds, long bounds_count)
+{
+    assert(bounds != NULL);
+    assert(bounds_count > 0 && bounds_count <= METRICS_MAX_BUCKETS);
+
+    struct metric* metric = metrics_register(metrics, name, help, METRIC_HISTOGRAM);
+    if (metric == NULL) return NULL;
+
+    metric->bounds_count = bounds_count;
+    for (long i = 0; i < bounds_count; i++) {
+        assert(i == 0 || bounds[i] > bounds[i - 1]);
+        metric->bounds[i] = bounds[i];
+    }
+    return metric;
+}
+
+void
+metric_add(struct metric* metric, unsigned long count)
+{
+    if (metric == NULL) return;
+    assert(metric->type == METRIC_COUNTER);
+    metrics_fetch_add(&metric->count, count);
+}
+
+void
+metric_set(struct metric* metric, double value)
+{
+    if (metric == NULL) return;
+    assert(metric->type == METRIC_GAUGE);
+    metrics_store_double(&metric->value, value);
+}
+
+void
+metric_observe(struct metric* metric, double value)
+{
+    if (metric == NULL) return;
+    assert(metric->type == METRIC_HISTOGRAM);
+
+    // only a handful of buckets: a linear scan beats a binary search
+    long bucket = 0;
+    while (bucket < metric->bounds_count && value > metric->bounds[bucket]) bucket++;
+
+    metrics_fetch_add(&metric->buckets[bucket], 1ul);
+    metrics_add_double(&metric->value, value);
+}
+
+// Resident set size of this process in bytes (-1 where unknown).
+static double
+metrics_resident_bytes(void)
+{
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f == NULL) return -1.0;
+
+    long pages = 0;
+    long resident = 0;
+    bool ok = fscanf(f, "%ld %ld", &pages, &resident) == 2;
+    fclose(f);
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (!ok || page_size <= 0) return -1.0;
+    return (double)resident * page_size;
+#else
+    return -1.0;
+#endif
+}
+
+static void
+metrics_append(char* buffer, long size, long* used, const char* format, ...)
+{
+    if (*used >= size) return;
+
+    va_list args;
+    va_start(args, format);
+    long n = vsnprintf(buffer + *used, size - *used, format, args);
+    va_end(args);
+
+    // a truncated export is dropped as a whole (see metrics_format)
+    *used = n < 0 ? size : *used + n;
+}
+
+// Write every metric in the Prometheus text format. Returns the length of
+// the text, or -1 if it doesn't fit.
+long
+metrics_format(struct metrics* metrics, char* buffer, long size)
+{
+    assert(metrics != NULL);
+    assert(buffer != NULL);
+
+    long used = 0;
+    for (long i = 0; i < metrics->count; i++) {
+        const struct metric* metric = &metrics->items[i];
+
+        switch (metric->type) {
+        case METRIC_COUNTER:
+            metrics_append(buffer, size, &used, "# HELP %s %s\n# TYPE %s counter\n%s %lu\n",
+                metric->name, metric->help, metric->name, metric->name, metrics_load(&metric->count));
+            break;
+        case METRIC_GAUGE:
+            metrics_append(buffer, size, &used, "# HELP %s %s\n# TYPE %s gauge\n%s %.9g\n",
+                metric->name, metric->help, metric->name, metric->name, metrics_load_double(&metric->value));
+            break;
+        case METRIC_HISTOGRAM: {
+            metrics_append(buffer, size, &used, "# HELP %s %s\n# TYPE %s histogram\n",
+                metric->name, metric->help, metric->name);
+
+            // buckets are exported cumulative, so +Inf is the total count
+            unsigned long cumulative = 0;
+            for (long b = 0; b < metric->bounds_count; b++) {
+                cumulative += metrics_load(&metric->buckets[b]);
+                metrics_append(buffer, size, &used, "%s_bucket{le=\"%.9g\"} %lu\n",
+                    metric->name, metric->bounds[b], cumulative);
+            }
+            cumulative += metrics_load(&metric->buckets[metric->bounds_count]);
+            metrics_append(buffer, size, &used, "%s_bucket{le=\"+Inf\"} %lu\n%s_sum %.9g\n%s_count %lu\n",
+                metric->name, cumulative,
+                metric->name, metrics_load_double(&metric->value),
+                metric->name, cumulative);
+            break;
+        }
+        }
+    }
+
+    double resident = metrics_resident_bytes();
+    if (resident >= 0.0) {
+        metrics_append(buffer, size, &used,
+            "# HELP process_resident_memory_bytes Resident memory size in bytes.\n"
+            "# TYPE process_resident_memory_bytes gauge\n"
+            "process_resident_memory_bytes %.0f\n", resident);
+    }
+
+    if (used >= size) return -1;
+    return used;
+}
+
+static void
+metrics_write_file(struct metrics* metrics)
+{
+    long length = metrics_format(metrics, metrics->text, METRICS_TEXT_SIZE);
+    if (length < 0) return;
+
+    // write aside and rename, so readers never see a partial file
+    char tmp[METRICS_PATH_SIZE + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", metrics->path);
+
+    FILE* f = fopen(tmp, "wb");
+    if (f == NULL) return;
+    bool ok = fwrite(metrics->text, 1, length, f) == (size_t)length;
+    ok = fclose(f) == 0 && ok;
+    if (!ok) return;
+
+#ifdef _WIN32
+    remove(metrics->path);
+#endif
+    rename(tmp, metrics->path);
+}
+
+#ifndef _WIN32
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static void
+metrics_send_all(int sock, const char* data, long size)
+{
+    while (size > 0) {
+        long sent = send(sock, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) return;
+        data += sent;
+        size -= sent;
+    }
+}
+
+// Answer one HTTP request (whatever it asks for) with the current metrics.
+static void
+metrics_respond(struct metrics* metrics, int client)
+{
+    // a stuck scraper only ever stalls this thread, and not for long
+    struct timeval timeout = { 1, 0 };
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    // read up to the end of the request headers
+    char request[METRICS_REQUEST_SIZE];
+    long received = 0;
+    while (received < (long)sizeof(request) - 1) {
+        long n = recv(client, request + received, sizeof(request) - 1 - received, 0);
+        if (n <= 0) break;
+        received += n;
+        request[received] = '\0';
+        if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL) break;
+    }
+
+    long length = metrics_format(metrics, metrics->text, METRICS_TEXT_SIZE);
+    if (length < 0) length = 0;
+
+    char header[128];
+    long header_length = snprintf(header, sizeof(header),
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: %ld\r\n"
+        "\r\n", length);
+    metrics_send_all(client, header, header_length);
+    metrics_send_all(client, metrics->text, length);
+}
+
+static bool
+metrics_listen(struct metrics* metrics, const char* address)
+{
+    if (metrics->export == METRICS_EXPORT_UNIX) {
+        struct sockaddr_un addr = { 0 };
+        addr.sun_family = AF_UNIX;
+        if (strlen(address) >= sizeof(addr.sun_path)) {
+            fprintf(stderr, "metrics socket path is too long: %s\n", address);
+            return false;
+        }
+        strcpy(addr.sun_path, address);
+
+        metrics->sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (metrics->sock < 0) {
+            fprintf(stderr, "failed to create metrics socket\n");
+            return false;
+        }
+
+        // replace the socket left behind by an earlier run
+        unlink(address);
+        if (bind(metrics->sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            fprintf(stderr, "failed to bind metrics socket: %s\n", address);
+            return false;
+        }
+    } else {
+        int port = atoi(address);
+        if (port <= 0 || port > 65535) {
+            fprintf(stderr, "invalid metrics port: %s\n", address);
+            return false;
+        }
+
+        metrics->sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (metrics->sock < 0) {
+            fprintf(stderr, "failed to create metrics socket\n");
+            return false;
+        }
+
+        int one = 1;
+        setsockopt(metrics->sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        // local scrapers only
+        struct sockaddr_in addr = { 0 };
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (bind(metrics->sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            fprintf(stderr, "failed to bind metrics port: %d\n", port);
+            return false;
+        }
+    }
+
+    if (listen(metrics->sock, 8) != 0) {
+        fprintf(stderr, "failed to listen for metrics scrapers\n");
+        return false;
+    }
+    return true;
+}
+
+#endif
+
+static void*
+metrics_run(void* arg)
+{
+    struct metrics* metrics = arg;
+
+    long since_write = METRICS_FILE_INTERVAL;
+    while (!metrics_load(&metrics->stop)) {
+        if (metrics->export == METRICS_EXPORT_FILE) {
+            if (since_write >= METRICS_FILE_INTERVAL) {
+                metrics_write_file(metrics);
+                since_write = 0;
+            }
+            metrics_sleep(METRICS_POLL_INTERVAL);
+            since_write += METRICS_POLL_INTERVAL;
+            continue;
+        }
+
+#ifndef _WIN32
+        struct pollfd pfd = { .fd = metrics->sock, .events = POLLIN };
+        if (poll(&pfd, 1, METRICS_POLL_INTERVAL) <= 0) continue;
+
+        int client = accept(metrics->sock, NULL, NULL);
+        if (client < 0) continue;
+        metrics_respond(metrics, client);
+        close(client);
+#endif
+    }
+
+    // leave the final values behind
+    if (metrics->export == METRICS_EXPORT_FILE) metrics_write_file(metrics);
+    return NULL;
+}
+
+// Start exporting on `address` (see metrics.h) from a background thread.
+bool
+metrics_serve(struct metrics* metrics, const char* address)
+{
+    assert(metrics != NULL);
+    assert(address != NULL);
+    assert(!metrics->started);
+
+    const char* colon = strchr(address, ':');
+    const char* target = colon != NULL ? colon + 1 : "";
+    long scheme = colon != NULL ? colon - address : 0;
+    if (strlen(target) >= METRICS_PATH_SIZE) {
+        fprintf(stderr, "metrics address is too long: %s\n", address);
+        return false;
+    }
+
+    if (scheme == 4 && strncmp(address, "file", 4) == 0) {
+        metrics->export = METRICS_EXPORT_FILE;
+    } else if (scheme == 4 && strncmp(address, "unix", 4) == 0) {
+        metrics->export = METRICS_EXPORT_UNIX;
+    } else if (scheme == 3 && strncmp(address, "tcp", 3) == 0) {
+        metrics->export = METRICS_EXPORT_TCP;
+    } else {
+        fprintf(stderr, "invalid metrics address (expected unix:PATH, tcp:PORT or file:PATH): %s\n", address);
+        return false;
+    }
+    strcpy(metrics->path, target);
+
+    if (metrics->export != METRICS_EXPORT_FILE) {
+#ifdef _WIN32
+        fprintf(stderr, "metrics sockets are not supported on this platform, use file:PATH\n");
+        return false;
+#else
+        if (!metrics_listen(metrics, target)) return false;
+#endif
+    }
+
+    if (pthread_create(&metrics->thread, NULL, metrics_run, metrics) != 0) {
+        fprintf(stderr, "failed to start metrics thread\n");
+        return false;
+    }
+
+    metrics->started = true;
+    return true;
+}
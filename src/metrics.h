@@ -0,0 +1,62 @@
+#ifndef FLAPPY_METRICS_H_INCLUDED
+#define FLAPPY_METRICS_H_INCLUDED
+
+#include <stdbool.h>
+
+// Live metrics in the Prometheus text format. Counters, gauges, and
+// fixed-bucket histograms are registered once at startup and then updated
+// from the hot loop with relaxed atomics (no locks, a few nanoseconds per
+// sample). A background thread exports them on one of:
+//
+//   unix:PATH   HTTP on a Unix socket
+//   tcp:PORT    HTTP on 127.0.0.1:PORT (Unix only as well)
+//   file:PATH   rewritten every second (e.g. for a textfile collector)
+//
+// Every update function ignores a NULL metric, so call sites need not check
+// whether metrics are enabled at all.
+
+enum {
+    METRICS_CAPACITY = 32,
+    METRICS_MAX_BUCKETS = 16,
+};
+
+enum metric_type {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+};
+
+struct metric {
+    const char* name;
+    const char* help;
+    enum metric_type type;
+
+    unsigned long count;  // counter value, or observations for a histogram
+    double value;         // gauge value, or sum of observations
+
+    // histogram only: upper bounds (ascending) and the observations that
+    // fell into each of them (not cumulative, the last one is +Inf)
+    long bounds_count;
+    double bounds[METRICS_MAX_BUCKETS];
+    unsigned long buckets[METRICS_MAX_BUCKETS + 1];
+};
+
+struct metrics;
+
+struct metrics* metrics_create(void);
+void metrics_destroy(struct metrics* metrics);
+
+// registration is not thread-safe: do it all before metrics_serve
+struct metric* metrics_counter(struct metrics* metrics, const char* name, const char* help);
+struct metric* metrics_gauge(struct metrics* metrics, const char* name, const char* help);
+struct metric* metrics_histogram(struct metrics* metrics, const char* name, const char* help,
+    const double* bounds, long bounds_count);
+
+void metric_add(struct metric* metric, unsigned long count);
+void metric_set(struct metric* metric, double value);
+void metric_observe(struct metric* metric, double value);  // one thread at a time
+
+long metrics_format(struct metrics* metrics, char* buffer, long size);
+bool metrics_serve(struct metrics* metrics, const char* address);
+
+#endif
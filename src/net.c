@@ -0,0 +1,237 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET net_socket;
+#define NET_INVALID_SOCKET INVALID_SOCKET
+#define net_close_socket closesocket
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int net_socket;
+#define NET_INVALID_SOCKET -1
+#define net_close_socket close
+#endif
+
+#include "net.h"
+
+struct net_packet {
+    double due;
+    long size;
+    unsigned char data[NET_PACKET_SIZE];
+};
+
+struct net {
+    net_socket sock;
+
+    bool connected;
+    struct sockaddr_storage peer;
+    socklen_t peer_size;
+
+    // injected network conditions
+    double latency;
+    double loss;
+    unsigned int seed;
+
+    // packets held back by the injected latency (FIFO)
+    long queue_head;
+    long queue_count;
+    struct net_packet queue[NET_QUEUE_SIZE];
+};
+
+static double
+net_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+net_random(struct net* net)
+{
+    net->seed = net->seed * 1103515245u + 12345u;
+    return (double)((net->seed >> 8) & 0xffffff) / (double)0x1000000;
+}
+
+struct net*
+net_open(unsigned short port)
+{
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        fprintf(stderr, "failed to init winsock\n");
+        return NULL;
+    }
+#endif
+
+    struct net* net = calloc(1, sizeof(*net));
+    if (net == NULL) {
+        fprintf(stderr, "failed to allocate net\n");
+        return NULL;
+    }
+
+    net->seed = (unsigned int)time(NULL);
+    net->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (net->sock == NET_INVALID_SOCKET) {
+        fprintf(stderr, "failed to create UDP socket\n");
+        free(net);
+        return NULL;
+    }
+
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(net->sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "failed to bind UDP port: %u\n", port);
+        net_close(net);
+        return NULL;
+    }
+
+    // never block the frame loop
+#ifdef _WIN32
+    u_long nonblocking = 1;
+    ioctlsocket(net->sock, FIONBIO, &nonblocking);
+#else
+    fcntl(net->sock, F_SETFL, fcntl(net->sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    return net;
+}
+
+void
+net_close(struct net* net)
+{
+    if (net == NULL) return;
+
+    net_close_socket(net->sock);
+    free(net);
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+// Resolve "host:port" and send everything there from now on.
+bool
+net_connect(struct net* net, const char* address)
+{
+    assert(net != NULL);
+    assert(address != NULL);
+
+    char host[256] = { 0 };
+    const char* colon = strrchr(address, ':');
+    if (colon == NULL || colon - address >= (long)sizeof(host)) {
+        fprintf(stderr, "invalid address (expected host:port): %s\n", address);
+        return false;
+    }
+    memcpy(host, address, colon - address);
+
+    struct addrinfo hints = { 0 };
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo* info = NULL;
+    if (getaddrinfo(host, colon + 1, &hints, &info) != 0 || info == NULL) {
+        fprintf(stderr, "failed to resolve address: %s\n", address);
+        return false;
+    }
+
+    memcpy(&net->peer, info->ai_addr, info->ai_addrlen);
+    net->peer_size = info->ai_addrlen;
+    net->connected = true;
+    freeaddrinfo(info);
+    return true;
+}
+
+// Latency is in seconds (one way), loss is a fraction of packets [0.0, 1.0].
+void
+net_simulate(struct net* net, double latency, double loss)
+{
+    assert(net != NULL);
+    net->latency = latency;
+    net->loss = loss;
+}
+
+static void
+net_flush(struct net* net)
+{
+    double now = net_now();
+    while (net->queue_count > 0) {
+        struct net_packet* packet = &net->queue[net->queue_head];
+        if (packet->due > now) break;
+
+        sendto(net->sock, (const char*)packet->data, packet->size, 0, (struct sockaddr*)&net->peer, net->peer_size);
+        net->queue_head = (net->queue_head + 1) % NET_QUEUE_SIZE;
+        net->queue_count--;
+    }
+}
+
+bool
+net_send(struct net* net, const void* data, long size)
+{
+    assert(net != NULL);
+    assert(data != NULL);
+    assert(size <= NET_PACKET_SIZE);
+
+    if (!net->connected) return false;
+
+    if (net->loss > 0.0 && net_random(net) < net->loss) {
+        net_flush(net);
+        return true;
+    }
+
+    if (net->latency <= 0.0) {
+        net_flush(net);
+        sendto(net->sock, (const char*)data, size, 0, (struct sockaddr*)&net->peer, net->peer_size);
+        return true;
+    }
+
+    // hold the packet back; drop it if the queue is full (it's UDP after all)
+    if (net->queue_count < NET_QUEUE_SIZE) {
+        struct net_packet* packet = &net->queue[(net->queue_head + net->queue_count) % NET_QUEUE_SIZE];
+        packet->due = net_now() + net->latency;
+        packet->size = size;
+        memcpy(packet->data, data, size);
+        net->queue_count++;
+    }
+
+    net_flush(net);
+    return true;
+}
+
+// Returns the size of the next datagram (0 when there is none). The first
+// sender becomes the peer if none was given with net_connect.
+long
+net_recv(struct net* net, void* data, long size)
+{
+    assert(net != NULL);
+    assert(data != NULL);
+
+    net_flush(net);
+
+    struct sockaddr_storage from;
+    socklen_t from_size = sizeof(from);
+    long received = recvfrom(net->sock, (char*)data, size, 0, (struct sockaddr*)&from, &from_size);
+    if (received <= 0) return 0;
+
+    if (!net->connected) {
+        net->peer = from;
+        net->peer_size = from_size;
+        net->connected = true;
+    }
+
+    return received;
+}
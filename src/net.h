@@ -0,0 +1,26 @@
+#ifndef FLAPPY_NET_H_INCLUDED
+#define FLAPPY_NET_H_INCLUDED
+
+#include <stdbool.h>
+
+// Minimal non-blocking UDP endpoint talking to a single peer. For testing on
+// localhost it can hold outgoing packets back (latency) and throw some away
+// (loss) before they ever reach the socket.
+
+enum {
+    NET_PACKET_SIZE = 512,
+    NET_QUEUE_SIZE = 256,
+};
+
+struct net;
+
+struct net* net_open(unsigned short port);
+void net_close(struct net* net);
+
+bool net_connect(struct net* net, const char* address);
+void net_simulate(struct net* net, double latency, double loss);
+
+bool net_send(struct net* net, const void* data, long size);
+long net_recv(struct net* net, void* data, long size);
+
+#endif
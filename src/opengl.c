@@ -5,6 +5,7 @@
 #include <GL/glcorearb.h>
 #include <GLFW/glfw3.h>
 
+#include "audit.h"
 #include "opengl.h"
 
 // Define an OpenGL function. Until dynamically loaded, it will
@@ -54,6 +55,64 @@ OPENGL_FUNCTIONS
         return false;                                              \
     }
 
+// Object creation is routed through counting wrappers so that the allocation
+// audit (see audit.h) can catch GL objects being made every frame.
+//
+// OPENGL_AUDIT_GEN(glGenBuffers, PFNGLGENBUFFERSPROC)
+//
+//   defines glGenBuffers_real (the loaded entry point) and glGenBuffers_audit
+//   (which counts, then calls the real one).
+#define OPENGL_AUDIT_GEN(func_name, func_type)                      \
+    static func_type func_name##_real = NULL;                       \
+    static void APIENTRY func_name##_audit(GLsizei n, GLuint* ids)  \
+    {                                                               \
+        audit_count_gl_objects(n);                                  \
+        func_name##_real(n, ids);                                   \
+    }
+
+OPENGL_AUDIT_GEN(glGenBuffers, PFNGLGENBUFFERSPROC)
+OPENGL_AUDIT_GEN(glGenVertexArrays, PFNGLGENVERTEXARRAYSPROC)
+OPENGL_AUDIT_GEN(glGenTextures, PFNGLGENTEXTURESPROC)
+OPENGL_AUDIT_GEN(glGenFramebuffers, PFNGLGENFRAMEBUFFERSPROC)
+OPENGL_AUDIT_GEN(glGenRenderbuffers, PFNGLGENRENDERBUFFERSPROC)
+
+static PFNGLCREATESHADERPROC glCreateShader_real = NULL;
+static GLuint APIENTRY
+glCreateShader_audit(GLenum type)
+{
+    audit_count_gl_objects(1);
+    return glCreateShader_real(type);
+}
+
+static PFNGLCREATEPROGRAMPROC glCreateProgram_real = NULL;
+static GLuint APIENTRY
+glCreateProgram_audit(void)
+{
+    audit_count_gl_objects(1);
+    return glCreateProgram_real();
+}
+
+// Draw calls are counted the same way (for the performance overlay).
+static PFNGLDRAWARRAYSPROC glDrawArrays_real = NULL;
+static void APIENTRY
+glDrawArrays_audit(GLenum mode, GLint first, GLsizei count)
+{
+    audit_count_draw_call();
+    glDrawArrays_real(mode, first, count);
+}
+
+static PFNGLDRAWARRAYSINSTANCEDPROC glDrawArraysInstanced_real = NULL;
+static void APIENTRY
+glDrawArraysInstanced_audit(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+    audit_count_draw_call();
+    glDrawArraysInstanced_real(mode, first, count, instancecount);
+}
+
+#define OPENGL_AUDIT(func_name)          \
+    func_name##_real = func_name;        \
+    func_name = func_name##_audit;
+
 bool
 opengl_load_functions(void)
 {
@@ -68,5 +127,15 @@ opengl_load_functions(void)
     OPENGL_FUNCTIONS
     #undef OPENGL_FUNCTION
 
+    OPENGL_AUDIT(glGenBuffers)
+    OPENGL_AUDIT(glGenVertexArrays)
+    OPENGL_AUDIT(glGenTextures)
+    OPENGL_AUDIT(glGenFramebuffers)
+    OPENGL_AUDIT(glGenRenderbuffers)
+    OPENGL_AUDIT(glCreateShader)
+    OPENGL_AUDIT(glCreateProgram)
+    OPENGL_AUDIT(glDrawArrays)
+    OPENGL_AUDIT(glDrawArraysInstanced)
+
     return true;
 }
@@ -19,10 +19,13 @@
     OPENGL_FUNCTION(glClear, PFNGLCLEARPROC)                                        \
     OPENGL_FUNCTION(glClearColor, PFNGLCLEARCOLORPROC)                              \
     OPENGL_FUNCTION(glEnable, PFNGLENABLEPROC)                                      \
+    OPENGL_FUNCTION(glDisable, PFNGLDISABLEPROC)                                    \
     OPENGL_FUNCTION(glDepthFunc, PFNGLDEPTHFUNCPROC)                                \
+    OPENGL_FUNCTION(glDepthMask, PFNGLDEPTHMASKPROC)                                \
     OPENGL_FUNCTION(glCullFace, PFNGLCULLFACEPROC)                                  \
     OPENGL_FUNCTION(glBlendFunc, PFNGLBLENDFUNCPROC)                                \
     OPENGL_FUNCTION(glDrawArrays, PFNGLDRAWARRAYSPROC)                              \
+    OPENGL_FUNCTION(glDrawArraysInstanced, PFNGLDRAWARRAYSINSTANCEDPROC)            \
     OPENGL_FUNCTION(glCreateShader, PFNGLCREATESHADERPROC)                          \
     OPENGL_FUNCTION(glDeleteShader, PFNGLDELETESHADERPROC)                          \
     OPENGL_FUNCTION(glAttachShader, PFNGLATTACHSHADERPROC)                          \
@@ -41,25 +44,44 @@
     OPENGL_FUNCTION(glUniform1i, PFNGLUNIFORM1IPROC)                                \
     OPENGL_FUNCTION(glUniform1f, PFNGLUNIFORM1FPROC)                                \
     OPENGL_FUNCTION(glUniform3f, PFNGLUNIFORM3FPROC)                                \
+    OPENGL_FUNCTION(glUniform4f, PFNGLUNIFORM4FPROC)                                \
     OPENGL_FUNCTION(glUniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC)                  \
     OPENGL_FUNCTION(glGetUniformLocation, PFNGLGETUNIFORMLOCATIONPROC)              \
     OPENGL_FUNCTION(glGenBuffers, PFNGLGENBUFFERSPROC)                              \
     OPENGL_FUNCTION(glDeleteBuffers, PFNGLDELETEBUFFERSPROC)                        \
     OPENGL_FUNCTION(glBindBuffer, PFNGLBINDBUFFERPROC)                              \
     OPENGL_FUNCTION(glBufferData, PFNGLBUFFERDATAPROC)                              \
+    OPENGL_FUNCTION(glBufferSubData, PFNGLBUFFERSUBDATAPROC)                        \
+    OPENGL_FUNCTION(glMapBufferRange, PFNGLMAPBUFFERRANGEPROC)                      \
+    OPENGL_FUNCTION(glUnmapBuffer, PFNGLUNMAPBUFFERPROC)                            \
     OPENGL_FUNCTION(glGenVertexArrays, PFNGLGENVERTEXARRAYSPROC)                    \
     OPENGL_FUNCTION(glDeleteVertexArrays, PFNGLDELETEVERTEXARRAYSPROC)              \
     OPENGL_FUNCTION(glBindVertexArray, PFNGLBINDVERTEXARRAYPROC)                    \
     OPENGL_FUNCTION(glVertexAttribPointer, PFNGLVERTEXATTRIBPOINTERPROC)            \
     OPENGL_FUNCTION(glEnableVertexAttribArray, PFNGLENABLEVERTEXATTRIBARRAYPROC)    \
     OPENGL_FUNCTION(glDisableVertexAttribArray, PFNGLDISABLEVERTEXATTRIBARRAYPROC)  \
+    OPENGL_FUNCTION(glVertexAttribDivisor, PFNGLVERTEXATTRIBDIVISORPROC)            \
+    OPENGL_FUNCTION(glVertexAttrib4f, PFNGLVERTEXATTRIB4FPROC)                      \
     OPENGL_FUNCTION(glGenTextures, PFNGLGENTEXTURESPROC)                            \
     OPENGL_FUNCTION(glDeleteTextures, PFNGLDELETETEXTURESPROC)                      \
     OPENGL_FUNCTION(glBindTexture, PFNGLBINDTEXTUREPROC)                            \
     OPENGL_FUNCTION(glActiveTexture, PFNGLACTIVETEXTUREPROC)                        \
     OPENGL_FUNCTION(glTexImage2D, PFNGLTEXIMAGE2DPROC)                              \
+    OPENGL_FUNCTION(glPixelStorei, PFNGLPIXELSTOREIPROC)                            \
+    OPENGL_FUNCTION(glReadPixels, PFNGLREADPIXELSPROC)                              \
     OPENGL_FUNCTION(glGenerateMipmap, PFNGLGENERATEMIPMAPPROC)                      \
     OPENGL_FUNCTION(glTexParameteri, PFNGLTEXPARAMETERIPROC)                        \
+    OPENGL_FUNCTION(glGenFramebuffers, PFNGLGENFRAMEBUFFERSPROC)                    \
+    OPENGL_FUNCTION(glDeleteFramebuffers, PFNGLDELETEFRAMEBUFFERSPROC)              \
+    OPENGL_FUNCTION(glBindFramebuffer, PFNGLBINDFRAMEBUFFERPROC)                    \
+    OPENGL_FUNCTION(glFramebufferTexture2D, PFNGLFRAMEBUFFERTEXTURE2DPROC)          \
+    OPENGL_FUNCTION(glFramebufferRenderbuffer, PFNGLFRAMEBUFFERRENDERBUFFERPROC)    \
+    OPENGL_FUNCTION(glCheckFramebufferStatus, PFNGLCHECKFRAMEBUFFERSTATUSPROC)      \
+    OPENGL_FUNCTION(glBlitFramebuffer, PFNGLBLITFRAMEBUFFERPROC)                    \
+    OPENGL_FUNCTION(glGenRenderbuffers, PFNGLGENRENDERBUFFERSPROC)                  \
+    OPENGL_FUNCTION(glDeleteRenderbuffers, PFNGLDELETERENDERBUFFERSPROC)            \
+    OPENGL_FUNCTION(glBindRenderbuffer, PFNGLBINDRENDERBUFFERPROC)                  \
+    OPENGL_FUNCTION(glRenderbufferStorage, PFNGLRENDERBUFFERSTORAGEPROC)            \
     OPENGL_FUNCTION(glPolygonMode, PFNGLPOLYGONMODEPROC)
 
 // Declare an OpenGL function. Other translation units that require
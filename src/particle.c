@@ -0,0 +1,169 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "particle.h"
+
+#ifndef M_PI
+#define M_PI 3.141592653589793
+#endif
+
+// Use GCC / Clang vector extensions when available: they lower to SSE on x86
+// and NEON on ARM without tying the code to either instruction set.
+#if defined(__GNUC__)
+#define PARTICLE_SIMD 1
+typedef float v4sf __attribute__((vector_size(16)));
+#else
+#define PARTICLE_SIMD 0
+#endif
+
+// xorshift32, returns [0.0, 1.0]
+static float
+particle_random(struct particle_pool* pool)
+{
+    unsigned int x = pool->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pool->seed = x;
+    return (float)(x & 0xffffff) / (float)0xffffff;
+}
+
+struct particle_pool*
+particle_pool_create(unsigned int seed)
+{
+    struct particle_pool* pool = calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        fprintf(stderr, "failed to allocate particle pool\n");
+        return NULL;
+    }
+
+    pool->count = 0;
+    pool->seed = seed != 0 ? seed : 1;
+    return pool;
+}
+
+void
+particle_pool_destroy(struct particle_pool* pool)
+{
+    free(pool);
+}
+
+void
+particle_clear(struct particle_pool* pool)
+{
+    assert(pool != NULL);
+    pool->count = 0;
+}
+
+long
+particle_emit(struct particle_pool* pool, float x, float y, long count, float speed, float life, float size)
+{
+    assert(pool != NULL);
+
+    // drop what doesn't fit rather than evicting live particles
+    if (count > PARTICLE_CAPACITY - pool->count) {
+        count = PARTICLE_CAPACITY - pool->count;
+    }
+
+    for (long n = 0; n < count; n++) {
+        long i = pool->count++;
+        float angle = particle_random(pool) * 2.0f * M_PI;
+        float magnitude = speed * (0.5f + 0.5f * particle_random(pool));
+        float lifetime = life * (0.5f + 0.5f * particle_random(pool));
+
+        pool->pos_x[i] = x;
+        pool->pos_y[i] = y;
+        pool->vel_x[i] = cosf(angle) * magnitude;
+        pool->vel_y[i] = sinf(angle) * magnitude;
+        pool->life[i] = lifetime;
+        pool->fade[i] = 1.0f / lifetime;
+        pool->size[i] = size * (0.5f + 0.5f * particle_random(pool));
+    }
+
+    return count;
+}
+
+static void
+particle_integrate(struct particle_pool* pool, float gravity, float delta)
+{
+#if PARTICLE_SIMD
+    // round up to whole vectors: lanes past count are scratch (the capacity
+    // is a multiple of four) and get overwritten by the next emit
+    long count = (pool->count + 3) & ~3L;
+
+    v4sf dt = { delta, delta, delta, delta };
+    v4sf dv = { gravity * delta, gravity * delta, gravity * delta, gravity * delta };
+    for (long i = 0; i < count; i += 4) {
+        v4sf px, py, vx, vy, life;
+        memcpy(&px, &pool->pos_x[i], sizeof(px));
+        memcpy(&py, &pool->pos_y[i], sizeof(py));
+        memcpy(&vx, &pool->vel_x[i], sizeof(vx));
+        memcpy(&vy, &pool->vel_y[i], sizeof(vy));
+        memcpy(&life, &pool->life[i], sizeof(life));
+
+        vy -= dv;
+        px += vx * dt;
+        py += vy * dt;
+        life -= dt;
+
+        memcpy(&pool->pos_x[i], &px, sizeof(px));
+        memcpy(&pool->pos_y[i], &py, sizeof(py));
+        memcpy(&pool->vel_y[i], &vy, sizeof(vy));
+        memcpy(&pool->life[i], &life, sizeof(life));
+    }
+#else
+    long count = pool->count;
+    for (long i = 0; i < count; i++) {
+        pool->vel_y[i] -= gravity * delta;
+        pool->pos_x[i] += pool->vel_x[i] * delta;
+        pool->pos_y[i] += pool->vel_y[i] * delta;
+        pool->life[i] -= delta;
+    }
+#endif
+}
+
+void
+particle_update(struct particle_pool* pool, float gravity, float delta)
+{
+    assert(pool != NULL);
+
+    particle_integrate(pool, gravity, delta);
+
+    // swap-remove expired particles to keep the live ones packed
+    long i = 0;
+    while (i < pool->count) {
+        if (pool->life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+
+        long last = --pool->count;
+        pool->pos_x[i] = pool->pos_x[last];
+        pool->pos_y[i] = pool->pos_y[last];
+        pool->vel_x[i] = pool->vel_x[last];
+        pool->vel_y[i] = pool->vel_y[last];
+        pool->life[i] = pool->life[last];
+        pool->fade[i] = pool->fade[last];
+        pool->size[i] = pool->size[last];
+    }
+}
+
+long
+particle_instances(const struct particle_pool* pool, float* buffer, long capacity)
+{
+    assert(pool != NULL);
+    assert(buffer != NULL);
+
+    long count = pool->count < capacity ? pool->count : capacity;
+    for (long i = 0; i < count; i++) {
+        *buffer++ = pool->pos_x[i];
+        *buffer++ = pool->pos_y[i];
+        *buffer++ = pool->size[i];
+        *buffer++ = pool->life[i] * pool->fade[i];
+    }
+
+    return count;
+}
@@ -0,0 +1,42 @@
+#ifndef FLAPPY_PARTICLE_H_INCLUDED
+#define FLAPPY_PARTICLE_H_INCLUDED
+
+// Fixed-capacity particle pool stored as structure-of-arrays. Live particles
+// are always packed into [0, count) so updates stream through memory and the
+// render path can copy them into a single instance buffer.
+
+enum {
+    PARTICLE_CAPACITY = 131072,
+
+    // x, y, scale, alpha (matches a_instance in sprite_vert.glsl)
+    PARTICLE_FLOATS_PER_INSTANCE = 4,
+};
+
+#if defined(__GNUC__)
+#define PARTICLE_ALIGN __attribute__((aligned(16)))
+#else
+#define PARTICLE_ALIGN
+#endif
+
+struct particle_pool {
+    long count;
+    unsigned int seed;
+
+    float pos_x[PARTICLE_CAPACITY] PARTICLE_ALIGN;
+    float pos_y[PARTICLE_CAPACITY] PARTICLE_ALIGN;
+    float vel_x[PARTICLE_CAPACITY] PARTICLE_ALIGN;
+    float vel_y[PARTICLE_CAPACITY] PARTICLE_ALIGN;
+    float life[PARTICLE_CAPACITY] PARTICLE_ALIGN;  // seconds remaining
+    float fade[PARTICLE_CAPACITY] PARTICLE_ALIGN;  // 1.0 / initial life
+    float size[PARTICLE_CAPACITY] PARTICLE_ALIGN;
+};
+
+struct particle_pool* particle_pool_create(unsigned int seed);
+void particle_pool_destroy(struct particle_pool* pool);
+
+void particle_clear(struct particle_pool* pool);
+long particle_emit(struct particle_pool* pool, float x, float y, long count, float speed, float life, float size);
+void particle_update(struct particle_pool* pool, float gravity, float delta);
+long particle_instances(const struct particle_pool* pool, float* buffer, long capacity);
+
+#endif
@@ -0,0 +1,137 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "font.h"
+#include "perf.h"
+
+// overlay layout, in view units (the top right corner of the WIDTH x HEIGHT
+// view centered on the origin)
+static const float PERF_LEFT = 2.5f;
+static const float PERF_RIGHT = 7.5f;
+static const float PERF_TEXT_TOP = 4.0f;
+static const float PERF_TEXT_SCALE = 0.3f;
+static const float PERF_LINE_SPACING = 0.4f;
+static const float PERF_GRAPH_BOTTOM = 1.0f;
+static const float PERF_GRAPH_HEIGHT = 1.6f;
+static const float PERF_BUDGET_LINE = 0.02f;
+
+// keep printed numbers within what the font can draw (and PERF_OVERLAY_SIZE)
+static const float PERF_MAX_MS = 9999.0f;
+static const long PERF_MAX_DRAW_CALLS = 99999;
+
+void
+perf_record(struct perf* perf, const struct perf_sample* sample)
+{
+    assert(perf != NULL);
+    assert(sample != NULL);
+
+    perf->samples[perf->next] = *sample;
+    perf->next = (perf->next + 1) % PERF_HISTORY;
+    if (perf->count < PERF_HISTORY) perf->count++;
+}
+
+// Longest frame time within the history (seconds).
+float
+perf_worst(const struct perf* perf)
+{
+    assert(perf != NULL);
+
+    float worst = 0.0f;
+    for (long i = 0; i < perf->count; i++) {
+        if (perf->samples[i].frame > worst) worst = perf->samples[i].frame;
+    }
+    return worst;
+}
+
+static float
+perf_ms(float seconds)
+{
+    float ms = seconds * 1000.0f;
+    return ms < PERF_MAX_MS ? ms : PERF_MAX_MS;
+}
+
+// Each of these writes at most `capacity` bytes and returns the bytes written.
+
+static long
+perf_rect(float x0, float y0, float x1, float y1, float* buffer, long capacity)
+{
+    const float rect[] = {
+        x1, y1,  x0, y1,  x0, y0,
+        x1, y1,  x0, y0,  x1, y0,
+    };
+
+    if ((long)sizeof(rect) > capacity) return 0;
+    for (long i = 0; i < (long)(sizeof(rect) / sizeof(rect[0])); i++) {
+        buffer[i] = rect[i];
+    }
+    return sizeof(rect);
+}
+
+static long
+perf_text(const char* str, long line, float* buffer, long capacity)
+{
+    long size = font_size(str);
+    if (size > capacity) return 0;
+
+    // glyphs are centered on their position
+    float x = PERF_LEFT + PERF_TEXT_SCALE / 2.0f;
+    float y = PERF_TEXT_TOP - line * PERF_LINE_SPACING;
+    font_print(str, buffer, size);
+    font_place(buffer, size, x, y, PERF_TEXT_SCALE, PERF_TEXT_SCALE);
+    return size;
+}
+
+// Build the overlay into `buffer` (capacity in bytes) and return its size in
+// bytes. Lines of text, top to bottom:
+//
+//   frame ms (latest)   frame ms (worst in the graph)
+//   update ms           render ms
+//   draw calls
+//
+// followed by a graph of frame times (newest on the right) with a line
+// marking the frame budget at half its height.
+long
+perf_overlay_build(const struct perf* perf, double budget, float* buffer, long capacity)
+{
+    assert(perf != NULL);
+    assert(buffer != NULL);
+    assert(capacity >= PERF_OVERLAY_SIZE);
+
+    long size = 0;
+    if (perf->count == 0) return size;
+
+    const struct perf_sample* latest = &perf->samples[(perf->next + PERF_HISTORY - 1) % PERF_HISTORY];
+    char line[32] = { 0 };
+
+    snprintf(line, sizeof(line), "%.2f %.2f", perf_ms(latest->frame), perf_ms(perf_worst(perf)));
+    size += perf_text(line, 0, buffer + size / sizeof(float), capacity - size);
+    snprintf(line, sizeof(line), "%.2f %.2f", perf_ms(latest->update), perf_ms(latest->render));
+    size += perf_text(line, 1, buffer + size / sizeof(float), capacity - size);
+    snprintf(line, sizeof(line), "%ld",
+        latest->draw_calls < PERF_MAX_DRAW_CALLS ? latest->draw_calls : PERF_MAX_DRAW_CALLS);
+    size += perf_text(line, 2, buffer + size / sizeof(float), capacity - size);
+
+    // budget line
+    float bottom = PERF_GRAPH_BOTTOM;
+    float middle = bottom + PERF_GRAPH_HEIGHT / 2.0f;
+    size += perf_rect(PERF_LEFT, middle - PERF_BUDGET_LINE, PERF_RIGHT, middle + PERF_BUDGET_LINE,
+        buffer + size / sizeof(float), capacity - size);
+
+    // one bar per frame, clipped at twice the budget
+    float bar_width = (PERF_RIGHT - PERF_LEFT) / PERF_HISTORY;
+    for (long i = 0; i < perf->count; i++) {
+        long age = perf->count - 1 - i;
+        const struct perf_sample* sample = &perf->samples[(perf->next + PERF_HISTORY - 1 - age) % PERF_HISTORY];
+
+        float height = sample->frame / (2.0 * budget);
+        if (height > 1.0f) height = 1.0f;
+        if (height <= 0.0f) continue;
+
+        float x1 = PERF_RIGHT - age * bar_width;
+        size += perf_rect(x1 - bar_width, bottom, x1, bottom + height * PERF_GRAPH_HEIGHT,
+            buffer + size / sizeof(float), capacity - size);
+    }
+
+    return size;
+}
@@ -0,0 +1,41 @@
+#ifndef FLAPPY_PERF_H_INCLUDED
+#define FLAPPY_PERF_H_INCLUDED
+
+// Frame timing history for the in-game performance overlay (toggled with
+// F3). The overlay is built as plain 2D triangles in the same format as
+// font_print, so it is drawn in the same call as the rest of the HUD.
+
+#include "font.h"
+
+enum {
+    PERF_HISTORY = 256,  // frames shown in the graph
+
+    // characters in the three lines of text at most: two "9999.99 9999.99"
+    // lines and the draw calls (numbers are clamped to fit)
+    PERF_TEXT_MAX_CHARS = 15 + 15 + 5,
+
+    // bytes perf_overlay_build writes at most: the text, the budget line
+    // and one bar per frame (rectangles of 2 triangles)
+    PERF_OVERLAY_SIZE = PERF_TEXT_MAX_CHARS * FONT_GLYPH_MAX_SIZE + (1 + PERF_HISTORY) * 6 * 2 * sizeof(float),
+};
+
+struct perf_sample {
+    float frame;      // seconds since the previous frame
+    float update;     // seconds spent in game_update
+    float render;     // seconds spent submitting game_render
+    long draw_calls;
+};
+
+struct perf {
+    struct perf_sample samples[PERF_HISTORY];
+    long next;   // slot the next sample goes into
+    long count;  // samples recorded (up to PERF_HISTORY)
+};
+
+void perf_record(struct perf* perf, const struct perf_sample* sample);
+float perf_worst(const struct perf* perf);
+
+// `capacity` must be at least PERF_OVERLAY_SIZE.
+long perf_overlay_build(const struct perf* perf, double budget, float* buffer, long capacity);
+
+#endif
@@ -0,0 +1,518 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image.h"
+#include "png.h"
+#include "texture.h"
+
+enum {
+    // zlib stream (RFC 1950) holding deflate data (RFC 1951)
+    PNG_LITLEN_CODES = 288,
+    PNG_DIST_CODES = 32,
+    PNG_CODELEN_CODES = 19,
+    PNG_MAX_BITS = 15,
+
+    // codes up to this long are decoded with a single table lookup
+    PNG_FAST_BITS = 9,
+
+    // IHDR color types
+    PNG_GRAY = 0,
+    PNG_RGB = 2,
+    PNG_PALETTE = 3,
+    PNG_GRAY_ALPHA = 4,
+    PNG_RGB_ALPHA = 6,
+};
+
+static const unsigned char PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+// length and distance codes: base values and extra bits
+static const uint16_t PNG_LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const unsigned char PNG_LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t PNG_DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const unsigned char PNG_DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+// order code length code lengths are stored in
+static const unsigned char PNG_CODELEN_ORDER[PNG_CODELEN_CODES] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+// Deflate bits come least significant first. Reads past the end yield
+// zeros and set `overrun`, which the caller checks once a block is done.
+struct png_bits {
+    const unsigned char* data;
+    long size;
+    long pos;
+    uint32_t buffer;
+    int count;
+    bool overrun;
+};
+
+static void
+png_bits_fill(struct png_bits* bits)
+{
+    while (bits->count <= 24) {
+        uint32_t byte = 0;
+        if (bits->pos < bits->size) byte = bits->data[bits->pos];
+        else if (bits->pos >= bits->size + 4) bits->overrun = true;
+        bits->pos++;
+        bits->buffer |= byte << bits->count;
+        bits->count += 8;
+    }
+}
+
+static uint32_t
+png_bits_get(struct png_bits* bits, int n)
+{
+    if (n == 0) return 0;
+    png_bits_fill(bits);
+    uint32_t value = bits->buffer & ((1u << n) - 1);
+    bits->buffer >>= n;
+    bits->count -= n;
+    return value;
+}
+
+// Canonical Huffman code: symbols sorted by code length, and a lookup table
+// (symbol << 4 | length, 0 for longer codes) indexed by the next bits.
+struct png_huffman {
+    uint16_t count[PNG_MAX_BITS + 1];
+    uint16_t symbol[PNG_LITLEN_CODES];
+    uint16_t fast[1 << PNG_FAST_BITS];
+};
+
+static bool
+png_huffman_build(struct png_huffman* h, const unsigned char* lengths, int n)
+{
+    memset(h, 0, sizeof(*h));
+    for (int i = 0; i < n; i++) h->count[lengths[i]]++;
+    h->count[0] = 0;
+
+    // no length may hold more codes than are left for it
+    int left = 1;
+    for (int len = 1; len <= PNG_MAX_BITS; len++) {
+        left = 2 * left - h->count[len];
+        if (left < 0) return false;
+    }
+
+    uint16_t offset[PNG_MAX_BITS + 2];
+    uint16_t code[PNG_MAX_BITS + 2];
+    offset[1] = 0;
+    code[1] = 0;
+    for (int len = 1; len <= PNG_MAX_BITS; len++) {
+        offset[len + 1] = offset[len] + h->count[len];
+        code[len + 1] = (code[len] + h->count[len]) << 1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int len = lengths[i];
+        if (len == 0) continue;
+        h->symbol[offset[len]++] = i;
+
+        // codes are sent most significant bit first: reverse them for the table
+        int c = code[len]++;
+        if (len > PNG_FAST_BITS) continue;
+        int reversed = 0;
+        for (int b = 0; b < len; b++) reversed |= ((c >> b) & 1) << (len - 1 - b);
+        for (int fill = reversed; fill < (1 << PNG_FAST_BITS); fill += 1 << len) {
+            h->fast[fill] = (uint16_t)(i << 4 | len);
+        }
+    }
+    return true;
+}
+
+static int
+png_huffman_decode(struct png_bits* bits, const struct png_huffman* h)
+{
+    png_bits_fill(bits);
+    uint16_t entry = h->fast[bits->buffer & ((1u << PNG_FAST_BITS) - 1)];
+    if (entry != 0) {
+        int len = entry & 15;
+        bits->buffer >>= len;
+        bits->count -= len;
+        return entry >> 4;
+    }
+
+    // longer codes one bit at a time
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int len = 1; len <= PNG_MAX_BITS; len++) {
+        code |= bits->buffer & 1;
+        bits->buffer >>= 1;
+        bits->count--;
+        int count = h->count[len];
+        if (code - count < first) return h->symbol[index + (code - first)];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+// Dynamic block header: the code length code, then both codes' lengths.
+static bool
+png_inflate_dynamic(struct png_bits* bits, struct png_huffman* litlen, struct png_huffman* dist)
+{
+    int nlen = png_bits_get(bits, 5) + 257;
+    int ndist = png_bits_get(bits, 5) + 1;
+    int ncode = png_bits_get(bits, 4) + 4;
+    if (nlen > 286 || ndist > 30) return false;
+
+    unsigned char lengths[PNG_LITLEN_CODES + PNG_DIST_CODES] = { 0 };
+    for (int i = 0; i < ncode; i++) lengths[PNG_CODELEN_ORDER[i]] = png_bits_get(bits, 3);
+
+    struct png_huffman codelen;
+    if (!png_huffman_build(&codelen, lengths, PNG_CODELEN_CODES)) return false;
+    memset(lengths, 0, PNG_CODELEN_CODES);
+
+    int i = 0;
+    while (i < nlen + ndist) {
+        int symbol = png_huffman_decode(bits, &codelen);
+        if (symbol < 0 || bits->overrun) return false;
+        if (symbol < 16) {
+            lengths[i++] = symbol;
+            continue;
+        }
+
+        int value = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (i == 0) return false;
+            value = lengths[i - 1];
+            repeat = 3 + png_bits_get(bits, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + png_bits_get(bits, 3);
+        } else {
+            repeat = 11 + png_bits_get(bits, 7);
+        }
+        if (i + repeat > nlen + ndist) return false;
+        while (repeat-- > 0) lengths[i++] = value;
+    }
+
+    // the end of block code has to be there
+    if (lengths[256] == 0) return false;
+    return png_huffman_build(litlen, lengths, nlen) && png_huffman_build(dist, lengths + nlen, ndist);
+}
+
+// Inflate a zlib stream into exactly `size` bytes.
+static bool
+png_inflate(const unsigned char* data, long data_size, unsigned char* out, long size)
+{
+    if (data_size < 2) return false;
+    int cmf = data[0];
+    int flg = data[1];
+    if ((cmf & 15) != 8 || (cmf >> 4) > 7 || (cmf * 256 + flg) % 31 != 0 || (flg & 32) != 0) return false;
+
+    struct png_bits bits = { data + 2, data_size - 2, 0, 0, 0, false };
+    struct png_huffman* litlen = malloc(2 * sizeof(*litlen));
+    if (litlen == NULL) return false;
+    struct png_huffman* dist = litlen + 1;
+
+    long written = 0;
+    bool ok = true;
+    bool last = false;
+    while (ok && !last) {
+        last = png_bits_get(&bits, 1);
+        int type = png_bits_get(&bits, 2);
+
+        if (type == 0) {
+            // stored: byte aligned LEN, NLEN, then LEN bytes as they are
+            png_bits_get(&bits, bits.count % 8);
+            uint32_t len = png_bits_get(&bits, 16);
+            uint32_t nlen = png_bits_get(&bits, 16);
+            ok = (len ^ 0xffff) == nlen && len <= (uint32_t)(size - written);
+            for (uint32_t i = 0; ok && i < len; i++) out[written++] = png_bits_get(&bits, 8);
+            ok = ok && !bits.overrun;
+            continue;
+        }
+
+        if (type == 1) {
+            unsigned char lengths[PNG_LITLEN_CODES + PNG_DIST_CODES];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            memset(lengths + PNG_LITLEN_CODES, 5, PNG_DIST_CODES);
+            ok = png_huffman_build(litlen, lengths, PNG_LITLEN_CODES) &&
+                png_huffman_build(dist, lengths + PNG_LITLEN_CODES, PNG_DIST_CODES);
+        } else if (type == 2) {
+            ok = png_inflate_dynamic(&bits, litlen, dist);
+        } else {
+            ok = false;
+        }
+
+        while (ok) {
+            int symbol = png_huffman_decode(&bits, litlen);
+            if (symbol < 0 || bits.overrun) {
+                ok = false;
+            } else if (symbol < 256) {
+                if (written == size) ok = false;
+                else out[written++] = symbol;
+            } else if (symbol == 256) {
+                break;
+            } else {
+                symbol -= 257;
+                if (symbol >= 29) {
+                    ok = false;
+                    break;
+                }
+                long length = PNG_LENGTH_BASE[symbol] + png_bits_get(&bits, PNG_LENGTH_EXTRA[symbol]);
+                int d = png_huffman_decode(&bits, dist);
+                if (d < 0 || d >= 30) {
+                    ok = false;
+                    break;
+                }
+                long distance = PNG_DIST_BASE[d] + png_bits_get(&bits, PNG_DIST_EXTRA[d]);
+                if (distance > written || length > size - written) {
+                    ok = false;
+                    break;
+                }
+                // byte by byte: the copy may overlap what it writes
+                for (long i = 0; i < length; i++, written++) out[written] = out[written - distance];
+            }
+        }
+    }
+
+    free(litlen);
+    return ok && written == size;
+}
+
+static uint32_t
+png_u32(const unsigned char* p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static int
+png_paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Undo the per-row filters in place (`rows` of 1 + `row_size` bytes).
+static bool
+png_unfilter(unsigned char* rows, long height, long row_size, long bpp)
+{
+    const unsigned char* prior = NULL;
+    for (long y = 0; y < height; y++) {
+        unsigned char* row = rows + y * (row_size + 1);
+        int filter = row[0];
+        unsigned char* p = row + 1;
+        for (long i = 0; i < row_size; i++) {
+            int a = i >= bpp ? p[i - bpp] : 0;
+            int b = prior != NULL ? prior[i] : 0;
+            int c = i >= bpp && prior != NULL ? prior[i - bpp] : 0;
+            switch (filter) {
+            case 0: break;
+            case 1: p[i] += a; break;
+            case 2: p[i] += b; break;
+            case 3: p[i] += (a + b) / 2; break;
+            case 4: p[i] += png_paeth(a, b, c); break;
+            default: return false;
+            }
+        }
+        prior = p;
+    }
+    return true;
+}
+
+bool
+png_decode(struct image* image, const unsigned char* data, long size, const char* path)
+{
+    assert(image != NULL);
+    assert(data != NULL);
+
+    memset(image, 0, sizeof(*image));
+    if (size < 8 || memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0) {
+        fprintf(stderr, "invalid PNG image: %s\n", path);
+        return false;
+    }
+
+    long width = 0;
+    long height = 0;
+    int depth = 0;
+    int color = -1;
+    unsigned char palette[256][4];
+    long palette_size = 0;
+    bool has_key = false;      // tRNS: transparent gray level or RGB color
+    uint16_t key[3] = { 0 };
+    bool has_alpha = false;
+
+    // chunks: gather the IDAT data into one zlib stream
+    unsigned char* stream = NULL;
+    long stream_size = 0;
+    bool ok = true;
+    bool ended = false;
+    long pos = 8;
+    while (ok && !ended) {
+        if (size - pos < 12) {
+            ok = false;
+            break;
+        }
+        uint32_t length = png_u32(data + pos);
+        const unsigned char* type = data + pos + 4;
+        const unsigned char* body = data + pos + 8;
+        if (length > (uint32_t)(size - pos - 12)) {
+            ok = false;
+            break;
+        }
+        pos += 12 + (long)length;
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            ok = length == 13;
+            if (!ok) break;
+            width = png_u32(body);
+            height = png_u32(body + 4);
+            depth = body[8];
+            color = body[9];
+            ok = body[10] == 0 && body[11] == 0;
+            if (body[12] != 0) {
+                fprintf(stderr, "unsupported PNG image (interlaced): %s\n", path);
+                ok = false;
+            }
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            ok = length % 3 == 0 && length / 3 <= 256;
+            palette_size = length / 3;
+            for (long i = 0; ok && i < palette_size; i++) {
+                palette[i][0] = body[3 * i];
+                palette[i][1] = body[3 * i + 1];
+                palette[i][2] = body[3 * i + 2];
+                palette[i][3] = 255;
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (color == PNG_PALETTE) {
+                ok = (long)length <= palette_size;
+                for (uint32_t i = 0; ok && i < length; i++) palette[i][3] = body[i];
+                has_alpha = true;
+            } else if (color == PNG_GRAY && length == 2) {
+                key[0] = body[0] << 8 | body[1];
+                has_key = true;
+            } else if (color == PNG_RGB && length == 6) {
+                for (int c = 0; c < 3; c++) key[c] = body[2 * c] << 8 | body[2 * c + 1];
+                has_key = true;
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            unsigned char* grown = realloc(stream, stream_size + length + 1);
+            ok = grown != NULL;
+            if (!ok) break;
+            stream = grown;
+            memcpy(stream + stream_size, body, length);
+            stream_size += length;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            ended = true;
+        } else if ((type[0] & 32) == 0) {
+            // an unknown chunk the image can't be shown without
+            ok = false;
+        }
+    }
+
+    // sample layout of the color type
+    int channels = 0;
+    switch (color) {
+    case PNG_GRAY: channels = 1; ok = ok && (depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16); break;
+    case PNG_RGB: channels = 3; ok = ok && (depth == 8 || depth == 16); break;
+    case PNG_PALETTE: channels = 1; ok = ok && palette_size > 0 && (depth == 1 || depth == 2 || depth == 4 || depth == 8); break;
+    case PNG_GRAY_ALPHA: channels = 2; ok = ok && (depth == 8 || depth == 16); break;
+    case PNG_RGB_ALPHA: channels = 4; ok = ok && (depth == 8 || depth == 16); break;
+    default: ok = false; break;
+    }
+    ok = ok && ended && stream != NULL && width > 0 && width <= IMAGE_SIZE_MAX && height > 0 && height <= IMAGE_SIZE_MAX;
+    if (!ok) {
+        fprintf(stderr, "invalid PNG image: %s\n", path);
+        free(stream);
+        return false;
+    }
+
+    long row_size = (width * channels * depth + 7) / 8;
+    long bpp = (channels * depth + 7) / 8;
+    long raw_size = height * (row_size + 1);
+    unsigned char* raw = malloc(raw_size);
+    if (raw == NULL || !png_inflate(stream, stream_size, raw, raw_size) || !png_unfilter(raw, height, row_size, bpp)) {
+        fprintf(stderr, "invalid PNG image data: %s\n", path);
+        free(raw);
+        free(stream);
+        return false;
+    }
+    free(stream);
+
+    has_alpha = has_alpha || has_key || color == PNG_GRAY_ALPHA || color == PNG_RGB_ALPHA;
+    long out_channels = has_alpha ? 4 : 3;
+    unsigned char* pixels = malloc(width * height * out_channels);
+    if (pixels == NULL) {
+        fprintf(stderr, "failed to allocate image: %s\n", path);
+        free(raw);
+        return false;
+    }
+
+    // expand every sample to 8-bit RGB(A), bottom row first
+    int max = (1 << depth) - 1;
+    for (long y = 0; y < height; y++) {
+        const unsigned char* in = raw + y * (row_size + 1) + 1;
+        unsigned char* out = pixels + (height - 1 - y) * width * out_channels;
+        for (long x = 0; x < width; x++, out += out_channels) {
+            uint16_t s[4];
+            for (int c = 0; c < channels; c++) {
+                long i = x * channels + c;
+                if (depth == 16) {
+                    s[c] = in[2 * i] << 8 | in[2 * i + 1];
+                } else if (depth == 8) {
+                    s[c] = in[i];
+                } else {
+                    long bit = i * depth;
+                    s[c] = (in[bit / 8] >> (8 - depth - bit % 8)) & max;
+                }
+            }
+
+            unsigned char rgba[4];
+            if (color == PNG_PALETTE) {
+                const unsigned char* entry = s[0] < palette_size ? palette[s[0]] : palette[0];
+                memcpy(rgba, entry, 4);
+            } else {
+                // scale to 8 bits: the high byte, or the low depths stretched
+                unsigned char v[4];
+                for (int c = 0; c < channels; c++) {
+                    v[c] = depth == 16 ? s[c] >> 8 : depth == 8 ? s[c] : s[c] * 255 / max;
+                }
+                if (channels <= 2) {
+                    rgba[0] = rgba[1] = rgba[2] = v[0];
+                    rgba[3] = channels == 2 ? v[1] : 255;
+                } else {
+                    memcpy(rgba, v, 3);
+                    rgba[3] = channels == 4 ? v[3] : 255;
+                }
+                if (has_key) {
+                    bool match = color == PNG_GRAY ? s[0] == key[0] : s[0] == key[0] && s[1] == key[1] && s[2] == key[2];
+                    if (match) rgba[3] = 0;
+                }
+            }
+            memcpy(out, rgba, out_channels);
+        }
+    }
+    free(raw);
+
+    image->format = has_alpha ? TEXTURE_FORMAT_RGBA : TEXTURE_FORMAT_RGB;
+    image->width = width;
+    image->height = height;
+    image->pixels = pixels;
+    return true;
+}
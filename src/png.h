@@ -0,0 +1,14 @@
+#ifndef FLAPPY_PNG_H_INCLUDED
+#define FLAPPY_PNG_H_INCLUDED
+
+#include <stdbool.h>
+
+#include "image.h"
+
+// PNG decoding for runtime textures: every color type at every bit depth,
+// non-interlaced. Images with an alpha channel (or a tRNS chunk) come out
+// as RGBA, the rest as RGB; 16-bit samples keep their high byte. `path` is
+// only used in error messages.
+bool png_decode(struct image* image, const unsigned char* data, long size, const char* path);
+
+#endif
@@ -0,0 +1,274 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "course.h"
+#include "net.h"
+#include "race.h"
+#include "rollback.h"
+#include "world.h"
+
+// resend HELLO this often until the host answers (seconds)
+static const double RACE_HELLO_INTERVAL = 0.1;
+
+// never try to catch up on more than this much time at once (seconds)
+static const double RACE_MAX_ACCUMULATOR = 0.25;
+
+static const uint32_t RACE_MAGIC = 0x52504c46;  // "FLPR"
+
+enum race_message {
+    RACE_HELLO = 1,
+    RACE_WELCOME,
+    RACE_INPUT,
+};
+
+struct race_packet {
+    uint32_t magic;
+    uint8_t type;
+    uint8_t count;
+    uint16_t reserved;
+    uint32_t seed;           // RACE_WELCOME
+    int32_t first;           // frame of inputs[0]
+    int32_t ack;             // last input the sender has received from us
+    int32_t sync_frame;      // -1 when there is no checksum yet
+    uint32_t sync_checksum;
+    uint8_t inputs[RACE_MAX_INPUTS];
+};
+
+static void
+race_send(struct race* race, uint8_t type)
+{
+    struct race_packet packet = { 0 };
+    packet.magic = RACE_MAGIC;
+    packet.type = type;
+    packet.seed = race->seed;
+    packet.sync_frame = -1;
+
+    if (type == RACE_INPUT) {
+        const struct rollback* rollback = race->rollback;
+        packet.first = race->peer_ack + 1;
+        packet.count = rollback_local_inputs(rollback, packet.first, packet.inputs, RACE_MAX_INPUTS);
+        packet.ack = rollback->remote_frame;
+
+        // newest local checksum for the peer to compare against
+        for (long i = 0; i < RACE_SYNC_HISTORY; i++) {
+            if (race->sync_frames[i] > packet.sync_frame) {
+                packet.sync_frame = race->sync_frames[i];
+                packet.sync_checksum = race->sync_checksums[i];
+            }
+        }
+    }
+
+    net_send(race->net, &packet, sizeof(packet));
+}
+
+static void
+race_start(struct race* race, unsigned int seed)
+{
+    race->rollback = rollback_create(race->host ? 0 : 1, race->delay, race->course, seed);
+    if (race->rollback == NULL) return;
+
+    race->seed = seed;
+    race->started = true;
+    printf("race started: player %d, seed %u\n", race_local(race), seed);
+}
+
+static void
+race_check_sync(struct race* race, long frame, uint32_t checksum)
+{
+    if (frame <= race->sync_checked) return;
+
+    // wait until we have confirmed the same frame ourselves
+    long slot = (frame / RACE_SYNC_INTERVAL) % RACE_SYNC_HISTORY;
+    if (race->sync_frames[slot] != frame) return;
+
+    if (race->sync_checksums[slot] != checksum) {
+        fprintf(stderr, "race desync at frame %ld\n", frame);
+        race->desyncs++;
+    }
+    race->sync_checked = frame;
+}
+
+static void
+race_receive(struct race* race)
+{
+    struct race_packet packet;
+    long size;
+    while ((size = net_recv(race->net, &packet, sizeof(packet))) > 0) {
+        if (size != sizeof(packet) || packet.magic != RACE_MAGIC) continue;
+
+        switch (packet.type) {
+        case RACE_HELLO:
+            if (!race->host) break;
+            if (!race->started) race_start(race, race->seed);
+            race_send(race, RACE_WELCOME);
+            break;
+        case RACE_WELCOME:
+            if (race->host || race->started) break;
+            race_start(race, packet.seed);
+            break;
+        case RACE_INPUT:
+            if (!race->started) break;
+            for (long i = 0; i < packet.count; i++) {
+                rollback_add_remote(race->rollback, packet.first + i, packet.inputs[i]);
+            }
+            if (packet.ack > race->peer_ack) race->peer_ack = packet.ack;
+            race_check_sync(race, packet.sync_frame, packet.sync_checksum);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Remember the checksum of each confirmed frame on the sync interval.
+static void
+race_track_sync(struct race* race)
+{
+    const struct rollback* rollback = race->rollback;
+    long frame = rollback->remote_frame + 1;
+    frame -= frame % RACE_SYNC_INTERVAL;
+
+    long slot = (frame / RACE_SYNC_INTERVAL) % RACE_SYNC_HISTORY;
+    if (frame <= 0 || race->sync_frames[slot] == frame) return;
+
+    uint32_t checksum;
+    if (rollback_checksum(rollback, frame, &checksum)) {
+        race->sync_frames[slot] = frame;
+        race->sync_checksums[slot] = checksum;
+    }
+}
+
+static struct race*
+race_create(unsigned short port, long delay, struct course* course)
+{
+    struct race* race = calloc(1, sizeof(*race));
+    if (race == NULL) {
+        fprintf(stderr, "failed to allocate race\n");
+        return NULL;
+    }
+
+    race->net = net_open(port);
+    if (race->net == NULL) {
+        free(race);
+        return NULL;
+    }
+
+    race->delay = delay;
+    race->course = course;
+    race->peer_ack = -1;
+    race->sync_checked = -1;
+    for (long i = 0; i < RACE_SYNC_HISTORY; i++) {
+        race->sync_frames[i] = -1;
+    }
+
+    return race;
+}
+
+struct race*
+race_host(unsigned short port, long delay, struct course* course, unsigned int seed)
+{
+    struct race* race = race_create(port, delay, course);
+    if (race == NULL) return NULL;
+
+    race->host = true;
+    race->seed = seed;
+    printf("race: waiting for a player on port %u\n", port);
+    return race;
+}
+
+struct race*
+race_join(const char* address, long delay, struct course* course)
+{
+    assert(address != NULL);
+
+    struct race* race = race_create(0, delay, course);
+    if (race == NULL) return NULL;
+
+    if (!net_connect(race->net, address)) {
+        race_close(race);
+        return NULL;
+    }
+
+    race->host = false;
+    printf("race: joining %s\n", address);
+    return race;
+}
+
+void
+race_close(struct race* race)
+{
+    if (race == NULL) return;
+
+    rollback_destroy(race->rollback);
+    net_close(race->net);
+    free(race);
+}
+
+// Latency in seconds (one way), loss as a fraction of packets.
+void
+race_simulate_network(struct race* race, double latency, double loss)
+{
+    assert(race != NULL);
+    net_simulate(race->net, latency, loss);
+}
+
+void
+race_update(struct race* race, bool flap, double delta)
+{
+    assert(race != NULL);
+
+    race_receive(race);
+
+    // keep knocking until the host lets us in
+    if (!race->started) {
+        race->hello_timer -= delta;
+        if (!race->host && race->hello_timer <= 0.0) {
+            race_send(race, RACE_HELLO);
+            race->hello_timer = RACE_HELLO_INTERVAL;
+        }
+        return;
+    }
+
+    // step the fixed tick as many times as real time allows
+    race->flap = race->flap || flap;
+    race->accumulator += delta;
+    if (race->accumulator > RACE_MAX_ACCUMULATOR) {
+        race->accumulator = RACE_MAX_ACCUMULATOR;
+    }
+    while (race->accumulator >= TICK) {
+        if (!rollback_step(race->rollback, race->flap)) {
+            // too far ahead of the peer: wait (keeping the flap) for them
+            race->stalls++;
+            race->accumulator = 0.0;
+            break;
+        }
+
+        race->flap = false;
+        race->accumulator -= TICK;
+    }
+
+    race_track_sync(race);
+    race_send(race, RACE_INPUT);
+}
+
+int
+race_local(const struct race* race)
+{
+    assert(race != NULL);
+    return race->host ? 0 : 1;
+}
+
+// NULL until the race has started
+const struct world*
+race_world(const struct race* race, int player)
+{
+    assert(race != NULL);
+
+    if (!race->started) return NULL;
+    return rollback_world(race->rollback, player);
+}
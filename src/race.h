@@ -0,0 +1,56 @@
+#ifndef FLAPPY_RACE_H_INCLUDED
+#define FLAPPY_RACE_H_INCLUDED
+
+#include <stdbool.h>
+
+#include "course.h"
+#include "net.h"
+#include "rollback.h"
+#include "world.h"
+
+// Head-to-head race between two machines: the host picks the seed and plays
+// as player 0, the joiner plays as player 1. Inputs are exchanged over UDP
+// and the simulation runs through rollback (see rollback.h).
+
+enum {
+    RACE_MAX_INPUTS = 64,
+    RACE_SYNC_INTERVAL = 64,  // frames between desync checks
+    RACE_SYNC_HISTORY = 8,
+};
+
+struct race {
+    struct net* net;
+    struct course* course;
+    struct rollback* rollback;
+
+    bool host;
+    bool started;
+    long delay;
+    unsigned int seed;
+
+    double accumulator;
+    double hello_timer;
+    bool flap;        // local flap waiting for the next tick
+    long peer_ack;    // last local frame the peer has confirmed
+
+    // local checksums of confirmed frames (for desync detection)
+    long sync_frames[RACE_SYNC_HISTORY];
+    unsigned int sync_checksums[RACE_SYNC_HISTORY];
+    long sync_checked;
+
+    // counters for reporting
+    long stalls;
+    long desyncs;
+};
+
+struct race* race_host(unsigned short port, long delay, struct course* course, unsigned int seed);
+struct race* race_join(const char* address, long delay, struct course* course);
+void race_close(struct race* race);
+
+void race_simulate_network(struct race* race, double latency, double loss);
+void race_update(struct race* race, bool flap, double delta);
+
+int race_local(const struct race* race);
+const struct world* race_world(const struct race* race, int player);
+
+#endif
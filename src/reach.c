@@ -0,0 +1,742 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "config.h"
+#include "course.h"
+#include "entity.h"
+#include "reach.h"
+#include "world.h"
+
+enum {
+    REACH_ALIGN = 64,
+    REACH_MAX_THREADS = 64,
+
+    // bytes for the states of one (dx, dy) cell, every vy (a whole number)
+    REACH_ROW_SIZE = REACH_V_COUNT * 2 / 8,
+
+    // obstacles the bird can touch at once: the next one and the one after
+    REACH_NEAR = 2,
+
+    // failed states the table search remembers at most (16 MB of keys)
+    REACH_MAX_FAILED = 1 << 20,
+};
+
+static const float REACH_WALL = 4.5f;
+
+// gap size of generated worlds (see world_obstacle), the one tables are built for
+static float
+reach_gap_size(void)
+{
+    return 2.0f * GAP - PIPE_HEIGHT;
+}
+
+static long
+reach_index(long x, long y, long v)
+{
+    return ((x - REACH_X_MIN) * REACH_Y_COUNT + y) * REACH_V_COUNT + v;
+}
+
+static int
+reach_get(const unsigned char* bits, long index)
+{
+    return (bits[index >> 2] >> ((index & 3) * 2)) & 3;
+}
+
+// Grid cell of a state (false if it is off the grid). Columns past the last
+// one use the last one: a bird further away only has more room.
+static bool
+reach_cell(float dx, float dy, float vy, long* x, long* y, long* v)
+{
+    *x = lrintf(dx / (SPEED * TICK));
+    *y = lrintf(dy * REACH_Y_SCALE) + REACH_Y_COUNT / 2;
+    *v = lrintf((FLAP - vy) / (GRAVITY * TICK));
+
+    if (*x > REACH_X_MIN + REACH_X_COUNT - 1) *x = REACH_X_MIN + REACH_X_COUNT - 1;
+    return *x >= REACH_X_MIN && *y >= 0 && *y < REACH_Y_COUNT && *v >= 0 && *v < REACH_V_COUNT;
+}
+
+// The bird against both pipes of an obstacle, exactly as entity_collide
+// tests it.
+static bool
+reach_hit(float bird_x, float bird_y, float pipe_x, float gap, float gap_size)
+{
+    float offset = (gap_size + PIPE_HEIGHT) / 2.0f;
+    float half_w = PIPE_WIDTH / 2.0f;
+    float half_h = PIPE_HEIGHT / 2.0f;
+    float pipe_y[2] = { gap + offset, gap - offset };
+
+    for (long i = 0; i < 2; i++) {
+        float test_x = fminf(fmaxf(bird_x, pipe_x - half_w), pipe_x + half_w);
+        float test_y = fminf(fmaxf(bird_y, pipe_y[i] - half_h), pipe_y[i] + half_h);
+        float dist_x = bird_x - test_x;
+        float dist_y = bird_y - test_y;
+        if ((dist_x * dist_x) + (dist_y * dist_y) <= BIRD_RADIUS * BIRD_RADIUS) return true;
+    }
+    return false;
+}
+
+struct reach_worker {
+    unsigned char* bits;
+    long x;      // column being filled
+    long first;  // its dy rows for this worker
+    long last;
+    pthread_t thread;
+};
+
+// Fill rows of one column from the column nearer the obstacle. A move is
+// safe if the bird misses the pipes on the coming tick and lands in a state
+// with a safe move of its own (or past the obstacle).
+static void*
+reach_worker_run(void* arg)
+{
+    struct reach_worker* worker = arg;
+    unsigned char* bits = worker->bits;
+    float gap_size = reach_gap_size();
+    float next_dx = (worker->x - 1) * (SPEED * TICK);
+
+    for (long y = worker->first; y < worker->last; y++) {
+        float dy = (float)(y - REACH_Y_COUNT / 2) / REACH_Y_SCALE;
+        unsigned char* row = bits + reach_index(worker->x, y, 0) / 4;
+        memset(row, 0, REACH_ROW_SIZE);
+
+        for (long v = 0; v < REACH_V_COUNT; v++) {
+            float vy = FLAP - v * (GRAVITY * TICK);
+            int safe = 0;
+            for (int move = REACH_GLIDE; move <= REACH_FLAP; move++) {
+                float next_vy = move == REACH_FLAP ? FLAP : vy - GRAVITY * TICK;
+                float next_dy = dy + next_vy * TICK;
+                if (reach_hit(-next_dx, next_dy, 0.0f, 0.0f, gap_size)) continue;
+
+                long nx, ny, nv;
+                if (reach_cell(next_dx, next_dy, next_vy, &nx, &ny, &nv) &&
+                    reach_get(bits, reach_index(nx, ny, nv)) != 0) {
+                    safe |= move;
+                }
+            }
+            row[v / 4] |= safe << ((v % 4) * 2);
+        }
+    }
+
+    return NULL;
+}
+
+bool
+reach_generate(struct reach* reach, long threads)
+{
+    assert(reach != NULL);
+
+    memset(reach, 0, sizeof(*reach));
+
+    long states = (long)REACH_X_COUNT * REACH_Y_COUNT * REACH_V_COUNT;
+    uint64_t bits_offset = (sizeof(struct reach_header) + REACH_ALIGN - 1) & ~(uint64_t)(REACH_ALIGN - 1);
+    uint64_t bits_size = states / 4;
+
+    unsigned char* data = calloc(1, bits_offset + bits_size);
+    if (data == NULL) {
+        fprintf(stderr, "failed to allocate reachability table\n");
+        return false;
+    }
+
+    struct reach_header* header = (struct reach_header*)data;
+    memcpy(header->magic, REACH_MAGIC, sizeof(header->magic));
+    header->version = REACH_VERSION;
+    header->x_min = REACH_X_MIN;
+    header->x_count = REACH_X_COUNT;
+    header->y_count = REACH_Y_COUNT;
+    header->v_count = REACH_V_COUNT;
+    header->bits_offset = bits_offset;
+    header->bits_size = bits_size;
+    header->tick = TICK;
+    header->flap = FLAP;
+    header->gravity = GRAVITY;
+    header->speed = SPEED;
+    header->gap_size = reach_gap_size();
+    header->radius = BIRD_RADIUS;
+    header->pipe_width = PIPE_WIDTH;
+    header->pipe_height = PIPE_HEIGHT;
+
+    if (threads < 1) threads = 1;
+    if (threads > REACH_MAX_THREADS) threads = REACH_MAX_THREADS;
+
+    // past the obstacle every state is safe
+    unsigned char* bits = data + bits_offset;
+    memset(bits, 0xff, (long)REACH_Y_COUNT * REACH_ROW_SIZE);
+
+    // one column after another, each split into contiguous dy rows (which
+    // never share a byte, see REACH_ROW_SIZE); worker 0 is the calling thread
+    struct reach_worker workers[REACH_MAX_THREADS];
+    for (long x = REACH_X_MIN + 1; x < REACH_X_MIN + REACH_X_COUNT; x++) {
+        for (long t = 0; t < threads; t++) {
+            workers[t].bits = bits;
+            workers[t].x = x;
+            workers[t].first = REACH_Y_COUNT * t / threads;
+            workers[t].last = REACH_Y_COUNT * (t + 1) / threads;
+        }
+
+        long started = 1;
+        for (; started < threads; started++) {
+            if (pthread_create(&workers[started].thread, NULL, reach_worker_run, &workers[started]) != 0) break;
+        }
+        reach_worker_run(&workers[0]);
+        for (long t = 1; t < started; t++) {
+            pthread_join(workers[t].thread, NULL);
+        }
+
+        // no thread to spare: the rest of the column right here
+        for (long t = started; t < threads; t++) {
+            reach_worker_run(&workers[t]);
+        }
+    }
+
+    reach->data = data;
+    reach->size = bits_offset + bits_size;
+    reach->header = header;
+    reach->bits = data + bits_offset;
+    return true;
+}
+
+bool
+reach_save(const struct reach* reach, const char* path)
+{
+    assert(reach != NULL);
+    assert(path != NULL);
+
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "failed to create reachability table: %s\n", path);
+        return false;
+    }
+
+    bool ok = fwrite(reach->data, 1, reach->size, f) == reach->size;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "failed to write reachability table: %s\n", path);
+    return ok;
+}
+
+#ifndef _WIN32
+
+static void*
+reach_map(const char* path, size_t* size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "failed to open reachability table: %s\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "failed to stat reachability table: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "failed to map reachability table: %s\n", path);
+        return NULL;
+    }
+
+    *size = st.st_size;
+    return data;
+}
+
+static void
+reach_unmap(void* data, size_t size)
+{
+    munmap(data, size);
+}
+
+#else
+
+// no mmap on Windows builds: read the whole file instead
+static void*
+reach_map(const char* path, size_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "failed to open reachability table: %s\n", path);
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    void* data = length > 0 ? malloc(length) : NULL;
+    if (data == NULL || fread(data, 1, length, f) != (size_t)length) {
+        fprintf(stderr, "failed to read reachability table: %s\n", path);
+        free(data);
+        fclose(f);
+        return NULL;
+    }
+
+    fclose(f);
+    *size = length;
+    return data;
+}
+
+static void
+reach_unmap(void* data, size_t size)
+{
+    (void)size;
+    free(data);
+}
+
+#endif
+
+bool
+reach_open(struct reach* reach, const char* path)
+{
+    assert(reach != NULL);
+    assert(path != NULL);
+
+    memset(reach, 0, sizeof(*reach));
+
+    size_t size = 0;
+    void* data = reach_map(path, &size);
+    if (data == NULL) return false;
+
+    const struct reach_header* header = data;
+    if (size < sizeof(*header) || memcmp(header->magic, REACH_MAGIC, sizeof(REACH_MAGIC)) != 0 ||
+        header->version != REACH_VERSION) {
+        fprintf(stderr, "invalid reachability table (or a different version): %s\n", path);
+        reach_unmap(data, size);
+        return false;
+    }
+
+    uint64_t bits_size = (uint64_t)REACH_X_COUNT * REACH_Y_COUNT * REACH_V_COUNT / 4;
+    if (header->x_min != REACH_X_MIN || header->x_count != REACH_X_COUNT ||
+        header->y_count != REACH_Y_COUNT || header->v_count != REACH_V_COUNT ||
+        header->bits_size != bits_size || header->bits_offset > size || bits_size > size - header->bits_offset) {
+        fprintf(stderr, "reachability table has a different grid (or is truncated): %s\n", path);
+        reach_unmap(data, size);
+        return false;
+    }
+
+    if (header->tick != TICK || header->flap != FLAP || header->gravity != GRAVITY || header->speed != SPEED ||
+        header->gap_size != reach_gap_size() || header->radius != BIRD_RADIUS ||
+        header->pipe_width != PIPE_WIDTH || header->pipe_height != PIPE_HEIGHT) {
+        fprintf(stderr, "reachability table was built for different physics, regenerate it: %s\n", path);
+        reach_unmap(data, size);
+        return false;
+    }
+
+    reach->data = data;
+    reach->size = size;
+    reach->mapped = true;
+    reach->header = header;
+    reach->bits = (const unsigned char*)data + header->bits_offset;
+    return true;
+}
+
+void
+reach_close(struct reach* reach)
+{
+    assert(reach != NULL);
+
+    if (reach->mapped) {
+        reach_unmap(reach->data, reach->size);
+    } else {
+        free(reach->data);
+    }
+    memset(reach, 0, sizeof(*reach));
+}
+
+int
+reach_lookup(const struct reach* reach, float dx, float dy, float vy)
+{
+    assert(reach != NULL);
+
+    long x, y, v;
+    if (!reach_cell(dx, dy, vy, &x, &y, &v)) {
+        // past the obstacle anything goes
+        return x < REACH_X_MIN ? REACH_GLIDE | REACH_FLAP : 0;
+    }
+    return reach_get(reach->bits, reach_index(x, y, v));
+}
+
+// Moves from a bird state that are safe according to the table and keep off
+// the ceiling and floor for the coming tick, preferred one first. The table
+// only looks as far as clearing the next obstacle, so of two safe moves the
+// one that is also safe for the obstacle after it (as if the next one were
+// not there) is preferred, then the one that ends up nearer the gap center.
+static int
+reach_moves(const struct reach* reach, const struct course_record* obstacle, const struct course_record* after,
+    float x, float y, float vy, int* preferred)
+{
+    int safe = reach_lookup(reach, obstacle->x - x, y - obstacle->gap, vy);
+
+    float glide_y = y + (vy - GRAVITY * TICK) * TICK;
+    float flap_y = y + FLAP * TICK;
+    if (x + SPEED * TICK >= WALL_START_X) {
+        if (glide_y < -REACH_WALL) safe &= ~REACH_GLIDE;
+        if (flap_y > REACH_WALL) safe &= ~REACH_FLAP;
+    }
+
+    *preferred = safe == REACH_FLAP ? REACH_FLAP : REACH_GLIDE;
+    if (safe != (REACH_GLIDE | REACH_FLAP)) return safe;
+
+    int later = after != NULL ? reach_lookup(reach, after->x - x, y - after->gap, vy) : 0;
+    if (later == REACH_FLAP || later == REACH_GLIDE) {
+        *preferred = later;
+    } else if (fabsf(flap_y - obstacle->gap) < fabsf(glide_y - obstacle->gap)) {
+        *preferred = REACH_FLAP;
+    }
+    return safe;
+}
+
+bool
+reach_bot(const struct reach* reach, const struct world* world)
+{
+    assert(reach != NULL);
+    assert(world != NULL);
+
+    // flap to start (and restart) a run
+    if (!world->running || world->dead) return true;
+
+    const struct entity_store* entities = &world->entities;
+    float x = entities->pos_x[WORLD_BIRD];
+    float y = entities->pos_y[WORLD_BIRD];
+    float vy = entities->vel_y[WORLD_BIRD];
+
+    struct course_record obstacle;
+    struct course_record after;
+    if (!world_obstacle(world, world->score, &obstacle)) return y < 0.0f && vy < 0.0f;
+    bool has_after = world_obstacle(world, world->score + 1, &after);
+
+    int preferred;
+    int safe = reach_moves(reach, &obstacle, has_after ? &after : NULL, x, y, vy, &preferred);
+
+    // doomed either way: at least aim for the gap
+    if (safe == 0) return y < obstacle.gap;
+    return preferred == REACH_FLAP;
+}
+
+// Validation works on the bird alone: every obstacle is static, so nothing
+// else in the world affects whether it survives.
+struct reach_bird {
+    float x;
+    float y;
+    float vy;
+    long score;  // obstacles cleared, counted from the first one validated
+};
+
+// Advance the bird one tick exactly as world_update does (integrate, then
+// collide, then score). Returns false if it crashed.
+static bool
+reach_step(struct reach_bird* bird, bool flap, const struct course_record* obstacles, long count)
+{
+    bird->vy = flap ? FLAP : bird->vy - GRAVITY * TICK;
+    bird->x += SPEED * TICK;
+    bird->y += bird->vy * TICK;
+
+    for (long i = bird->score; i < bird->score + REACH_NEAR && i < count; i++) {
+        if (reach_hit(bird->x, bird->y, obstacles[i].x, obstacles[i].gap, obstacles[i].gap_size)) return false;
+    }
+    if (bird->x >= WALL_START_X && (bird->y > REACH_WALL || bird->y < -REACH_WALL)) return false;
+
+    while (bird->score < count && bird->x >= obstacles[bird->score].x + PIPE_WIDTH) {
+        bird->score++;
+    }
+    return true;
+}
+
+// Replay the flaps through world_update on a copy of the world.
+static bool
+reach_replay(const struct world* world, const unsigned char* flaps, long ticks, long pipes)
+{
+    struct world* copy = malloc(sizeof(*copy));
+    if (copy == NULL) return false;
+
+    world_copy(copy, world);
+    long goal = copy->score + pipes;
+    bool ok = true;
+    for (long t = 0; t < ticks && ok; t++) {
+        world_update(copy, flaps[t], TICK);
+        ok = !copy->dead;
+    }
+    ok = ok && copy->score >= goal;
+
+    free(copy);
+    return ok;
+}
+
+// Bird states are told apart on the table's grid (dy in 1/REACH_Y_SCALE,
+// vy in GRAVITY * TICK steps) rather than exactly, so searches that meet
+// again follow only one of the paths. Keys pack the tick with the state.
+static uint64_t
+reach_key(long tick, float y, float vy)
+{
+    uint64_t yk = (uint32_t)(lrintf(y * REACH_Y_SCALE) + (1 << 15)) & 0xffff;
+    uint64_t vk = (uint32_t)(lrintf((FLAP - vy) / (GRAVITY * TICK)) + (1 << 15)) & 0xffff;
+    return (uint64_t)tick << 32 | yk << 16 | vk;
+}
+
+// Open addressing set of keys, sized for `capacity` of them at most.
+struct reach_set {
+    uint64_t* keys;
+    long mask;
+    long count;
+};
+
+static bool
+reach_set_init(struct reach_set* set, long capacity)
+{
+    long size = 64;
+    while (size < 2 * capacity) size *= 2;
+    set->keys = calloc(size, sizeof(*set->keys));
+    set->mask = size - 1;
+    set->count = 0;
+    return set->keys != NULL;
+}
+
+static long
+reach_set_slot(const struct reach_set* set, uint64_t key)
+{
+    // 0 marks a free slot, and no key is ~0
+    key = ~key;
+    long slot = (long)((key * 0x9e3779b97f4a7c15ull) >> 20) & set->mask;
+    while (set->keys[slot] != 0 && set->keys[slot] != key) slot = (slot + 1) & set->mask;
+    return slot;
+}
+
+static bool
+reach_set_has(const struct reach_set* set, uint64_t key)
+{
+    return set->keys[reach_set_slot(set, key)] != 0;
+}
+
+static void
+reach_set_add(struct reach_set* set, uint64_t key)
+{
+    if (2 * (set->count + 1) > set->mask + 1) return;  // full: just forget it
+    long slot = reach_set_slot(set, key);
+    if (set->keys[slot] == 0) set->count++;
+    set->keys[slot] = ~key;
+}
+
+// Depth first along reach_bot's choices, trying the other safe move on the
+// way back from a crash.
+struct reach_frame {
+    struct reach_bird bird;
+    unsigned char flap;   // move that led here
+    unsigned char tried;  // moves tried from here
+};
+
+static int
+reach_search_table(const struct reach* reach, const struct reach_bird* start, bool forced,
+    const struct course_record* obstacles, long pipes, long budget,
+    unsigned char* flaps, long capacity, struct reach_solution* solution)
+{
+    // states every move from which crashed sooner or later
+    struct reach_set failed;
+    if (!reach_set_init(&failed, budget < REACH_MAX_FAILED ? budget : REACH_MAX_FAILED)) return REACH_UNKNOWN;
+    struct reach_frame* stack = malloc((capacity + 1) * sizeof(*stack));
+    if (stack == NULL) {
+        free(failed.keys);
+        return REACH_UNKNOWN;
+    }
+
+    stack[0].bird = *start;
+    stack[0].tried = 0;
+    long depth = 0;
+    int result = REACH_UNKNOWN;
+    while (depth >= 0 && solution->visited < budget) {
+        struct reach_frame* frame = &stack[depth];
+        if (frame->bird.score >= pipes) {
+            for (long t = 0; t < depth; t++) {
+                flaps[t] = stack[t + 1].flap;
+                solution->flaps += flaps[t];
+            }
+            solution->ticks = depth;
+            result = REACH_SOLVED;
+            break;
+        }
+
+        int preferred;
+        long score = frame->bird.score;
+        int safe = reach_moves(reach, &obstacles[score], score + 1 < pipes ? &obstacles[score + 1] : NULL,
+            frame->bird.x, frame->bird.y, frame->bird.vy, &preferred);
+        if (depth == 0 && forced) safe &= REACH_FLAP;
+        if (depth >= capacity) safe = 0;
+
+        int move = 0;
+        if ((safe & preferred) && !(frame->tried & preferred)) move = preferred;
+        else if ((safe & ~preferred) && !(frame->tried & ~preferred & safe)) move = safe & ~preferred;
+        if (move == 0) {
+            reach_set_add(&failed, reach_key(depth, frame->bird.y, frame->bird.vy));
+            depth--;
+            continue;
+        }
+        frame->tried |= move;
+
+        struct reach_frame* next = &stack[depth + 1];
+        next->bird = frame->bird;
+        next->flap = move == REACH_FLAP;
+        next->tried = 0;
+        solution->visited++;
+        if (reach_step(&next->bird, next->flap, obstacles, pipes) &&
+            !reach_set_has(&failed, reach_key(depth + 1, next->bird.y, next->bird.vy))) {
+            depth++;
+        }
+    }
+
+    free(stack);
+    free(failed.keys);
+    return result;
+}
+
+// Every distinct bird state (see reach_key), tick by tick.
+struct reach_node {
+    uint64_t key;
+    float y;
+    float vy;
+    int32_t parent;
+    unsigned char flap;
+};
+
+static int
+reach_node_compare(const void* a, const void* b)
+{
+    uint64_t x = ((const struct reach_node*)a)->key;
+    uint64_t y = ((const struct reach_node*)b)->key;
+    return (x > y) - (x < y);
+}
+
+static int
+reach_search_brute(const struct reach_bird* start, bool forced, const struct course_record* obstacles,
+    long pipes, long budget, unsigned char* flaps, long capacity, struct reach_solution* solution)
+{
+    struct reach_node* nodes = malloc(budget * sizeof(*nodes));
+    if (nodes == NULL) return REACH_UNKNOWN;
+
+    nodes[0] = (struct reach_node){ 0, start->y, start->vy, -1, 0 };
+    long first = 0;  // current tick's nodes: [first, count)
+    long count = 1;
+    struct reach_bird bird = *start;
+    int result = REACH_UNKNOWN;
+    for (long tick = 0; tick < capacity; tick++) {
+        long end = count;
+        struct reach_bird next = bird;
+        for (long i = first; i < end && count + 2 <= budget; i++) {
+            for (int flap = forced && tick == 0; flap <= 1; flap++) {
+                next = bird;
+                next.y = nodes[i].y;
+                next.vy = nodes[i].vy;
+                if (!reach_step(&next, flap, obstacles, pipes)) continue;
+                nodes[count++] = (struct reach_node){ reach_key(tick, next.y, next.vy), next.y, next.vy, i, flap };
+            }
+        }
+        solution->visited += 2 * (end - first);
+        if (count + 2 > budget) break;
+
+        // x and score are the same for every state of a tick
+        bird.x += SPEED * TICK;
+        while (bird.score < pipes && bird.x >= obstacles[bird.score].x + PIPE_WIDTH) bird.score++;
+
+        qsort(nodes + end, count - end, sizeof(*nodes), reach_node_compare);
+        long unique = end;
+        for (long i = end; i < count; i++) {
+            if (unique > end && nodes[unique - 1].key == nodes[i].key) continue;
+            nodes[unique++] = nodes[i];
+        }
+        count = unique;
+        first = end;
+
+        if (first == count) {
+            result = REACH_UNSOLVABLE;
+            break;
+        }
+        if (bird.score >= pipes) {
+            long at = first;
+            for (long t = tick; t >= 0; t--) {
+                flaps[t] = nodes[at].flap;
+                solution->flaps += flaps[t];
+                at = nodes[at].parent;
+            }
+            solution->ticks = tick + 1;
+            result = REACH_SOLVED;
+            break;
+        }
+    }
+
+    free(nodes);
+    return result;
+}
+
+int
+reach_validate(const struct reach* reach, const struct world* world, long pipes, long budget,
+    struct reach_solution* solution)
+{
+    assert(world != NULL);
+    assert(pipes >= 0);
+    assert(solution != NULL);
+
+    memset(solution, 0, sizeof(*solution));
+    if (world->dead) return REACH_UNSOLVABLE;
+
+    // the obstacles to clear, counted from the next one
+    struct course_record* obstacles = malloc((pipes + 1) * sizeof(*obstacles));
+    if (obstacles == NULL) return REACH_UNKNOWN;
+
+    long count = 0;
+    while (count < pipes && world_obstacle(world, world->score + count, &obstacles[count])) {
+        bool supported = obstacles[count].amplitude == 0.0f;
+        if (reach != NULL) supported = supported && obstacles[count].gap_size == reach->header->gap_size;
+        if (!supported) {
+            free(obstacles);
+            return REACH_UNSUPPORTED;
+        }
+        count++;
+    }
+    if (count < pipes) pipes = count;  // a course that ends sooner
+
+    const struct entity_store* entities = &world->entities;
+    struct reach_bird start = {
+        .x = entities->pos_x[WORLD_BIRD],
+        .y = entities->pos_y[WORLD_BIRD],
+        .vy = entities->vel_y[WORLD_BIRD],
+        .score = 0,
+    };
+
+    // enough ticks to fly past the last obstacle, and then some
+    float distance = pipes > 0 ? obstacles[pipes - 1].x + PIPE_WIDTH - start.x : 0.0f;
+    long capacity = distance / (SPEED * TICK) + 2;
+    unsigned char* flaps = malloc(capacity);
+    if (flaps == NULL) {
+        free(obstacles);
+        return REACH_UNKNOWN;
+    }
+
+    // a world that has not started yet starts with a flap
+    bool forced = !world->running;
+    int result = reach != NULL ?
+        reach_search_table(reach, &start, forced, obstacles, pipes, budget, flaps, capacity, solution) :
+        reach_search_brute(&start, forced, obstacles, pipes, budget, flaps, capacity, solution);
+
+    if (result == REACH_SOLVED && !reach_replay(world, flaps, solution->ticks, pipes)) {
+        result = REACH_UNKNOWN;
+    }
+
+    free(flaps);
+    free(obstacles);
+    return result;
+}
@@ -0,0 +1,127 @@
+#ifndef FLAPPY_REACH_H_INCLUDED
+#define FLAPPY_REACH_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "world.h"
+
+// Reachability tables: for every bird state relative to the next obstacle,
+// whether gliding and whether flapping this tick still lets the bird clear
+// that obstacle. FLAP, GRAVITY, SPEED, the gap size and BIRD_RADIUS are
+// fixed, so the state is just (dx, dy, vy): obstacle x minus bird x, bird y
+// minus the gap center, and the bird's vertical velocity.
+//
+// The grid follows the simulation: dx moves one cell (SPEED * TICK) per
+// tick, and vy one cell (GRAVITY * TICK) per tick while gliding, so both
+// are exact for birds that started with a flap. Only dy is rounded to its
+// cell. The table is built backwards from the column of cleared states, one
+// dx column at a time, each column split across threads.
+//
+// Files (little-endian, written by reach_save, memory-mapped by reach_open):
+//
+//   header   struct reach_header
+//   bits     2 bits per state (REACH_GLIDE, REACH_FLAP), states ordered by
+//            dx, then dy, then vy, starting at bits_offset
+//
+// About 6 MB at the default resolution. The header records the constants
+// the table was built for, and files built for others are refused.
+//
+// Ceiling and floor are not part of the table: they would tie it to where
+// each gap is. The bot checks them for the coming tick, and the validator
+// simulates them exactly. Neither is the obstacle after the next one, so a
+// safe state can still leave the bird unable to reach the following gap;
+// the bot breaks ties with a second lookup against that obstacle, and the
+// validator backtracks.
+
+enum {
+    REACH_VERSION = 2,
+
+    // dx in [-PIPE_WIDTH, 6.35] (cleared up to the bird's start), 148 cells
+    REACH_X_MIN = -20,
+    REACH_X_COUNT = 148,
+    // dy in [-6.5, 6.5] in 1/64 steps
+    REACH_Y_COUNT = 833,
+    REACH_Y_SCALE = 64,
+    // vy from FLAP down to about -21.6
+    REACH_V_COUNT = 192,
+};
+
+// bits of a state
+enum {
+    REACH_GLIDE = 1,
+    REACH_FLAP = 2,
+};
+
+static const char REACH_MAGIC[4] = { 'F', 'L', 'P', 'R' };
+
+struct reach_header {
+    char magic[4];
+    uint32_t version;
+    int32_t x_min;
+    uint32_t x_count;
+    uint32_t y_count;
+    uint32_t v_count;
+    uint64_t bits_offset;
+    uint64_t bits_size;
+
+    // what the table was built for (see reach_open)
+    float tick;
+    float flap;
+    float gravity;
+    float speed;
+    float gap_size;
+    float radius;
+    float pipe_width;
+    float pipe_height;
+};
+
+struct reach {
+    void* data;
+    size_t size;
+    bool mapped;  // from reach_open, otherwise from reach_generate
+
+    const struct reach_header* header;
+    const unsigned char* bits;
+};
+
+bool reach_generate(struct reach* reach, long threads);
+bool reach_save(const struct reach* reach, const char* path);
+bool reach_open(struct reach* reach, const char* path);
+void reach_close(struct reach* reach);
+
+// REACH_GLIDE | REACH_FLAP bits for a state (0 if it is off the grid).
+int reach_lookup(const struct reach* reach, float dx, float dy, float vy);
+
+// Decide this tick's flap for a running world in O(1): never an action the
+// table says is doomed, and of two safe ones the one the table also allows
+// for the obstacle after (or else the one that stays nearer the gap center).
+bool reach_bot(const struct reach* reach, const struct world* world);
+
+// Search for flaps that take a world (fresh from world_init or world_reset,
+// or a running one) past its next `pipes` obstacles, simulating the bird
+// exactly as world_update does. With a table the search follows reach_bot
+// and backtracks only when that fails, trying just the other moves the
+// table allows and skipping states that already failed; without one it is
+// a brute force sweep over every bird state, tick by tick. Either way states
+// are merged on the table's grid, and at most `budget` of them are looked
+// at. A schedule that is found is replayed through world_update before
+// being reported, so REACH_SOLVED is exact.
+enum reach_result {
+    REACH_SOLVED = 0,
+    REACH_UNSOLVABLE,   // no flaps get past them, up to the grid (brute force only)
+    REACH_UNKNOWN,      // gave up: budget exhausted, or the table found nothing
+    REACH_UNSUPPORTED,  // moving obstacles, or a gap size the table was not built for
+};
+
+struct reach_solution {
+    long ticks;
+    long flaps;
+    long visited;  // states looked at
+};
+
+int reach_validate(const struct reach* reach, const struct world* world, long pipes, long budget,
+    struct reach_solution* solution);
+
+#endif
@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "config.h"
+#include "entity.h"
+#include "font.h"
+#include "particle.h"
+#include "render.h"
+#include "world.h"
+
+// Stable insertion sort by layer. Instances come out of the entity store
+// nearly in order already, and unlike qsort this never allocates.
+static void
+render_sort_instances(struct entity_instance* instances, long count)
+{
+    for (long i = 1; i < count; i++) {
+        struct entity_instance inst = instances[i];
+        long j = i;
+        while (j > 0 && instances[j - 1].z > inst.z) {
+            instances[j] = instances[j - 1];
+            j--;
+        }
+        instances[j] = inst;
+    }
+}
+
+static struct render_sprite*
+render_push(struct render_scene* scene, int texture, int mode, float x, float y, float z, float r, float sx, float sy)
+{
+    assert(scene->count < RENDER_SPRITE_CAPACITY);
+
+    struct render_sprite* sprite = &scene->sprites[scene->count++];
+    sprite->texture = texture;
+    sprite->mode = mode;
+    sprite->x = x;
+    sprite->y = y;
+    sprite->z = z;
+    sprite->r = r;
+    sprite->sx = sx;
+    sprite->sy = sy;
+    sprite->alpha = 1.0f;
+    sprite->uv[0] = 1.0f;
+    sprite->uv[1] = 1.0f;
+    sprite->uv[2] = 0.0f;
+    sprite->uv[3] = 0.0f;
+    return sprite;
+}
+
+// Describe the frame showing `world` (and the rival's bird from `ghost`, if
+// any) at `time` seconds, which only drives the background scroll. Scratch
+// space and the returned arrays come from the arena, so the scene lives
+// until it is reset. Runs out of arena space by drawing less.
+void
+render_scene_build(struct render_scene* scene, struct arena* arena,
+    const struct world* world, const struct world* ghost, const struct particle_pool* particles, double time)
+{
+    assert(scene != NULL);
+    assert(arena != NULL);
+    assert(world != NULL);
+
+    scene->count = 0;
+    scene->particles = particles;
+    scene->camera = world->camera;
+    scene->hud_size = 0;
+
+    scene->sprites = arena_alloc(arena, RENDER_SPRITE_CAPACITY * sizeof(*scene->sprites));
+    struct entity_instance* instances = arena_alloc(arena, ENTITY_CAPACITY * sizeof(*instances));
+    if (scene->sprites != NULL && instances != NULL) {
+        // background as one quad scrolling over the repeating texture
+        //  (scrolls independently of game objects)
+        float bg_offset = fmod(time * SCROLL, BG_WIDTH);
+        struct render_sprite* bg = render_push(scene, RENDER_TEXTURE_BG, RENDER_MODE_OPAQUE,
+            0.0f, 0.0f, BG_LAYER,
+            0.0f, WIDTH, BG_HEIGHT);
+        bg->uv[0] = WIDTH / BG_WIDTH;
+        bg->uv[2] = (bg_offset - WIDTH / 2.0f) / BG_WIDTH + 0.5f;
+
+        // game objects back to front: pipes have hard edges, birds are blended
+        long count = entity_emit(&world->entities, world->camera, instances, ENTITY_CAPACITY);
+        render_sort_instances(instances, count);
+        for (long i = 0; i < count; i++) {
+            const struct entity_instance* inst = &instances[i];
+            int texture = RENDER_TEXTURE_WHITE;
+            int mode = RENDER_MODE_CUTOUT;
+            switch (inst->sprite) {
+            case SPRITE_BIRD: texture = RENDER_TEXTURE_BIRD; mode = RENDER_MODE_BLEND; break;
+            case SPRITE_PIPE_TOP: texture = RENDER_TEXTURE_PIPE_TOP; break;
+            case SPRITE_PIPE_BOT: texture = RENDER_TEXTURE_PIPE_BOT; break;
+            default: continue;
+            }
+            render_push(scene, texture, mode, inst->x, inst->y, inst->z, inst->r, inst->sx, inst->sy);
+        }
+
+        // the rival's bird as a see-through ghost
+        if (ghost != NULL) {
+            const struct entity_store* entities = &ghost->entities;
+            struct render_sprite* sprite = render_push(scene, RENDER_TEXTURE_BIRD, RENDER_MODE_BLEND,
+                entities->pos_x[WORLD_BIRD] - world->camera, entities->pos_y[WORLD_BIRD], BIRD_LAYER,
+                entities->vel_y[WORLD_BIRD] * BIRD_SPIN, BIRD_WIDTH, BIRD_HEIGHT);
+            sprite->alpha = 0.5f;
+        }
+    }
+
+    // score (amazing 4x4 bitmap font clarity)
+    scene->hud = arena_alloc(arena, RENDER_HUD_SIZE);
+    if (scene->hud != NULL) {
+        char score_text[RENDER_SCORE_CHARS + 1] = { 0 };
+        snprintf(score_text, sizeof(score_text), "%.3ld", world->score);
+
+        long size = font_size(score_text);
+        if (size <= RENDER_HUD_SIZE) {
+            font_print(score_text, scene->hud, size);
+            font_place(scene->hud, size, -WIDTH / 2.0f + 1.0f, HEIGHT / 2.0f - 1.0f, 0.5f, 0.5f);
+            scene->hud_size = size;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FLAPPY_RENDER_H_INCLUDED
+#define FLAPPY_RENDER_H_INCLUDED
+
+#include "arena.h"
+#include "entity.h"
+#include "font.h"
+#include "particle.h"
+#include "perf.h"
+#include "world.h"
+
+// Backend-neutral description of one frame: what to draw and how it is
+// composited, with no GL (or any other) handles in it. The GL path in main.c
+// and the software rasterizer (see softrender.h) both draw from this, so they
+// agree on every position, texcoord, and blend mode.
+//
+// Everything is in view units (WIDTH x HEIGHT, centred on the origin) and
+// every sprite is the unit quad [-0.5, 0.5] with texcoords [0, 1], scaled,
+// rotated, and then moved into place.
+
+enum {
+    // every entity plus the background and the rival's ghost
+    RENDER_SPRITE_CAPACITY = ENTITY_CAPACITY + 2,
+
+    // HUD vertices: the score (up to RENDER_SCORE_CHARS digits) plus the
+    // perf overlay appended to it, both at their largest
+    RENDER_SCORE_CHARS = 15,
+    RENDER_HUD_SIZE = RENDER_SCORE_CHARS * FONT_GLYPH_MAX_SIZE + PERF_OVERLAY_SIZE,
+};
+
+enum render_texture {
+    RENDER_TEXTURE_WHITE = 0,  // single white texel (particles, HUD)
+    RENDER_TEXTURE_BG,
+    RENDER_TEXTURE_BIRD,
+    RENDER_TEXTURE_PIPE_TOP,
+    RENDER_TEXTURE_PIPE_BOT,
+    RENDER_TEXTURE_COUNT,
+};
+
+enum render_mode {
+    RENDER_MODE_OPAQUE = 0,  // texture alpha ignored
+    RENDER_MODE_CUTOUT,      // hard edges, texels with alpha below 0.5 are skipped
+    RENDER_MODE_BLEND,       // alpha blended, faded by the sprite's alpha
+};
+
+struct render_sprite {
+    int texture;  // enum render_texture
+    int mode;     // enum render_mode
+    float x;
+    float y;
+    float z;
+    float r;      // degrees counterclockwise
+    float sx;
+    float sy;
+    float alpha;
+    float uv[4];  // texcoord scale (xy) and offset (zw)
+};
+
+struct render_scene {
+    // sprites in painter's order (back to front)
+    struct render_sprite* sprites;
+    long count;
+
+    // drawn above the sprites as white squares faded by their alpha, in
+    // world space (shifted left by the camera)
+    const struct particle_pool* particles;
+    float camera;
+
+    // vertices in the format of font_print, already placed in view units,
+    // drawn solid white on top of everything
+    float* hud;
+    long hud_size;  // bytes
+};
+
+void render_scene_build(struct render_scene* scene, struct arena* arena,
+    const struct world* world, const struct world* ghost, const struct particle_pool* particles, double time);
+
+#endif
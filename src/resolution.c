@@ -0,0 +1,67 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "resolution.h"
+
+// weight of the newest frame in the rolling average
+static const double RESOLUTION_SMOOTHING = 0.1;
+
+// only react once the average leaves this band around the budget, so the
+// scale doesn't hunt back and forth every frame
+static const double RESOLUTION_SLOW = 1.05;
+static const double RESOLUTION_FAST = 0.85;
+static const double RESOLUTION_ON_BUDGET = 1.02;
+
+// fraction of the estimated correction applied per frame
+static const float RESOLUTION_RATE = 0.1f;
+
+// with vsync the frame time never drops below the budget, so while on
+// budget keep creeping back up (a step this size costs ~1% per second)
+static const float RESOLUTION_PROBE = 0.001f;
+
+static float
+resolution_clamp(float scale)
+{
+    if (scale < RESOLUTION_MIN_SCALE) return RESOLUTION_MIN_SCALE;
+    if (scale > RESOLUTION_MAX_SCALE) return RESOLUTION_MAX_SCALE;
+    return scale;
+}
+
+// A fixed_scale above zero disables adaptation.
+void
+resolution_init(struct resolution* resolution, double target_fps, float fixed_scale)
+{
+    assert(resolution != NULL);
+    assert(target_fps > 0.0);
+
+    resolution->fixed = fixed_scale > 0.0f;
+    resolution->scale = resolution->fixed ? resolution_clamp(fixed_scale) : RESOLUTION_MAX_SCALE;
+    resolution->budget = 1.0 / target_fps;
+    resolution->average = resolution->budget;
+}
+
+// Feed the last frame's duration and get the scale for the next one.
+float
+resolution_update(struct resolution* resolution, double frame_time)
+{
+    assert(resolution != NULL);
+
+    if (resolution->fixed) return resolution->scale;
+
+    resolution->average += (frame_time - resolution->average) * RESOLUTION_SMOOTHING;
+
+    // fill rate bound: cost follows the pixel count, the square of the scale
+    double ratio = resolution->average / resolution->budget;
+    if (ratio > RESOLUTION_SLOW || ratio < RESOLUTION_FAST) {
+        float target = resolution->scale / sqrtf((float)ratio);
+        resolution->scale += (target - resolution->scale) * RESOLUTION_RATE;
+    } else if (ratio < RESOLUTION_ON_BUDGET) {
+        resolution->scale += RESOLUTION_PROBE;
+    }
+
+    resolution->scale = resolution_clamp(resolution->scale);
+
+    return resolution->scale;
+}
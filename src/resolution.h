@@ -0,0 +1,23 @@
+#ifndef FLAPPY_RESOLUTION_H_INCLUDED
+#define FLAPPY_RESOLUTION_H_INCLUDED
+
+#include <stdbool.h>
+
+// Dynamic resolution: picks the fraction of the output size to render at
+// so that a rolling average of the frame time stays within a budget. The
+// scene is rendered at that scale and then upscaled to the window.
+
+static const float RESOLUTION_MIN_SCALE = 0.25f;
+static const float RESOLUTION_MAX_SCALE = 1.0f;
+
+struct resolution {
+    float scale;     // current fraction of the output width and height
+    bool fixed;      // never adapt (set with --render-scale)
+    double budget;   // target seconds per frame
+    double average;  // rolling average of measured frame time (seconds)
+};
+
+void resolution_init(struct resolution* resolution, double target_fps, float fixed_scale);
+float resolution_update(struct resolution* resolution, double frame_time);
+
+#endif
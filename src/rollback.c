@@ -0,0 +1,202 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "course.h"
+#include "rollback.h"
+#include "world.h"
+
+// FNV-1a over the parts of a world that any divergence would show up in
+static uint32_t
+rollback_hash(uint32_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t
+rollback_hash_world(uint32_t hash, const struct world* world)
+{
+    const struct entity_store* entities = &world->entities;
+    hash = rollback_hash(hash, &world->dead, sizeof(world->dead));
+    hash = rollback_hash(hash, &world->score, sizeof(world->score));
+    hash = rollback_hash(hash, &world->ticks, sizeof(world->ticks));
+    hash = rollback_hash(hash, &world->camera, sizeof(world->camera));
+    hash = rollback_hash(hash, &entities->count, sizeof(entities->count));
+    hash = rollback_hash(hash, entities->pos_x, entities->count * sizeof(entities->pos_x[0]));
+    hash = rollback_hash(hash, entities->pos_y, entities->count * sizeof(entities->pos_y[0]));
+    hash = rollback_hash(hash, entities->vel_y, entities->count * sizeof(entities->vel_y[0]));
+    return hash;
+}
+
+static void
+rollback_copy_state(struct rollback_state* dst, const struct rollback_state* src)
+{
+    for (int p = 0; p < ROLLBACK_PLAYERS; p++) {
+        world_copy(&dst->worlds[p], &src->worlds[p]);
+    }
+}
+
+// Save the state at the start of the current frame, then advance it by one
+// tick using the local input and the real (or predicted) remote input.
+static void
+rollback_simulate(struct rollback* rollback)
+{
+    long frame = rollback->frame;
+    int local = rollback->local;
+    int remote = 1 - local;
+
+    rollback_copy_state(&rollback->saved[frame % ROLLBACK_STATES], &rollback->current);
+
+    bool remote_flap = false;
+    if (frame <= rollback->remote_frame) {
+        remote_flap = rollback->inputs[remote][frame % ROLLBACK_INPUTS];
+    }
+    rollback->used[frame % ROLLBACK_INPUTS] = remote_flap;
+
+    bool local_flap = rollback->inputs[local][frame % ROLLBACK_INPUTS];
+    world_update(&rollback->current.worlds[local], local_flap, TICK);
+    world_update(&rollback->current.worlds[remote], remote_flap, TICK);
+
+    rollback->frame++;
+}
+
+struct rollback*
+rollback_create(int local, long delay, struct course* course, unsigned int seed)
+{
+    assert(local == 0 || local == 1);
+
+    if (delay < 0 || delay > ROLLBACK_MAX_DELAY) {
+        fprintf(stderr, "input delay must be within [0, %d] frames\n", ROLLBACK_MAX_DELAY);
+        return NULL;
+    }
+
+    struct rollback* rollback = calloc(1, sizeof(*rollback));
+    if (rollback == NULL) {
+        fprintf(stderr, "failed to allocate rollback state\n");
+        return NULL;
+    }
+
+    rollback->local = local;
+    rollback->delay = delay;
+    rollback->frame = 0;
+    rollback->local_frame = -1;
+    rollback->remote_frame = -1;
+    rollback->resim_frame = LONG_MAX;
+
+    // both birds race the same course
+    for (int p = 0; p < ROLLBACK_PLAYERS; p++) {
+        world_init(&rollback->current.worlds[p], course, seed);
+    }
+
+    return rollback;
+}
+
+void
+rollback_destroy(struct rollback* rollback)
+{
+    free(rollback);
+}
+
+// Advance one frame. Returns false (without consuming the flap) when the
+// simulation is too far ahead of the remote player and must wait for them.
+bool
+rollback_step(struct rollback* rollback, bool flap)
+{
+    assert(rollback != NULL);
+
+    if (rollback->frame - rollback->remote_frame > ROLLBACK_WINDOW) {
+        return false;
+    }
+
+    // schedule the local input
+    rollback->local_frame = rollback->frame + rollback->delay;
+    rollback->inputs[rollback->local][rollback->local_frame % ROLLBACK_INPUTS] = flap;
+
+    // a late remote input contradicted a prediction: rewind and replay
+    if (rollback->resim_frame < rollback->frame) {
+        long target = rollback->frame;
+        rollback->frame = rollback->resim_frame;
+        rollback_copy_state(&rollback->current, &rollback->saved[rollback->frame % ROLLBACK_STATES]);
+        while (rollback->frame < target) {
+            rollback_simulate(rollback);
+        }
+
+        rollback->rollbacks++;
+        rollback->resimulated += target - rollback->resim_frame;
+    }
+    rollback->resim_frame = LONG_MAX;
+
+    rollback_simulate(rollback);
+    return true;
+}
+
+void
+rollback_add_remote(struct rollback* rollback, long frame, bool flap)
+{
+    assert(rollback != NULL);
+
+    // only accept the next input in sequence (duplicates are expected)
+    if (frame != rollback->remote_frame + 1) return;
+    if (frame >= rollback->frame - ROLLBACK_WINDOW + ROLLBACK_INPUTS) return;
+
+    int remote = 1 - rollback->local;
+    rollback->inputs[remote][frame % ROLLBACK_INPUTS] = flap;
+    rollback->remote_frame = frame;
+
+    if (frame < rollback->frame && rollback->used[frame % ROLLBACK_INPUTS] != flap) {
+        if (frame < rollback->resim_frame) rollback->resim_frame = frame;
+    }
+}
+
+// Copy scheduled local inputs starting at `first` (for sending to the peer).
+long
+rollback_local_inputs(const struct rollback* rollback, long first, unsigned char* inputs, long capacity)
+{
+    assert(rollback != NULL);
+    assert(inputs != NULL);
+
+    long count = 0;
+    for (long frame = first; frame <= rollback->local_frame && count < capacity; frame++) {
+        inputs[count++] = rollback->inputs[rollback->local][frame % ROLLBACK_INPUTS];
+    }
+    return count;
+}
+
+const struct world*
+rollback_world(const struct rollback* rollback, int player)
+{
+    assert(rollback != NULL);
+    assert(player >= 0 && player < ROLLBACK_PLAYERS);
+    return &rollback->current.worlds[player];
+}
+
+// Checksum of the state at the start of a frame whose inputs are all final
+// (every earlier input from both players is known). Peers compare these to
+// detect desyncs.
+bool
+rollback_checksum(const struct rollback* rollback, long frame, uint32_t* checksum)
+{
+    assert(rollback != NULL);
+    assert(checksum != NULL);
+
+    if (frame > rollback->remote_frame + 1 || frame >= rollback->frame) return false;
+    if (frame <= rollback->frame - ROLLBACK_STATES || frame >= rollback->resim_frame) return false;
+
+    const struct rollback_state* state = &rollback->saved[frame % ROLLBACK_STATES];
+    uint32_t hash = 2166136261u;
+    for (int p = 0; p < ROLLBACK_PLAYERS; p++) {
+        hash = rollback_hash_world(hash, &state->worlds[p]);
+    }
+
+    *checksum = hash;
+    return true;
+}
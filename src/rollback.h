@@ -0,0 +1,66 @@
+#ifndef FLAPPY_ROLLBACK_H_INCLUDED
+#define FLAPPY_ROLLBACK_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "course.h"
+#include "world.h"
+
+// GGPO-style rollback for two players racing the same seeded course. Each
+// player's bird lives in its own world, stepped at a fixed TICK. Local flaps
+// are scheduled `delay` frames ahead; remote flaps that haven't arrived yet
+// are predicted as "no flap". When a late remote input contradicts the
+// prediction, the saved state of that frame is restored and every frame since
+// is simulated again, all within a single call to rollback_step.
+
+enum {
+    ROLLBACK_PLAYERS = 2,
+
+    // how far the simulation may run ahead of the last confirmed remote input
+    ROLLBACK_WINDOW = 12,
+
+    // largest supported input delay (in frames)
+    ROLLBACK_MAX_DELAY = 8,
+
+    // ring sizes: saved states cover the window, inputs also cover what
+    // the remote may have sent ahead of us (both powers of two)
+    ROLLBACK_STATES = 16,
+    ROLLBACK_INPUTS = 64,
+};
+
+struct rollback_state {
+    struct world worlds[ROLLBACK_PLAYERS];
+};
+
+struct rollback {
+    int local;
+    long delay;
+
+    long frame;         // next frame to simulate
+    long local_frame;   // last frame with a scheduled local input
+    long remote_frame;  // last frame with a received (contiguous) remote input
+    long resim_frame;   // earliest frame that must be simulated again
+
+    unsigned char inputs[ROLLBACK_PLAYERS][ROLLBACK_INPUTS];
+    unsigned char used[ROLLBACK_INPUTS];  // remote input each frame was simulated with
+
+    struct rollback_state current;
+    struct rollback_state saved[ROLLBACK_STATES];  // state at the start of each frame
+
+    // counters for reporting
+    long rollbacks;
+    long resimulated;
+};
+
+struct rollback* rollback_create(int local, long delay, struct course* course, unsigned int seed);
+void rollback_destroy(struct rollback* rollback);
+
+bool rollback_step(struct rollback* rollback, bool flap);
+void rollback_add_remote(struct rollback* rollback, long frame, bool flap);
+long rollback_local_inputs(const struct rollback* rollback, long first, unsigned char* inputs, long capacity);
+
+const struct world* rollback_world(const struct rollback* rollback, int player);
+bool rollback_checksum(const struct rollback* rollback, long frame, uint32_t* checksum);
+
+#endif
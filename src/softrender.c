@@ -0,0 +1,676 @@
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "particle.h"
+#include "render.h"
+#include "softrender.h"
+#include "texture.h"
+
+#ifndef M_PI
+#define M_PI 3.141592653589793
+#endif
+
+// Use GCC / Clang vector extensions when available: they lower to SSE on x86
+// and NEON on ARM without tying the code to either instruction set.
+#if defined(__GNUC__)
+#define SOFTRENDER_SIMD 1
+typedef float v4sf __attribute__((vector_size(16)));
+typedef int v4si __attribute__((vector_size(16)));
+typedef unsigned int v4su __attribute__((vector_size(16)));
+typedef unsigned short v8hu __attribute__((vector_size(16)));
+#else
+#define SOFTRENDER_SIMD 0
+#endif
+
+enum {
+    SOFTRENDER_TILE_PIXELS = SOFTRENDER_TILE * SOFTRENDER_TILE,
+    SOFTRENDER_TILE_SLACK = 4,  // one vector past the last pixel
+
+    // HUD vertices come as two triangles per quad (see font.c)
+    SOFTRENDER_HUD_FLOATS_PER_QUAD = 12,
+};
+
+static const unsigned char SOFTRENDER_WHITE[] = { 0xff, 0xff, 0xff, 0xff };
+static const float SOFTRENDER_UV_IDENTITY[] = { 1.0f, 1.0f, 0.0f, 0.0f };
+
+// Texels packed as R | G << 8 | B << 16 | A << 24, with one extra column and
+// row repeating the first ones so that bilinear filtering only ever has to
+// wrap the first of its two texels.
+struct softrender_texture {
+    long width;
+    long height;
+    uint32_t* texels;
+};
+
+// One draw in pixel space. The unit quad coordinates (s, t) are linear in
+// the pixel position, so each is kept as its value at the centre of pixel
+// (0, 0) plus its steps along x and y.
+struct softrender_command {
+    int texture;
+    int mode;
+    float alpha;
+    float uv[4];
+    float s0, ds_dx, ds_dy;
+    float t0, dt_dx, dt_dy;
+    int x0, y0, x1, y1;  // pixel bounds (max exclusive)
+};
+
+struct softrender_worker {
+    struct softrender* sr;
+    long index;
+    pthread_t thread;
+    bool started;
+
+    // tile being shaded (packed like texels, plus SOFTRENDER_TILE_SLACK)
+    uint32_t* color;
+};
+
+struct softrender {
+    long width;
+    long height;
+    unsigned char* pixels;
+    long pixels_capacity;  // bytes
+
+    struct softrender_texture textures[RENDER_TEXTURE_COUNT];
+
+    // this frame's draws and particle instances
+    struct softrender_command* commands;
+    long command_count;
+    long command_capacity;
+    float* instances;
+    long instance_capacity;
+
+    // command indices per tile, in draw order: tile i owns
+    // bin_items[bin_start[i], bin_start[i + 1])
+    long tiles_x;
+    long tiles_y;
+    long* bin_start;
+    long bin_start_capacity;
+    long* bin_fill;
+    long bin_fill_capacity;
+    int* bin_items;
+    long bin_item_capacity;
+
+    // worker pool (worker 0 is the calling thread)
+    long threads;
+    struct softrender_worker workers[SOFTRENDER_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;
+    long pending;
+    bool stop;
+};
+
+// Make room for `count` items of `item_size` bytes, doubling as needed.
+// Returns NULL (leaving `array` as it was) when out of memory.
+static void*
+softrender_grow(void* array, long* capacity, long count, long item_size)
+{
+    if (array != NULL && count <= *capacity) return array;
+
+    long grown = *capacity > 0 ? *capacity : 64;
+    while (grown < count) grown *= 2;
+
+    void* resized = realloc(array, grown * item_size);
+    if (resized == NULL) {
+        fprintf(stderr, "failed to grow software renderer storage\n");
+        return NULL;
+    }
+
+    *capacity = grown;
+    return resized;
+}
+
+#if !SOFTRENDER_SIMD
+// Blend two packed texels by w / 256, two channels per multiply.
+static uint32_t
+softrender_lerp(uint32_t a, uint32_t b, uint32_t w)
+{
+    uint32_t rb = (((a & 0x00ff00ff) * (256 - w) + (b & 0x00ff00ff) * w) >> 8) & 0x00ff00ff;
+    uint32_t ga = (((a >> 8) & 0x00ff00ff) * (256 - w) + ((b >> 8) & 0x00ff00ff) * w) & 0xff00ff00;
+    return rb | ga;
+}
+
+// Bilinear fetch at fixed-point texel coordinates (8 bits of subtexel
+// precision, what GPUs use), with repeating texcoords.
+static uint32_t
+softrender_fetch(const struct softrender_texture* tex, long x, long y)
+{
+    long ix = x >> 8;
+    long iy = y >> 8;
+    if (ix >= tex->width) ix -= tex->width;
+    if (iy >= tex->height) iy -= tex->height;
+
+    long stride = tex->width + 1;
+    const uint32_t* p = tex->texels + iy * stride + ix;
+    uint32_t top = softrender_lerp(p[0], p[1], x & 255);
+    uint32_t bottom = softrender_lerp(p[stride], p[stride + 1], x & 255);
+    return softrender_lerp(top, bottom, y & 255);
+}
+#endif
+
+// Fixed-point texel coordinate of a texcoord. The texture repeats, so only
+// the fraction matters; shifting it by a whole texture keeps the result
+// positive (truncation rounds down) and within [size - 1, 2 * size).
+static long
+softrender_texel(float u, long size)
+{
+    float fraction = u - (long)u;
+    if (fraction < 0.0f) fraction += 1.0f;
+    return (fraction * size - 0.5f + size) * 256.0f;
+}
+
+#if SOFTRENDER_SIMD
+// Blend four pairs of packed texels by w / 256. Every channel times its
+// weight fits in 16 bits, so the products are done in 16-bit lanes (a 32-bit
+// vector multiply needs SSE4.1, 16-bit ones are in baseline SSE2 and NEON).
+static v4su
+softrender_lerp4(v4su a, v4su b, v4su w)
+{
+    v8hu wb = (v8hu)(w | w << 16);
+    v8hu wa = 256 - wb;
+    v8hu rb = ((v8hu)(a & 0x00ff00ff) * wa + (v8hu)(b & 0x00ff00ff) * wb) >> 8;
+    v8hu ga = ((v8hu)((a >> 8) & 0x00ff00ff) * wa + (v8hu)((b >> 8) & 0x00ff00ff) * wb) & 0xff00;
+    return (v4su)rb | (v4su)ga;
+}
+
+// Top left texel of the bilinear footprint at (u, v), plus the fractional
+// weights towards the texel to the right and the one above.
+static const uint32_t*
+softrender_footprint(const struct softrender_texture* tex, float u, float v, uint32_t* wx, uint32_t* wy)
+{
+    long x = softrender_texel(u, tex->width);
+    long y = softrender_texel(v, tex->height);
+    long ix = x >> 8;
+    long iy = y >> 8;
+    if (ix >= tex->width) ix -= tex->width;
+    if (iy >= tex->height) iy -= tex->height;
+
+    *wx = x & 255;
+    *wy = y & 255;
+    return tex->texels + iy * (tex->width + 1) + ix;
+}
+
+// Four bilinear fetches: the texel loads go one by one, the filtering is
+// done for all four at once. (Vectors are built from whole values rather
+// than lane by lane, which would bounce them through memory.)
+static v4su
+softrender_fetch4(const struct softrender_texture* tex, v4sf u, v4sf v)
+{
+    long stride = tex->width + 1;
+    uint32_t wx0, wx1, wx2, wx3, wy0, wy1, wy2, wy3;
+    const uint32_t* p0 = softrender_footprint(tex, u[0], v[0], &wx0, &wy0);
+    const uint32_t* p1 = softrender_footprint(tex, u[1], v[1], &wx1, &wy1);
+    const uint32_t* p2 = softrender_footprint(tex, u[2], v[2], &wx2, &wy2);
+    const uint32_t* p3 = softrender_footprint(tex, u[3], v[3], &wx3, &wy3);
+
+    v4su p00 = { p0[0], p1[0], p2[0], p3[0] };
+    v4su p01 = { p0[1], p1[1], p2[1], p3[1] };
+    v4su p10 = { p0[stride], p1[stride], p2[stride], p3[stride] };
+    v4su p11 = { p0[stride + 1], p1[stride + 1], p2[stride + 1], p3[stride + 1] };
+    v4su wx = { wx0, wx1, wx2, wx3 };
+    v4su wy = { wy0, wy1, wy2, wy3 };
+    return softrender_lerp4(softrender_lerp4(p00, p01, wx), softrender_lerp4(p10, p11, wx), wy);
+}
+#endif
+
+// Composite one command into the part of a tile it covers. Like GL, every
+// draw is blended into 8 bits per channel: dst + (src - dst) * a.
+static void
+softrender_shade(const struct softrender* sr, const struct softrender_command* cmd, uint32_t* color, long tile_x, long tile_y)
+{
+    long x0 = cmd->x0 > tile_x ? cmd->x0 : tile_x;
+    long y0 = cmd->y0 > tile_y ? cmd->y0 : tile_y;
+    long x1 = cmd->x1 < tile_x + SOFTRENDER_TILE ? cmd->x1 : tile_x + SOFTRENDER_TILE;
+    long y1 = cmd->y1 < tile_y + SOFTRENDER_TILE ? cmd->y1 : tile_y + SOFTRENDER_TILE;
+
+    const struct softrender_texture* tex = &sr->textures[cmd->texture];
+    uint32_t alpha = cmd->alpha * 255.0f + 0.5f;
+    for (long y = y0; y < y1; y++) {
+        uint32_t* row = color + (y - tile_y) * SOFTRENDER_TILE;
+        float s_row = cmd->s0 + cmd->ds_dx * x0 + cmd->ds_dy * y;
+        float t_row = cmd->t0 + cmd->dt_dx * x0 + cmd->dt_dy * y;
+
+#if SOFTRENDER_SIMD
+        // four pixels at a time
+        const v4sf lane = { 0.0f, 1.0f, 2.0f, 3.0f };
+        for (long x = x0; x < x1; x += 4) {
+            long n = x1 - x < 4 ? x1 - x : 4;
+            v4sf k = lane + (float)(x - x0);
+            v4sf s = s_row + cmd->ds_dx * k;
+            v4sf t = t_row + cmd->dt_dx * k;
+            v4si inside = (s >= 0.0f) & (s < 1.0f) & (t >= 0.0f) & (t < 1.0f) & (lane < (float)n);
+
+            int mask[4];
+            memcpy(mask, &inside, sizeof(mask));
+            if ((mask[0] | mask[1] | mask[2] | mask[3]) == 0) continue;
+
+            // lanes outside the quad still sample the (repeating) texture,
+            // they are masked out of the blend below
+            v4su src = softrender_fetch4(tex, s * cmd->uv[0] + cmd->uv[2], t * cmd->uv[1] + cmd->uv[3]);
+
+            v4su w = { 256, 256, 256, 256 };
+            if (cmd->mode == RENDER_MODE_CUTOUT) w &= (v4su)(src >= 0x80000000u);
+            if (cmd->mode == RENDER_MODE_BLEND) {
+                w = ((src >> 24) * alpha * 257 + 0x8080) >> 16;
+                w += w >> 7;
+            }
+            w &= (v4su)inside;
+
+            // whole vectors even at the end of a span: masked lanes are
+            // written back unchanged (the tile has room to spare for that)
+            v4su dst;
+            memcpy(&dst, row + (x - tile_x), sizeof(dst));
+            dst = softrender_lerp4(dst, src, w);
+            memcpy(row + (x - tile_x), &dst, sizeof(dst));
+        }
+#else
+        for (long x = x0; x < x1; x++) {
+            float s = s_row + cmd->ds_dx * (x - x0);
+            float t = t_row + cmd->dt_dx * (x - x0);
+            if (s < 0.0f || s >= 1.0f || t < 0.0f || t >= 1.0f) continue;
+
+            uint32_t src = softrender_fetch(tex,
+                softrender_texel(s * cmd->uv[0] + cmd->uv[2], tex->width),
+                softrender_texel(t * cmd->uv[1] + cmd->uv[3], tex->height));
+
+            uint32_t w = 256;
+            if (cmd->mode == RENDER_MODE_CUTOUT && (src >> 24) < 128) continue;
+            if (cmd->mode == RENDER_MODE_BLEND) {
+                w = ((src >> 24) * alpha * 257 + 0x8080) >> 16;
+                w += w >> 7;
+            }
+
+            row[x - tile_x] = softrender_lerp(row[x - tile_x], src, w);
+        }
+#endif
+    }
+}
+
+// Shade every command binned to a tile, then store the tile.
+static void
+softrender_tile(struct softrender* sr, uint32_t* color, long tile)
+{
+    long tile_x = (tile % sr->tiles_x) * SOFTRENDER_TILE;
+    long tile_y = (tile / sr->tiles_x) * SOFTRENDER_TILE;
+
+    // cleared to black, like the GL path
+    memset(color, 0, SOFTRENDER_TILE_PIXELS * sizeof(uint32_t));
+    for (long i = sr->bin_start[tile]; i < sr->bin_start[tile + 1]; i++) {
+        softrender_shade(sr, &sr->commands[sr->bin_items[i]], color, tile_x, tile_y);
+    }
+
+    long w = sr->width - tile_x < SOFTRENDER_TILE ? sr->width - tile_x : SOFTRENDER_TILE;
+    long h = sr->height - tile_y < SOFTRENDER_TILE ? sr->height - tile_y : SOFTRENDER_TILE;
+    for (long y = 0; y < h; y++) {
+        const uint32_t* src = color + y * SOFTRENDER_TILE;
+        unsigned char* row = sr->pixels + ((tile_y + y) * sr->width + tile_x) * 4;
+        for (long x = 0; x < w; x++) {
+            row[x * 4 + 0] = src[x];
+            row[x * 4 + 1] = src[x] >> 8;
+            row[x * 4 + 2] = src[x] >> 16;
+            row[x * 4 + 3] = 255;
+        }
+    }
+}
+
+// Tiles are dealt out round-robin: neighbours go to different threads,
+// which spreads busy regions (the bird, the HUD) across all of them.
+static void
+softrender_run(struct softrender* sr, struct softrender_worker* worker)
+{
+    long tiles = sr->tiles_x * sr->tiles_y;
+    for (long tile = worker->index; tile < tiles; tile += sr->threads) {
+        softrender_tile(sr, worker->color, tile);
+    }
+}
+
+static void*
+softrender_worker_run(void* arg)
+{
+    struct softrender_worker* worker = arg;
+    struct softrender* sr = worker->sr;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&sr->lock);
+    for (;;) {
+        while (sr->generation == seen && !sr->stop) {
+            pthread_cond_wait(&sr->start, &sr->lock);
+        }
+        if (sr->stop) break;
+        seen = sr->generation;
+        pthread_mutex_unlock(&sr->lock);
+
+        softrender_run(sr, worker);
+
+        pthread_mutex_lock(&sr->lock);
+        if (--sr->pending == 0) pthread_cond_signal(&sr->done);
+    }
+    pthread_mutex_unlock(&sr->lock);
+    return NULL;
+}
+
+struct softrender*
+softrender_create(long threads)
+{
+    if (threads < 1) threads = 1;
+    if (threads > SOFTRENDER_MAX_THREADS) threads = SOFTRENDER_MAX_THREADS;
+
+    struct softrender* sr = calloc(1, sizeof(*sr));
+    if (sr == NULL) {
+        fprintf(stderr, "failed to allocate software renderer\n");
+        return NULL;
+    }
+
+    sr->threads = threads;
+    pthread_mutex_init(&sr->lock, NULL);
+    pthread_cond_init(&sr->start, NULL);
+    pthread_cond_init(&sr->done, NULL);
+
+    for (long t = 0; t < threads; t++) {
+        struct softrender_worker* worker = &sr->workers[t];
+        worker->sr = sr;
+        worker->index = t;
+        worker->color = malloc((SOFTRENDER_TILE_PIXELS + SOFTRENDER_TILE_SLACK) * sizeof(uint32_t));
+        if (worker->color == NULL) {
+            fprintf(stderr, "failed to allocate software renderer tile\n");
+            softrender_destroy(sr);
+            return NULL;
+        }
+        if (t == 0) continue;
+
+        if (pthread_create(&worker->thread, NULL, softrender_worker_run, worker) != 0) {
+            fprintf(stderr, "failed to start software renderer thread\n");
+            softrender_destroy(sr);
+            return NULL;
+        }
+        worker->started = true;
+    }
+
+    if (!softrender_texture(sr, RENDER_TEXTURE_WHITE, TEXTURE_FORMAT_RGBA, 1, 1, SOFTRENDER_WHITE)) {
+        softrender_destroy(sr);
+        return NULL;
+    }
+
+    return sr;
+}
+
+void
+softrender_destroy(struct softrender* sr)
+{
+    if (sr == NULL) return;
+
+    pthread_mutex_lock(&sr->lock);
+    sr->stop = true;
+    pthread_cond_broadcast(&sr->start);
+    pthread_mutex_unlock(&sr->lock);
+    for (long t = 0; t < sr->threads; t++) {
+        if (sr->workers[t].started) pthread_join(sr->workers[t].thread, NULL);
+        free(sr->workers[t].color);
+    }
+    pthread_mutex_destroy(&sr->lock);
+    pthread_cond_destroy(&sr->start);
+    pthread_cond_destroy(&sr->done);
+
+    for (long i = 0; i < RENDER_TEXTURE_COUNT; i++) {
+        free(sr->textures[i].texels);
+    }
+    free(sr->pixels);
+    free(sr->commands);
+    free(sr->instances);
+    free(sr->bin_start);
+    free(sr->bin_fill);
+    free(sr->bin_items);
+    free(sr);
+}
+
+// Pixels are rows of RGB or RGBA bytes, bottom row first (as in the resource
+// headers and glTexImage2D).
+bool
+softrender_texture(struct softrender* sr, int texture, int format, long width, long height, const unsigned char* pixels)
+{
+    assert(sr != NULL);
+    assert(texture >= 0 && texture < RENDER_TEXTURE_COUNT);
+    assert(pixels != NULL);
+
+    long channels = 0;
+    if (format == TEXTURE_FORMAT_RGB) {
+        channels = 3;
+    } else if (format == TEXTURE_FORMAT_RGBA) {
+        channels = 4;
+    } else {
+        fprintf(stderr, "invalid texture format: %d\n", format);
+        return false;
+    }
+    if (width <= 0 || height <= 0) {
+        fprintf(stderr, "invalid texture size: %ldx%ld\n", width, height);
+        return false;
+    }
+
+    uint32_t* texels = malloc((width + 1) * (height + 1) * sizeof(*texels));
+    if (texels == NULL) {
+        fprintf(stderr, "failed to allocate software texture\n");
+        return false;
+    }
+
+    uint32_t* texel = texels;
+    for (long y = 0; y <= height; y++) {
+        for (long x = 0; x <= width; x++) {
+            const unsigned char* src = pixels + ((y % height) * width + (x % width)) * channels;
+            uint32_t a = channels == 4 ? src[3] : 255;
+            *texel++ = src[0] | (uint32_t)src[1] << 8 | (uint32_t)src[2] << 16 | a << 24;
+        }
+    }
+
+    free(sr->textures[texture].texels);
+    sr->textures[texture].width = width;
+    sr->textures[texture].height = height;
+    sr->textures[texture].texels = texels;
+    return true;
+}
+
+bool
+softrender_resize(struct softrender* sr, long width, long height)
+{
+    assert(sr != NULL);
+
+    if (width <= 0 || height <= 0) {
+        fprintf(stderr, "invalid framebuffer size: %ldx%ld\n", width, height);
+        return false;
+    }
+    if (width == sr->width && height == sr->height) return true;
+
+    unsigned char* pixels = softrender_grow(sr->pixels, &sr->pixels_capacity, width * height * 4, 1);
+    if (pixels == NULL) return false;
+    sr->pixels = pixels;
+
+    long tiles_x = (width + SOFTRENDER_TILE - 1) / SOFTRENDER_TILE;
+    long tiles_y = (height + SOFTRENDER_TILE - 1) / SOFTRENDER_TILE;
+    long* bin_start = softrender_grow(sr->bin_start, &sr->bin_start_capacity, tiles_x * tiles_y + 1, sizeof(long));
+    if (bin_start == NULL) return false;
+    sr->bin_start = bin_start;
+    long* bin_fill = softrender_grow(sr->bin_fill, &sr->bin_fill_capacity, tiles_x * tiles_y, sizeof(long));
+    if (bin_fill == NULL) return false;
+    sr->bin_fill = bin_fill;
+
+    sr->width = width;
+    sr->height = height;
+    sr->tiles_x = tiles_x;
+    sr->tiles_y = tiles_y;
+    return true;
+}
+
+// Queue one unit quad, scaled by (sx, sy), rotated by r degrees, and moved
+// to (x, y) in view units. Quads entirely off screen are dropped.
+static void
+softrender_push(struct softrender* sr, int texture, int mode, float alpha, const float* uv,
+    float x, float y, float r, float sx, float sy)
+{
+    if (sx == 0.0f || sy == 0.0f) return;
+
+    float c = cosf(r * (M_PI / 180.0));
+    float sn = sinf(r * (M_PI / 180.0));
+
+    // view units per pixel
+    float px = WIDTH / sr->width;
+    float py = HEIGHT / sr->height;
+
+    // pixels whose centres fall within the rotated quad's bounding box
+    float ex = 0.5f * (fabsf(c * sx) + fabsf(sn * sy));
+    float ey = 0.5f * (fabsf(sn * sx) + fabsf(c * sy));
+    float x0 = ceilf((x - ex + WIDTH / 2.0f) / px - 0.5f);
+    float x1 = ceilf((x + ex + WIDTH / 2.0f) / px - 0.5f);
+    float y0 = ceilf((y - ey + HEIGHT / 2.0f) / py - 0.5f);
+    float y1 = ceilf((y + ey + HEIGHT / 2.0f) / py - 0.5f);
+    if (x0 < 0.0f) x0 = 0.0f;
+    if (y0 < 0.0f) y0 = 0.0f;
+    if (x1 > sr->width) x1 = sr->width;
+    if (y1 > sr->height) y1 = sr->height;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    struct softrender_command* cmd = &sr->commands[sr->command_count++];
+    cmd->texture = texture;
+    cmd->mode = mode;
+    cmd->alpha = alpha;
+    memcpy(cmd->uv, uv, sizeof(cmd->uv));
+    cmd->x0 = x0;
+    cmd->y0 = y0;
+    cmd->x1 = x1;
+    cmd->y1 = y1;
+
+    // inverse of the model transform, starting from the centre of pixel (0, 0)
+    float dx = 0.5f * px - WIDTH / 2.0f - x;
+    float dy = 0.5f * py - HEIGHT / 2.0f - y;
+    cmd->s0 = (c * dx + sn * dy) / sx + 0.5f;
+    cmd->ds_dx = c * px / sx;
+    cmd->ds_dy = sn * py / sx;
+    cmd->t0 = (-sn * dx + c * dy) / sy + 0.5f;
+    cmd->dt_dx = -sn * px / sy;
+    cmd->dt_dy = c * py / sy;
+}
+
+// Sort the commands into the tiles they touch, keeping their order.
+static bool
+softrender_bin(struct softrender* sr)
+{
+    long tiles = sr->tiles_x * sr->tiles_y;
+    memset(sr->bin_fill, 0, tiles * sizeof(long));
+    for (long i = 0; i < sr->command_count; i++) {
+        const struct softrender_command* cmd = &sr->commands[i];
+        for (long ty = cmd->y0 / SOFTRENDER_TILE; ty <= (cmd->y1 - 1) / SOFTRENDER_TILE; ty++) {
+            for (long tx = cmd->x0 / SOFTRENDER_TILE; tx <= (cmd->x1 - 1) / SOFTRENDER_TILE; tx++) {
+                sr->bin_fill[ty * sr->tiles_x + tx]++;
+            }
+        }
+    }
+
+    sr->bin_start[0] = 0;
+    for (long t = 0; t < tiles; t++) {
+        sr->bin_start[t + 1] = sr->bin_start[t] + sr->bin_fill[t];
+        sr->bin_fill[t] = sr->bin_start[t];
+    }
+
+    int* items = softrender_grow(sr->bin_items, &sr->bin_item_capacity, sr->bin_start[tiles], sizeof(int));
+    if (items == NULL) return false;
+    sr->bin_items = items;
+
+    for (long i = 0; i < sr->command_count; i++) {
+        const struct softrender_command* cmd = &sr->commands[i];
+        for (long ty = cmd->y0 / SOFTRENDER_TILE; ty <= (cmd->y1 - 1) / SOFTRENDER_TILE; ty++) {
+            for (long tx = cmd->x0 / SOFTRENDER_TILE; tx <= (cmd->x1 - 1) / SOFTRENDER_TILE; tx++) {
+                sr->bin_items[sr->bin_fill[ty * sr->tiles_x + tx]++] = i;
+            }
+        }
+    }
+    return true;
+}
+
+// Render a scene into the framebuffer (sized by softrender_resize first).
+// Sprites are composited in order, then the particles, then the HUD.
+bool
+softrender_draw(struct softrender* sr, const struct render_scene* scene)
+{
+    assert(sr != NULL);
+    assert(scene != NULL);
+    assert(sr->pixels != NULL);
+
+    long particles = scene->particles != NULL ? scene->particles->count : 0;
+    long hud_quads = scene->hud_size / (SOFTRENDER_HUD_FLOATS_PER_QUAD * sizeof(float));
+
+    struct softrender_command* commands = softrender_grow(sr->commands, &sr->command_capacity,
+        scene->count + particles + hud_quads, sizeof(*commands));
+    if (commands == NULL) return false;
+    sr->commands = commands;
+    float* instances = softrender_grow(sr->instances, &sr->instance_capacity,
+        particles, PARTICLE_FLOATS_PER_INSTANCE * sizeof(float));
+    if (instances == NULL) return false;
+    sr->instances = instances;
+
+    sr->command_count = 0;
+    for (long i = 0; i < scene->count; i++) {
+        const struct render_sprite* sprite = &scene->sprites[i];
+        softrender_push(sr, sprite->texture, sprite->mode, sprite->alpha, sprite->uv,
+            sprite->x, sprite->y, sprite->r, sprite->sx, sprite->sy);
+    }
+
+    if (particles > 0) {
+        particles = particle_instances(scene->particles, sr->instances, particles);
+        for (long i = 0; i < particles; i++) {
+            const float* inst = &sr->instances[i * PARTICLE_FLOATS_PER_INSTANCE];
+            softrender_push(sr, RENDER_TEXTURE_WHITE, RENDER_MODE_BLEND, inst[3], SOFTRENDER_UV_IDENTITY,
+                inst[0] - scene->camera, inst[1], 0.0f, inst[2], inst[2]);
+        }
+    }
+
+    // every HUD quad is an axis-aligned rectangle
+    for (long q = 0; q < hud_quads; q++) {
+        const float* v = &scene->hud[q * SOFTRENDER_HUD_FLOATS_PER_QUAD];
+        float min_x = v[0], max_x = v[0], min_y = v[1], max_y = v[1];
+        for (long i = 2; i < SOFTRENDER_HUD_FLOATS_PER_QUAD; i += 2) {
+            min_x = fminf(min_x, v[i]);
+            max_x = fmaxf(max_x, v[i]);
+            min_y = fminf(min_y, v[i + 1]);
+            max_y = fmaxf(max_y, v[i + 1]);
+        }
+        softrender_push(sr, RENDER_TEXTURE_WHITE, RENDER_MODE_OPAQUE, 1.0f, SOFTRENDER_UV_IDENTITY,
+            (min_x + max_x) / 2.0f, (min_y + max_y) / 2.0f, 0.0f, max_x - min_x, max_y - min_y);
+    }
+
+    if (!softrender_bin(sr)) return false;
+
+    // wake the workers, take a share of the tiles, then wait for the rest
+    if (sr->threads > 1) {
+        pthread_mutex_lock(&sr->lock);
+        sr->generation++;
+        sr->pending = sr->threads - 1;
+        pthread_cond_broadcast(&sr->start);
+        pthread_mutex_unlock(&sr->lock);
+    }
+
+    softrender_run(sr, &sr->workers[0]);
+
+    if (sr->threads > 1) {
+        pthread_mutex_lock(&sr->lock);
+        while (sr->pending > 0) {
+            pthread_cond_wait(&sr->done, &sr->lock);
+        }
+        pthread_mutex_unlock(&sr->lock);
+    }
+
+    return true;
+}
+
+const unsigned char*
+softrender_pixels(const struct softrender* sr)
+{
+    assert(sr != NULL);
+    return sr->pixels;
+}
@@ -0,0 +1,42 @@
+#ifndef FLAPPY_SOFTRENDER_H_INCLUDED
+#define FLAPPY_SOFTRENDER_H_INCLUDED
+
+#include <stdbool.h>
+
+#include "render.h"
+
+// Software backend for render scenes (see render.h): rasterizes sprites,
+// particles, and HUD quads into an RGBA8 framebuffer in memory, with no GL
+// context and no GPU. Meant for headless observation, thumbnail, and video
+// rendering at small sizes.
+//
+// The screen is cut into SOFTRENDER_TILE square tiles. Every draw is first
+// binned into the tiles it touches (in painter's order), then the tiles are
+// shaded in parallel, each one in a packed RGBA8 buffer that stays in cache
+// until it is stored. Sampling matches the GL path: bilinear filtering with
+// repeating texcoords, pixel centres at half-integers, and blending with
+// SRC_ALPHA, ONE_MINUS_SRC_ALPHA in 8 bits after every draw. Edge rules and
+// subtexel precision are not bit-exact with any particular GPU, so compare
+// the two with a small tolerance rather than exactly.
+//
+// Storage grows to the largest frame seen and is then reused, so steady
+// state draws never allocate.
+
+enum {
+    SOFTRENDER_TILE = 64,
+    SOFTRENDER_MAX_THREADS = 64,
+};
+
+struct softrender;
+
+struct softrender* softrender_create(long threads);
+void softrender_destroy(struct softrender* sr);
+
+bool softrender_texture(struct softrender* sr, int texture, int format, long width, long height, const unsigned char* pixels);
+bool softrender_resize(struct softrender* sr, long width, long height);
+bool softrender_draw(struct softrender* sr, const struct render_scene* scene);
+
+// RGBA8, bottom row first (the same layout glReadPixels returns)
+const unsigned char* softrender_pixels(const struct softrender* sr);
+
+#endif
@@ -0,0 +1,487 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stats.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+enum {
+    STATS_VERSION = 1,
+    STATS_PATH_SIZE = 1024,
+
+    // runs waiting for the writer thread (stats_record drops beyond this)
+    STATS_QUEUE_CAPACITY = 8192,
+
+    // wake the writer early once this many runs are waiting
+    STATS_BATCH_SIZE = 1024,
+
+    // fold the log into the snapshot (and archive it) past this size
+    STATS_COMPACT_BYTES = 4 * 1024 * 1024,
+};
+
+// longest a finished run waits before it is written and synced
+static const double STATS_FLUSH_INTERVAL = 0.5;
+
+static const char STATS_LOG_MAGIC[4] = { 'F', 'L', 'P', 'L' };
+static const char STATS_SNAPSHOT_MAGIC[4] = { 'F', 'L', 'P', 'S' };
+
+struct stats_log_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t generation;
+};
+
+struct stats_frame {
+    uint32_t length;
+    uint32_t checksum;
+    struct stats_run run;
+};
+
+struct stats_snapshot {
+    char magic[4];
+    uint32_t version;
+    uint64_t generation;  // logs older than this are already folded in
+    uint32_t checksum;    // of summary
+    uint32_t reserved;
+    struct stats_summary summary;
+};
+
+struct stats {
+    char path[STATS_PATH_SIZE];
+    char log_path[STATS_PATH_SIZE];
+
+    // owned by the writer thread (and open / close)
+    int log;
+    long log_size;
+    uint64_t generation;
+    struct stats_frame batch[STATS_QUEUE_CAPACITY];
+
+    // runs recorded but not yet written
+    pthread_mutex_t queue_lock;
+    pthread_cond_t queue_ready;
+    long queue_count;
+    struct stats_run queue[STATS_QUEUE_CAPACITY];
+    bool stopping;
+
+    // everything written so far
+    pthread_mutex_t summary_lock;
+    struct stats_summary summary;
+
+    pthread_t writer;
+};
+
+// CRC-32 (IEEE 802.3), bitwise: frames are tiny and written off the hot path
+static uint32_t
+stats_crc32(const void* data, size_t size)
+{
+    const unsigned char* bytes = data;
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static void
+stats_apply(struct stats_summary* summary, const struct stats_run* run)
+{
+    summary->runs++;
+    if (summary->runs == 1 || run->score > summary->best.score) {
+        summary->best = *run;
+    }
+
+    long bucket = run->score;
+    if (bucket < 0) bucket = 0;
+    if (bucket >= STATS_HISTOGRAM_BUCKETS) bucket = STATS_HISTOGRAM_BUCKETS - 1;
+    summary->histogram[bucket]++;
+}
+
+static bool
+stats_write_all(int fd, const void* data, size_t size)
+{
+    const unsigned char* bytes = data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+// Sync the directory holding a file, so that a rename into it survives a
+// crash too (the new name is directory data, not file data).
+static bool
+stats_sync_dir(const char* path)
+{
+#ifndef _WIN32
+    char dir[STATS_PATH_SIZE];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char* slash = strrchr(dir, '/');
+    if (slash == NULL) snprintf(dir, sizeof(dir), ".");
+    else if (slash == dir) slash[1] = '\0';
+    else slash[0] = '\0';
+
+    int fd = open(dir, O_RDONLY);
+    if (fd == -1) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#else
+    // NTFS renames are journaled, and directories can't be opened to sync
+    (void)path;
+    return true;
+#endif
+}
+
+// Write a whole file next to its final path, sync it, then rename it into
+// place so readers only ever see the old or the new version. The directory
+// is synced last so that the rename itself is durable.
+static bool
+stats_replace_file(const char* path, const void* data, size_t size)
+{
+    char tmp_path[STATS_PATH_SIZE + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "failed to create stats file: %s\n", tmp_path);
+        return false;
+    }
+
+    bool ok = stats_write_all(fd, data, size) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "failed to write stats file: %s\n", path);
+        remove(tmp_path);
+        return false;
+    }
+    // the new file is in place either way, so carry on with it
+    if (!stats_sync_dir(path)) {
+        fprintf(stderr, "failed to sync stats directory: %s\n", path);
+    }
+
+    return true;
+}
+
+// Move the log of `generation` aside as PATH.log.GENERATION, keeping its runs
+// for good once the snapshot covers it.
+static bool
+stats_archive_log(struct stats* stats, uint64_t generation)
+{
+    char archive_path[STATS_PATH_SIZE + 24];
+    snprintf(archive_path, sizeof(archive_path), "%s.%llu",
+        stats->log_path, (unsigned long long)generation);
+
+    if (rename(stats->log_path, archive_path) != 0) {
+        fprintf(stderr, "failed to archive stats log: %s\n", archive_path);
+        return false;
+    }
+    if (!stats_sync_dir(archive_path)) {
+        fprintf(stderr, "failed to sync stats directory: %s\n", archive_path);
+    }
+
+    return true;
+}
+
+static bool
+stats_load_snapshot(struct stats* stats)
+{
+    struct stats_snapshot snapshot;
+
+    int fd = open(stats->path, O_RDONLY | O_BINARY);
+    if (fd == -1) return false;
+
+    ssize_t size = read(fd, &snapshot, sizeof(snapshot));
+    close(fd);
+
+    if (size != sizeof(snapshot) ||
+        memcmp(snapshot.magic, STATS_SNAPSHOT_MAGIC, sizeof(STATS_SNAPSHOT_MAGIC)) != 0 ||
+        snapshot.version != STATS_VERSION ||
+        snapshot.checksum != stats_crc32(&snapshot.summary, sizeof(snapshot.summary))) {
+        fprintf(stderr, "ignoring invalid stats snapshot: %s\n", stats->path);
+        return false;
+    }
+
+    stats->generation = snapshot.generation;
+    stats->summary = snapshot.summary;
+    return true;
+}
+
+// Start an empty log for the current generation.
+static bool
+stats_create_log(struct stats* stats)
+{
+    struct stats_log_header header = { { 0 }, STATS_VERSION, stats->generation };
+    memcpy(header.magic, STATS_LOG_MAGIC, sizeof(STATS_LOG_MAGIC));
+
+    if (stats->log != -1) close(stats->log);
+    stats->log = -1;
+
+    if (!stats_replace_file(stats->log_path, &header, sizeof(header))) return false;
+
+    stats->log = open(stats->log_path, O_WRONLY | O_APPEND | O_BINARY);
+    stats->log_size = sizeof(header);
+    return stats->log != -1;
+}
+
+// Replay the log on top of the snapshot. Stops at the first torn or corrupt
+// frame and cuts the file there so new frames append after valid data.
+static bool
+stats_recover_log(struct stats* stats)
+{
+    int fd = open(stats->log_path, O_RDWR | O_BINARY);
+    if (fd == -1) return stats_create_log(stats);
+
+    struct stats_log_header header;
+    if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, STATS_LOG_MAGIC, sizeof(STATS_LOG_MAGIC)) != 0 ||
+        header.version != STATS_VERSION) {
+        // torn on creation, so it holds no runs
+        close(fd);
+        return stats_create_log(stats);
+    }
+    if (header.generation < stats->generation) {
+        // already folded into the snapshot, but not archived yet
+        close(fd);
+        return stats_archive_log(stats, header.generation) && stats_create_log(stats);
+    }
+
+    // newer than the snapshot (which must have been lost): keep what we have
+    stats->generation = header.generation;
+
+    long good = sizeof(header);
+    struct stats_frame frame;
+    while (read(fd, &frame, sizeof(frame)) == sizeof(frame)) {
+        if (frame.length != sizeof(frame.run)) break;
+        if (frame.checksum != stats_crc32(&frame.run, sizeof(frame.run))) break;
+
+        stats_apply(&stats->summary, &frame.run);
+        good += sizeof(frame);
+    }
+
+    if (lseek(fd, 0, SEEK_END) != good) {
+        fprintf(stderr, "truncating torn stats log: %s\n", stats->log_path);
+        if (ftruncate(fd, good) != 0 || fsync(fd) != 0) {
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+
+    stats->log = open(stats->log_path, O_WRONLY | O_APPEND | O_BINARY);
+    stats->log_size = good;
+    return stats->log != -1;
+}
+
+// Fold everything written so far into a new snapshot, archive the log and
+// start a new one. A crash in between leaves an old-generation log next to
+// the new snapshot, which recovery recognizes and archives.
+static void
+stats_compact(struct stats* stats)
+{
+    struct stats_snapshot snapshot = { { 0 }, STATS_VERSION, stats->generation + 1, 0, 0, { 0 } };
+    memcpy(snapshot.magic, STATS_SNAPSHOT_MAGIC, sizeof(STATS_SNAPSHOT_MAGIC));
+
+    pthread_mutex_lock(&stats->summary_lock);
+    snapshot.summary = stats->summary;
+    pthread_mutex_unlock(&stats->summary_lock);
+
+    snapshot.checksum = stats_crc32(&snapshot.summary, sizeof(snapshot.summary));
+    if (!stats_replace_file(stats->path, &snapshot, sizeof(snapshot))) return;
+
+    stats->generation++;
+    if (stats->log != -1) close(stats->log);
+    stats->log = -1;
+
+    // without the archive, new runs would land in a log the snapshot covers
+    if (stats_archive_log(stats, stats->generation - 1)) {
+        stats_create_log(stats);
+    }
+}
+
+static void
+stats_write_batch(struct stats* stats, long count)
+{
+    for (long i = 0; i < count; i++) {
+        stats->batch[i].length = sizeof(stats->batch[i].run);
+        stats->batch[i].checksum = stats_crc32(&stats->batch[i].run, sizeof(stats->batch[i].run));
+    }
+
+    size_t size = count * sizeof(stats->batch[0]);
+    if (stats->log == -1 || !stats_write_all(stats->log, stats->batch, size) || fsync(stats->log) != 0) {
+        fprintf(stderr, "failed to write stats log: %s\n", stats->log_path);
+        return;
+    }
+    stats->log_size += size;
+
+    // only durable runs become visible to queries
+    pthread_mutex_lock(&stats->summary_lock);
+    for (long i = 0; i < count; i++) {
+        stats_apply(&stats->summary, &stats->batch[i].run);
+    }
+    pthread_mutex_unlock(&stats->summary_lock);
+
+    if (stats->log_size >= STATS_COMPACT_BYTES) {
+        stats_compact(stats);
+    }
+}
+
+static void*
+stats_writer(void* arg)
+{
+    struct stats* stats = arg;
+
+    pthread_mutex_lock(&stats->queue_lock);
+    for (;;) {
+        // wait for a full batch, the flush interval, or shutdown
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        long nsec = deadline.tv_nsec + (long)(STATS_FLUSH_INTERVAL * 1e9);
+        deadline.tv_sec += nsec / 1000000000L;
+        deadline.tv_nsec = nsec % 1000000000L;
+        while (!stats->stopping && stats->queue_count < STATS_BATCH_SIZE) {
+            if (pthread_cond_timedwait(&stats->queue_ready, &stats->queue_lock, &deadline) == ETIMEDOUT) break;
+        }
+
+        // take everything queued so far and write it without the lock held
+        long count = stats->queue_count;
+        for (long i = 0; i < count; i++) {
+            stats->batch[i].run = stats->queue[i];
+        }
+        stats->queue_count = 0;
+        bool stopping = stats->stopping;
+        pthread_mutex_unlock(&stats->queue_lock);
+
+        if (count > 0) {
+            stats_write_batch(stats, count);
+        }
+        if (stopping) break;
+
+        pthread_mutex_lock(&stats->queue_lock);
+    }
+
+    return NULL;
+}
+
+struct stats*
+stats_open(const char* path)
+{
+    assert(path != NULL);
+
+    if (strlen(path) >= STATS_PATH_SIZE - 4) {
+        fprintf(stderr, "stats path too long: %s\n", path);
+        return NULL;
+    }
+
+    struct stats* stats = calloc(1, sizeof(*stats));
+    if (stats == NULL) {
+        fprintf(stderr, "failed to allocate stats\n");
+        return NULL;
+    }
+
+    snprintf(stats->path, sizeof(stats->path), "%s", path);
+    snprintf(stats->log_path, sizeof(stats->log_path), "%s.log", path);
+    stats->log = -1;
+
+    stats_load_snapshot(stats);
+    if (!stats_recover_log(stats)) {
+        fprintf(stderr, "failed to open stats log: %s\n", stats->log_path);
+        free(stats);
+        return NULL;
+    }
+
+    pthread_mutex_init(&stats->queue_lock, NULL);
+    pthread_cond_init(&stats->queue_ready, NULL);
+    pthread_mutex_init(&stats->summary_lock, NULL);
+    if (pthread_create(&stats->writer, NULL, stats_writer, stats) != 0) {
+        fprintf(stderr, "failed to start stats writer\n");
+        close(stats->log);
+        free(stats);
+        return NULL;
+    }
+
+    return stats;
+}
+
+void
+stats_close(struct stats* stats)
+{
+    if (stats == NULL) return;
+
+    pthread_mutex_lock(&stats->queue_lock);
+    stats->stopping = true;
+    pthread_cond_signal(&stats->queue_ready);
+    pthread_mutex_unlock(&stats->queue_lock);
+    pthread_join(stats->writer, NULL);
+
+    // every batch is synced already, the next open replays the log
+    if (stats->log != -1) close(stats->log);
+
+    pthread_mutex_destroy(&stats->queue_lock);
+    pthread_cond_destroy(&stats->queue_ready);
+    pthread_mutex_destroy(&stats->summary_lock);
+    free(stats);
+}
+
+// Queue a finished run. Never touches the disk: if the writer has fallen
+// this far behind, the run is counted as dropped instead of blocking.
+bool
+stats_record(struct stats* stats, const struct stats_run* run)
+{
+    assert(stats != NULL);
+    assert(run != NULL);
+
+    pthread_mutex_lock(&stats->queue_lock);
+    if (stats->queue_count >= STATS_QUEUE_CAPACITY) {
+        pthread_mutex_unlock(&stats->queue_lock);
+
+        pthread_mutex_lock(&stats->summary_lock);
+        stats->summary.dropped++;
+        pthread_mutex_unlock(&stats->summary_lock);
+        return false;
+    }
+
+    stats->queue[stats->queue_count++] = *run;
+    if (stats->queue_count == STATS_BATCH_SIZE) {
+        pthread_cond_signal(&stats->queue_ready);
+    }
+    pthread_mutex_unlock(&stats->queue_lock);
+    return true;
+}
+
+void
+stats_summary(struct stats* stats, struct stats_summary* summary)
+{
+    assert(stats != NULL);
+    assert(summary != NULL);
+
+    pthread_mutex_lock(&stats->summary_lock);
+    *summary = stats->summary;
+    pthread_mutex_unlock(&stats->summary_lock);
+}
@@ -0,0 +1,48 @@
+#ifndef FLAPPY_STATS_H_INCLUDED
+#define FLAPPY_STATS_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Crash-safe run history. Every finished run is kept as a record (struct
+// stats_run) in a log of checksummed frames (PATH.log), appended by a
+// background thread that batches writes and fsyncs once per batch. Once the
+// log grows past a few MB, its aggregates are folded into a snapshot (PATH)
+// and the log is archived as PATH.log.GENERATION, so queries never have to
+// scan the history while the records themselves stay on disk: the archives
+// in order, then PATH.log, are the whole history. A torn tail left by a
+// crash is truncated on open.
+//
+// Log files start with a 16 byte header ("FLPL", version, generation), then
+// hold 48 byte frames: length and CRC-32 of the record (uint32 each), then
+// the record, all in host byte order.
+
+enum {
+    STATS_HISTOGRAM_BUCKETS = 256,  // one per score, the last one is "and above"
+};
+
+struct stats_run {
+    uint64_t seed;
+    int64_t score;
+    double duration;
+    uint64_t ticks;
+    uint32_t cause;  // enum world_death
+    uint32_t reserved;
+};
+
+struct stats_summary {
+    uint64_t runs;
+    uint64_t dropped;
+    struct stats_run best;
+    uint64_t histogram[STATS_HISTOGRAM_BUCKETS];
+};
+
+struct stats;
+
+struct stats* stats_open(const char* path);
+void stats_close(struct stats* stats);
+
+bool stats_record(struct stats* stats, const struct stats_run* run);
+void stats_summary(struct stats* stats, struct stats_summary* summary);
+
+#endif
@@ -0,0 +1,415 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "entity.h"
+#include "timeline.h"
+#include "world.h"
+
+// scalar world state as packed into a frame (zeroed first, so that padding
+// never differs between two frames)
+struct timeline_header {
+    long ticks;
+    long score;
+    long next_pipe;
+    long count;
+    double time;
+    float camera;
+    unsigned int seed;
+    int death;
+    unsigned char running;
+    unsigned char dead;
+};
+
+typedef char timeline_header_fits[sizeof(struct timeline_header) <= TIMELINE_HEADER_SIZE ? 1 : -1];
+
+// every component array of the entity store, in frame order
+static const struct {
+    size_t offset;
+    size_t size;
+} TIMELINE_COMPONENTS[] = {
+    { offsetof(struct entity_store, pos_x), sizeof(float) },
+    { offsetof(struct entity_store, pos_y), sizeof(float) },
+    { offsetof(struct entity_store, vel_x), sizeof(float) },
+    { offsetof(struct entity_store, vel_y), sizeof(float) },
+    { offsetof(struct entity_store, gravity), sizeof(float) },
+    { offsetof(struct entity_store, anchor_y), sizeof(float) },
+    { offsetof(struct entity_store, spring), sizeof(float) },
+    { offsetof(struct entity_store, collider_w), sizeof(float) },
+    { offsetof(struct entity_store, collider_h), sizeof(float) },
+    { offsetof(struct entity_store, solid), sizeof(unsigned char) },
+    { offsetof(struct entity_store, sprite), sizeof(unsigned char) },
+    { offsetof(struct entity_store, size_x), sizeof(float) },
+    { offsetof(struct entity_store, size_y), sizeof(float) },
+    { offsetof(struct entity_store, spin), sizeof(float) },
+    { offsetof(struct entity_store, layer), sizeof(float) },
+};
+
+enum {
+    TIMELINE_COMPONENT_COUNT = sizeof(TIMELINE_COMPONENTS) / sizeof(TIMELINE_COMPONENTS[0]),
+};
+
+static long
+timeline_pack(const struct world* world, unsigned char* frame)
+{
+    const struct entity_store* entities = &world->entities;
+
+    struct timeline_header header;
+    memset(&header, 0, sizeof(header));
+    header.ticks = world->ticks;
+    header.score = world->score;
+    header.next_pipe = world->next_pipe;
+    header.count = entities->count;
+    header.time = world->time;
+    header.camera = world->camera;
+    header.seed = world->seed;
+    header.death = world->death;
+    header.running = world->running;
+    header.dead = world->dead;
+    memcpy(frame, &header, sizeof(header));
+
+    long size = sizeof(header);
+    for (long c = 0; c < TIMELINE_COMPONENT_COUNT; c++) {
+        long bytes = entities->count * TIMELINE_COMPONENTS[c].size;
+        memcpy(frame + size, (const unsigned char*)entities + TIMELINE_COMPONENTS[c].offset, bytes);
+        size += bytes;
+    }
+    return size;
+}
+
+static bool
+timeline_unpack(const unsigned char* frame, long size, struct world* world)
+{
+    struct entity_store* entities = &world->entities;
+
+    struct timeline_header header;
+    if (size < (long)sizeof(header)) return false;
+    memcpy(&header, frame, sizeof(header));
+    if (header.count < 0 || header.count > ENTITY_CAPACITY) return false;
+    if (size != (long)sizeof(header) + header.count * TIMELINE_ENTITY_SIZE) return false;
+
+    world->ticks = header.ticks;
+    world->score = header.score;
+    world->next_pipe = header.next_pipe;
+    world->time = header.time;
+    world->camera = header.camera;
+    world->seed = header.seed;
+    world->death = header.death;
+    world->running = header.running;
+    world->dead = header.dead;
+    entities->count = header.count;
+
+    long offset = sizeof(header);
+    for (long c = 0; c < TIMELINE_COMPONENT_COUNT; c++) {
+        long bytes = header.count * TIMELINE_COMPONENTS[c].size;
+        memcpy((unsigned char*)entities + TIMELINE_COMPONENTS[c].offset, frame + offset, bytes);
+        offset += bytes;
+    }
+    return true;
+}
+
+// Encoded frames are a sequence of (zero run, literal run, literal bytes)
+// with both run lengths as LEB128 varints. Bytes are XORed with the base
+// frame (or stored as is for keyframes). With `out` NULL only the encoded
+// size is computed.
+
+static long
+timeline_put_varint(unsigned char* out, long at, unsigned long value)
+{
+    while (value >= 0x80) {
+        if (out != NULL) out[at] = (value & 0x7f) | 0x80;
+        at++;
+        value >>= 7;
+    }
+    if (out != NULL) out[at] = value;
+    return at + 1;
+}
+
+static bool
+timeline_get_varint(const unsigned char* in, long size, long* at, long* value)
+{
+    unsigned long result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*at >= size) return false;
+        unsigned char byte = in[(*at)++];
+        result |= (unsigned long)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static long
+timeline_encode(const unsigned char* frame, const unsigned char* base, long size, unsigned char* out)
+{
+    #define TIMELINE_DIFF(i) (base != NULL ? frame[i] ^ base[i] : frame[i])
+
+    long at = 0;
+    long i = 0;
+    while (i < size) {
+        long start = i;
+        while (start < size && TIMELINE_DIFF(start) == 0) start++;
+
+        // literals run until two unchanged bytes in a row
+        long end = start;
+        while (end < size) {
+            if (TIMELINE_DIFF(end) == 0 && (end + 1 >= size || TIMELINE_DIFF(end + 1) == 0)) break;
+            end++;
+        }
+
+        at = timeline_put_varint(out, at, start - i);
+        at = timeline_put_varint(out, at, end - start);
+        for (long k = start; k < end; k++) {
+            if (out != NULL) out[at] = TIMELINE_DIFF(k);
+            at++;
+        }
+        i = end;
+    }
+    return at;
+
+    #undef TIMELINE_DIFF
+}
+
+// Apply an encoded frame: onto the base already in `frame` for deltas, onto
+// nothing for keyframes. Returns the frame size (-1 if it is malformed).
+static long
+timeline_decode(const unsigned char* in, long in_size, unsigned char* frame, long capacity, bool keyframe)
+{
+    long at = 0;
+    long i = 0;
+    while (at < in_size) {
+        long zeros = 0;
+        long literal = 0;
+        if (!timeline_get_varint(in, in_size, &at, &zeros)) return -1;
+        if (!timeline_get_varint(in, in_size, &at, &literal)) return -1;
+        if (i + zeros + literal > capacity || at + literal > in_size) return -1;
+
+        if (keyframe) memset(frame + i, 0, zeros);
+        i += zeros;
+        for (long k = 0; k < literal; k++, i++, at++) {
+            frame[i] = keyframe ? in[at] : frame[i] ^ in[at];
+        }
+    }
+    return i;
+}
+
+struct timeline*
+timeline_create(void)
+{
+    struct timeline* timeline = calloc(1, sizeof(*timeline));
+    if (timeline == NULL) {
+        fprintf(stderr, "failed to allocate timeline\n");
+        return NULL;
+    }
+
+    long entity_size = 0;
+    for (long c = 0; c < TIMELINE_COMPONENT_COUNT; c++) {
+        entity_size += TIMELINE_COMPONENTS[c].size;
+    }
+    assert(entity_size == TIMELINE_ENTITY_SIZE);
+    (void)entity_size;
+
+    timeline->frame = timeline->frames[0];
+    timeline->scratch = timeline->frames[1];
+    timeline_clear(timeline);
+    return timeline;
+}
+
+void
+timeline_destroy(struct timeline* timeline)
+{
+    free(timeline);
+}
+
+void
+timeline_clear(struct timeline* timeline)
+{
+    assert(timeline != NULL);
+
+    timeline->first = 0;
+    timeline->count = 0;
+    timeline->frame_size = 0;
+    timeline->since_keyframe = 0;
+}
+
+static struct timeline_entry*
+timeline_at(struct timeline* timeline, long index)
+{
+    return &timeline->entries[(timeline->first + index) % TIMELINE_ENTRIES];
+}
+
+// Drop the oldest keyframe and every delta that depends on it.
+static void
+timeline_drop_oldest(struct timeline* timeline)
+{
+    do {
+        timeline->first = (timeline->first + 1) % TIMELINE_ENTRIES;
+        timeline->count--;
+    } while (timeline->count > 0 && !timeline_at(timeline, 0)->keyframe);
+}
+
+// Find room for `size` contiguous bytes right after the newest entry,
+// wrapping to the start of the ring and dropping the oldest entries as
+// needed. The oldest entries always sit right after the newest in the ring.
+static long
+timeline_reserve(struct timeline* timeline, long size)
+{
+    assert(size <= TIMELINE_BUFFER_SIZE);
+
+    long at = 0;
+    if (timeline->count > 0) {
+        const struct timeline_entry* newest = timeline_at(timeline, timeline->count - 1);
+        at = newest->offset + newest->size;
+    }
+
+    for (;;) {
+        if (timeline->count == 0) {
+            return at + size <= TIMELINE_BUFFER_SIZE ? at : 0;
+        }
+
+        long oldest = timeline_at(timeline, 0)->offset;
+        if (oldest < at) {
+            // free up to the end of the ring (and from its start to oldest)
+            if (at + size <= TIMELINE_BUFFER_SIZE) return at;
+            at = 0;
+        } else {
+            if (at + size <= oldest) return at;
+            timeline_drop_oldest(timeline);
+        }
+    }
+}
+
+// Append a snapshot of `world`. Ticks (any clock of the caller's) must never
+// decrease; they are what timeline_find searches.
+void
+timeline_record(struct timeline* timeline, const struct world* world, unsigned long tick)
+{
+    assert(timeline != NULL);
+    assert(world != NULL);
+
+    long size = timeline_pack(world, timeline->scratch);
+    bool keyframe = timeline->count == 0 || size != timeline->frame_size ||
+        timeline->since_keyframe >= TIMELINE_KEYFRAME_INTERVAL;
+
+    long encoded = 0;
+    long offset = 0;
+    for (;;) {
+        encoded = timeline_encode(timeline->scratch, keyframe ? NULL : timeline->frame, size, NULL);
+        if (timeline->count == TIMELINE_ENTRIES) timeline_drop_oldest(timeline);
+        offset = timeline_reserve(timeline, encoded);
+
+        // making room may have dropped the base of the delta
+        if (keyframe || timeline->count > 0) break;
+        keyframe = true;
+    }
+    timeline_encode(timeline->scratch, keyframe ? NULL : timeline->frame, size, timeline->buffer + offset);
+
+    struct timeline_entry* entry = timeline_at(timeline, timeline->count);
+    entry->offset = offset;
+    entry->size = encoded;
+    entry->tick = tick;
+    entry->keyframe = keyframe;
+    timeline->count++;
+    timeline->since_keyframe = keyframe ? 1 : timeline->since_keyframe + 1;
+
+    // the new frame is the base of the next delta
+    unsigned char* frame = timeline->frame;
+    timeline->frame = timeline->scratch;
+    timeline->scratch = frame;
+    timeline->frame_size = size;
+}
+
+// Index of the newest snapshot at or before `tick` (the oldest one if all
+// are later), -1 when there are none.
+long
+timeline_find(const struct timeline* timeline, double tick)
+{
+    assert(timeline != NULL);
+
+    if (timeline->count == 0) return -1;
+
+    long lo = 0;
+    long hi = timeline->count - 1;
+    while (lo < hi) {
+        long mid = lo + (hi - lo + 1) / 2;
+        const struct timeline_entry* entry = &timeline->entries[(timeline->first + mid) % TIMELINE_ENTRIES];
+        if (entry->tick <= tick) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Rebuild the packed frame of snapshot `index`: its keyframe, then every
+// delta up to it.
+static long
+timeline_rebuild(struct timeline* timeline, long index, unsigned char* frame)
+{
+    long key = index;
+    while (key > 0 && !timeline_at(timeline, key)->keyframe) key--;
+
+    long size = -1;
+    for (long i = key; i <= index; i++) {
+        const struct timeline_entry* entry = timeline_at(timeline, i);
+        size = timeline_decode(timeline->buffer + entry->offset, entry->size,
+            frame, TIMELINE_FRAME_SIZE, entry->keyframe);
+        if (size < 0) return -1;
+    }
+    return size;
+}
+
+// Put `world` back into the state of snapshot `index` (0 is the oldest). The
+// world keeps its course.
+bool
+timeline_restore(struct timeline* timeline, long index, struct world* world)
+{
+    assert(timeline != NULL);
+    assert(world != NULL);
+
+    if (index < 0 || index >= timeline->count) return false;
+
+    long size = timeline_rebuild(timeline, index, timeline->scratch);
+    if (size < 0) return false;
+    return timeline_unpack(timeline->scratch, size, world);
+}
+
+// Forget every snapshot after the first `count`, so that recording carries
+// on from there (after resuming from a restored snapshot).
+void
+timeline_truncate(struct timeline* timeline, long count)
+{
+    assert(timeline != NULL);
+
+    if (count >= timeline->count) return;
+    if (count <= 0) {
+        timeline_clear(timeline);
+        return;
+    }
+
+    timeline->count = count;
+    timeline->frame_size = timeline_rebuild(timeline, count - 1, timeline->frame);
+    if (timeline->frame_size < 0) {
+        timeline_clear(timeline);
+        return;
+    }
+
+    timeline->since_keyframe = 1;
+    for (long i = count - 1; i > 0 && !timeline_at(timeline, i)->keyframe; i--) {
+        timeline->since_keyframe++;
+    }
+}
+
+const struct timeline_entry*
+timeline_entry(const struct timeline* timeline, long index)
+{
+    assert(timeline != NULL);
+    assert(index >= 0 && index < timeline->count);
+    return &timeline->entries[(timeline->first + index) % TIMELINE_ENTRIES];
+}
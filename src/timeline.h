@@ -0,0 +1,69 @@
+#ifndef FLAPPY_TIMELINE_H_INCLUDED
+#define FLAPPY_TIMELINE_H_INCLUDED
+
+#include <stdbool.h>
+
+#include "entity.h"
+#include "world.h"
+
+// Bounded history of world snapshots for rewinding a run (and for looking at
+// the ticks that led up to a death). Every snapshot packs the world into a
+// flat frame (scalar state, then the live prefix of each component array)
+// and stores it XORed with the previous frame, with runs of zero bytes
+// squeezed out. Nothing that stayed the same costs more than a byte or two,
+// so static pipes are effectively free. A keyframe (stored against zero) is
+// written every TIMELINE_KEYFRAME_INTERVAL snapshots and whenever the
+// entity count changes.
+//
+// Memory is fixed at creation: sizeof(struct timeline) is about 860 KB
+// (a 640 KB byte ring, 7200 entries, and two frame buffers). A typical run
+// takes about 40 bytes per tick (5 KB per second at 120 Hz), so the entry
+// limit of 60 s at 120 Hz is what bounds the history. Oldest snapshots are
+// dropped a keyframe group at a time when either limit is reached.
+
+enum {
+    TIMELINE_ENTRIES = 60 * 120,
+    TIMELINE_BUFFER_SIZE = 640 * 1024,
+    TIMELINE_KEYFRAME_INTERVAL = 120,
+
+    // largest packed world: scalar state plus every component of every entity
+    TIMELINE_HEADER_SIZE = 64,
+    TIMELINE_ENTITY_SIZE = 13 * sizeof(float) + 2,
+    TIMELINE_FRAME_SIZE = TIMELINE_HEADER_SIZE + ENTITY_CAPACITY * TIMELINE_ENTITY_SIZE,
+};
+
+struct timeline_entry {
+    unsigned int offset;    // into the byte ring
+    unsigned int size;      // encoded bytes
+    unsigned int tick;      // caller's clock, never decreasing
+    unsigned int keyframe;  // stored against zero rather than the previous frame
+};
+
+struct timeline {
+    // entries ring (oldest first)
+    long first;
+    long count;
+    struct timeline_entry entries[TIMELINE_ENTRIES];
+
+    // packed frame of the newest snapshot, and scratch for the next one
+    long frame_size;
+    unsigned char* frame;
+    unsigned char* scratch;
+    unsigned char frames[2][TIMELINE_FRAME_SIZE];
+
+    long since_keyframe;
+    unsigned char buffer[TIMELINE_BUFFER_SIZE];
+};
+
+struct timeline* timeline_create(void);
+void timeline_destroy(struct timeline* timeline);
+void timeline_clear(struct timeline* timeline);
+
+void timeline_record(struct timeline* timeline, const struct world* world, unsigned long tick);
+long timeline_find(const struct timeline* timeline, double tick);
+bool timeline_restore(struct timeline* timeline, long index, struct world* world);
+void timeline_truncate(struct timeline* timeline, long count);
+
+const struct timeline_entry* timeline_entry(const struct timeline* timeline, long index);
+
+#endif
@@ -0,0 +1,444 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "entity.h"
+#include "trajectory.h"
+#include "world.h"
+
+static const struct trajectory_column TRAJECTORY_COLUMNS[TRAJECTORY_COLUMN_COUNT] = {
+    [TRAJECTORY_RUN]   = { "run",   TRAJECTORY_TYPE_U32, 4 },
+    [TRAJECTORY_TICK]  = { "tick",  TRAJECTORY_TYPE_U32, 4 },
+    [TRAJECTORY_X]     = { "x",     TRAJECTORY_TYPE_F32, 4 },
+    [TRAJECTORY_Y]     = { "y",     TRAJECTORY_TYPE_F32, 4 },
+    [TRAJECTORY_VEL_X] = { "vel_x", TRAJECTORY_TYPE_F32, 4 },
+    [TRAJECTORY_VEL_Y] = { "vel_y", TRAJECTORY_TYPE_F32, 4 },
+    [TRAJECTORY_GAP_X] = { "gap_x", TRAJECTORY_TYPE_F32, 4 },
+    [TRAJECTORY_GAP_Y] = { "gap_y", TRAJECTORY_TYPE_F32, 4 },
+    [TRAJECTORY_FLAP]  = { "flap",  TRAJECTORY_TYPE_U8,  1 },
+    [TRAJECTORY_SCORE] = { "score", TRAJECTORY_TYPE_U32, 4 },
+    [TRAJECTORY_DEAD]  = { "dead",  TRAJECTORY_TYPE_U8,  1 },
+};
+
+enum {
+    TRAJECTORY_BLOB_MAX = TRAJECTORY_CHUNK_ROWS * 4,  // widest column
+};
+
+// One chunk of rows, column by column.
+struct trajectory_buffer {
+    long rows;
+    unsigned char* columns[TRAJECTORY_COLUMN_COUNT];
+};
+
+struct trajectory {
+    FILE* file;
+    const char* path;
+    long stride;
+
+    // the caller fills `buffers[filling]`; the writer owns the other one
+    // while `pending` is set
+    struct trajectory_buffer buffers[2];
+    long filling;
+    long rows;
+
+    pthread_t writer;
+    bool started;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool pending;
+    bool stop;
+
+    // writer thread only (until it has been joined)
+    unsigned char* scratch;   // delta rows of one column
+    unsigned char* packed;    // encoded blob
+    uint64_t offset;
+    struct trajectory_chunk* chunks;
+    struct trajectory_blob* blobs;
+    long chunk_count;
+    long chunk_capacity;
+    long raw_bytes;
+    bool failed;
+
+    long stalls;
+};
+
+// Runs of zero bytes become (zeros, literals) varint pairs followed by the
+// literal bytes, exactly like timeline frames (see timeline.c).
+static long
+trajectory_put_varint(unsigned char* out, long at, unsigned long value)
+{
+    while (value >= 0x80) {
+        out[at++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    out[at++] = value;
+    return at;
+}
+
+// Encode `size` bytes into `out`, giving up (returning -1) as soon as the
+// result would not be smaller than the input.
+static long
+trajectory_squeeze(const unsigned char* in, long size, unsigned char* out)
+{
+    long at = 0;
+    long i = 0;
+    while (i < size) {
+        long start = i;
+        while (start < size && in[start] == 0) start++;
+
+        // literals end at the next run of at least two zeros
+        long end = start;
+        while (end < size && !(in[end] == 0 && (end + 1 == size || in[end + 1] == 0))) end++;
+
+        // two varints take at most 10 bytes each
+        if (at + 20 + (end - start) >= size) return -1;
+        at = trajectory_put_varint(out, at, start - i);
+        at = trajectory_put_varint(out, at, end - start);
+        memcpy(out + at, in + start, end - start);
+        at += end - start;
+        i = end;
+    }
+    return at;
+}
+
+// Replace every value by its difference from a straight line through the
+// two values `stride` and `2 * stride` rows before it (the same run, one and
+// two ticks earlier), wrapping around like unsigned integers of the column's
+// width. Positions and ticks advance steadily and velocities change by a
+// fixed amount per tick, so most of the differences are tiny or zero. Then
+// split them into byte planes so that the high bytes line up as zero runs.
+static void
+trajectory_delta(const unsigned char* column, long rows, long width, long stride, unsigned char* out)
+{
+    for (long r = 0; r < rows; r++) {
+        uint32_t value = 0;
+        uint32_t prediction = 0;
+        if (width == 4) {
+            const uint32_t* values = (const uint32_t*)column;
+            value = values[r];
+            if (r >= 2 * stride) prediction = 2 * values[r - stride] - values[r - 2 * stride];
+            else if (r >= stride) prediction = values[r - stride];
+        } else {
+            value = column[r];
+            if (r >= 2 * stride) prediction = 2 * column[r - stride] - column[r - 2 * stride];
+            else if (r >= stride) prediction = column[r - stride];
+        }
+
+        uint32_t delta = value - prediction;
+        for (long b = 0; b < width; b++) {
+            out[b * rows + r] = delta >> (8 * b);
+        }
+    }
+}
+
+static bool
+trajectory_write(struct trajectory* trajectory, const void* data, long size)
+{
+    static const unsigned char zeros[TRAJECTORY_ALIGN] = { 0 };
+
+    long padding = (TRAJECTORY_ALIGN - size % TRAJECTORY_ALIGN) % TRAJECTORY_ALIGN;
+    if (fwrite(data, 1, size, trajectory->file) != (size_t)size ||
+        fwrite(zeros, 1, padding, trajectory->file) != (size_t)padding) {
+        return false;
+    }
+    trajectory->offset += size + padding;
+    return true;
+}
+
+// Pack and write one chunk (on the writer thread).
+static void
+trajectory_flush(struct trajectory* trajectory, const struct trajectory_buffer* buffer)
+{
+    if (trajectory->failed || buffer->rows == 0) return;
+
+    if (trajectory->chunk_count == trajectory->chunk_capacity) {
+        long capacity = trajectory->chunk_capacity > 0 ? 2 * trajectory->chunk_capacity : 64;
+        struct trajectory_chunk* chunks = realloc(trajectory->chunks, capacity * sizeof(*chunks));
+        if (chunks != NULL) trajectory->chunks = chunks;
+        struct trajectory_blob* blobs = realloc(trajectory->blobs,
+            capacity * TRAJECTORY_COLUMN_COUNT * sizeof(*blobs));
+        if (blobs != NULL) trajectory->blobs = blobs;
+        if (chunks == NULL || blobs == NULL) {
+            fprintf(stderr, "failed to allocate trajectory index: %s\n", trajectory->path);
+            trajectory->failed = true;
+            return;
+        }
+        trajectory->chunk_capacity = capacity;
+    }
+
+    long index = trajectory->chunk_count;
+    struct trajectory_chunk* chunk = &trajectory->chunks[index];
+    chunk->first_row = index > 0 ? trajectory->chunks[index - 1].first_row + trajectory->chunks[index - 1].rows : 0;
+    chunk->rows = buffer->rows;
+    chunk->reserved = 0;
+
+    for (long c = 0; c < TRAJECTORY_COLUMN_COUNT; c++) {
+        long size = buffer->rows * TRAJECTORY_COLUMNS[c].width;
+        trajectory_delta(buffer->columns[c], buffer->rows, TRAJECTORY_COLUMNS[c].width, trajectory->stride,
+            trajectory->scratch);
+        long packed = trajectory_squeeze(trajectory->scratch, size, trajectory->packed);
+
+        struct trajectory_blob* blob = &trajectory->blobs[index * TRAJECTORY_COLUMN_COUNT + c];
+        blob->offset = trajectory->offset;
+        blob->codec = packed >= 0 ? TRAJECTORY_CODEC_PACKED : TRAJECTORY_CODEC_RAW;
+        blob->size = packed >= 0 ? packed : size;
+
+        const unsigned char* data = packed >= 0 ? trajectory->packed : buffer->columns[c];
+        if (!trajectory_write(trajectory, data, blob->size)) {
+            fprintf(stderr, "failed to write trajectory: %s\n", trajectory->path);
+            trajectory->failed = true;
+            return;
+        }
+        trajectory->raw_bytes += size;
+    }
+    trajectory->chunk_count++;
+}
+
+static void*
+trajectory_writer_run(void* arg)
+{
+    struct trajectory* trajectory = arg;
+
+    pthread_mutex_lock(&trajectory->lock);
+    for (;;) {
+        while (!trajectory->pending && !trajectory->stop) {
+            pthread_cond_wait(&trajectory->changed, &trajectory->lock);
+        }
+        if (!trajectory->pending) break;
+
+        const struct trajectory_buffer* buffer = &trajectory->buffers[1 - trajectory->filling];
+        pthread_mutex_unlock(&trajectory->lock);
+
+        trajectory_flush(trajectory, buffer);
+
+        pthread_mutex_lock(&trajectory->lock);
+        trajectory->pending = false;
+        pthread_cond_broadcast(&trajectory->changed);
+    }
+    pthread_mutex_unlock(&trajectory->lock);
+
+    return NULL;
+}
+
+// Hand the filled buffer to the writer and start filling the other one,
+// waiting first if the writer is still busy with it.
+static void
+trajectory_swap(struct trajectory* trajectory)
+{
+    pthread_mutex_lock(&trajectory->lock);
+    if (trajectory->pending) trajectory->stalls++;
+    while (trajectory->pending) {
+        pthread_cond_wait(&trajectory->changed, &trajectory->lock);
+    }
+
+    trajectory->filling = 1 - trajectory->filling;
+    trajectory->buffers[trajectory->filling].rows = 0;
+    trajectory->pending = true;
+    pthread_cond_broadcast(&trajectory->changed);
+    pthread_mutex_unlock(&trajectory->lock);
+}
+
+static void
+trajectory_free(struct trajectory* trajectory)
+{
+    for (long i = 0; i < 2; i++) {
+        for (long c = 0; c < TRAJECTORY_COLUMN_COUNT; c++) {
+            free(trajectory->buffers[i].columns[c]);
+        }
+    }
+    free(trajectory->scratch);
+    free(trajectory->packed);
+    free(trajectory->chunks);
+    free(trajectory->blobs);
+    free(trajectory);
+}
+
+struct trajectory*
+trajectory_create(const char* path, long stride)
+{
+    assert(path != NULL);
+    assert(stride >= 1 && stride <= UINT32_MAX);
+
+    struct trajectory* trajectory = calloc(1, sizeof(*trajectory));
+    if (trajectory == NULL) {
+        fprintf(stderr, "failed to allocate trajectory\n");
+        return NULL;
+    }
+    trajectory->path = path;
+    trajectory->stride = stride;
+
+    bool ok = true;
+    for (long i = 0; i < 2; i++) {
+        for (long c = 0; c < TRAJECTORY_COLUMN_COUNT; c++) {
+            trajectory->buffers[i].columns[c] = malloc(TRAJECTORY_CHUNK_ROWS * TRAJECTORY_COLUMNS[c].width);
+            ok = ok && trajectory->buffers[i].columns[c] != NULL;
+        }
+    }
+    trajectory->scratch = malloc(TRAJECTORY_BLOB_MAX);
+    trajectory->packed = malloc(TRAJECTORY_BLOB_MAX);
+    if (!ok || trajectory->scratch == NULL || trajectory->packed == NULL) {
+        fprintf(stderr, "failed to allocate trajectory buffers\n");
+        trajectory_free(trajectory);
+        return NULL;
+    }
+
+    trajectory->file = fopen(path, "wb");
+    if (trajectory->file == NULL) {
+        fprintf(stderr, "failed to create trajectory: %s\n", path);
+        trajectory_free(trajectory);
+        return NULL;
+    }
+
+    struct trajectory_header header = { 0 };
+    memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version = TRAJECTORY_VERSION;
+    header.column_count = TRAJECTORY_COLUMN_COUNT;
+    header.chunk_rows = TRAJECTORY_CHUNK_ROWS;
+    header.stride = stride;
+    if (!trajectory_write(trajectory, &header, sizeof(header))) {
+        fprintf(stderr, "failed to write trajectory: %s\n", path);
+        fclose(trajectory->file);
+        trajectory_free(trajectory);
+        return NULL;
+    }
+
+    pthread_mutex_init(&trajectory->lock, NULL);
+    pthread_cond_init(&trajectory->changed, NULL);
+    trajectory->started = pthread_create(&trajectory->writer, NULL, trajectory_writer_run, trajectory) == 0;
+    if (!trajectory->started) {
+        fprintf(stderr, "failed to start trajectory thread, writing chunks inline\n");
+    }
+
+    return trajectory;
+}
+
+void
+trajectory_append(struct trajectory* trajectory, const struct trajectory_record* record)
+{
+    assert(trajectory != NULL);
+    assert(record != NULL);
+
+    struct trajectory_buffer* buffer = &trajectory->buffers[trajectory->filling];
+    long r = buffer->rows;
+    ((uint32_t*)buffer->columns[TRAJECTORY_RUN])[r] = record->run;
+    ((uint32_t*)buffer->columns[TRAJECTORY_TICK])[r] = record->tick;
+    ((float*)buffer->columns[TRAJECTORY_X])[r] = record->x;
+    ((float*)buffer->columns[TRAJECTORY_Y])[r] = record->y;
+    ((float*)buffer->columns[TRAJECTORY_VEL_X])[r] = record->vel_x;
+    ((float*)buffer->columns[TRAJECTORY_VEL_Y])[r] = record->vel_y;
+    ((float*)buffer->columns[TRAJECTORY_GAP_X])[r] = record->gap_x;
+    ((float*)buffer->columns[TRAJECTORY_GAP_Y])[r] = record->gap_y;
+    buffer->columns[TRAJECTORY_FLAP][r] = record->flap;
+    ((uint32_t*)buffer->columns[TRAJECTORY_SCORE])[r] = record->score;
+    buffer->columns[TRAJECTORY_DEAD][r] = record->dead;
+    buffer->rows++;
+    trajectory->rows++;
+
+    if (buffer->rows < TRAJECTORY_CHUNK_ROWS) return;
+    if (trajectory->started) {
+        trajectory_swap(trajectory);
+    } else {
+        trajectory_flush(trajectory, buffer);
+        buffer->rows = 0;
+    }
+}
+
+bool
+trajectory_close(struct trajectory* trajectory, struct trajectory_stats* stats)
+{
+    if (trajectory == NULL) return false;
+
+    // the partial chunk goes the same way as full ones
+    if (trajectory->started) {
+        if (trajectory->buffers[trajectory->filling].rows > 0) trajectory_swap(trajectory);
+
+        pthread_mutex_lock(&trajectory->lock);
+        trajectory->stop = true;
+        pthread_cond_broadcast(&trajectory->changed);
+        pthread_mutex_unlock(&trajectory->lock);
+        pthread_join(trajectory->writer, NULL);
+    } else {
+        trajectory_flush(trajectory, &trajectory->buffers[trajectory->filling]);
+    }
+    pthread_cond_destroy(&trajectory->changed);
+    pthread_mutex_destroy(&trajectory->lock);
+
+    struct trajectory_footer footer = { 0 };
+    footer.index_offset = trajectory->offset;
+    footer.row_count = trajectory->rows;
+    footer.chunk_count = trajectory->chunk_count;
+    footer.column_count = TRAJECTORY_COLUMN_COUNT;
+    memcpy(footer.magic, TRAJECTORY_MAGIC, sizeof(footer.magic));
+    footer.version = TRAJECTORY_VERSION;
+
+    bool ok = !trajectory->failed;
+    ok = ok && trajectory_write(trajectory, TRAJECTORY_COLUMNS, sizeof(TRAJECTORY_COLUMNS));
+    for (long i = 0; ok && i < trajectory->chunk_count; i++) {
+        ok = trajectory_write(trajectory, &trajectory->chunks[i], sizeof(trajectory->chunks[i])) &&
+            trajectory_write(trajectory, &trajectory->blobs[i * TRAJECTORY_COLUMN_COUNT],
+                TRAJECTORY_COLUMN_COUNT * sizeof(struct trajectory_blob));
+    }
+    ok = ok && trajectory_write(trajectory, &footer, sizeof(footer));
+    if (fclose(trajectory->file) != 0) ok = false;
+    if (!ok && !trajectory->failed) {
+        fprintf(stderr, "failed to write trajectory: %s\n", trajectory->path);
+    }
+
+    if (stats != NULL) {
+        stats->rows = trajectory->rows;
+        stats->chunks = trajectory->chunk_count;
+        stats->raw_bytes = trajectory->raw_bytes;
+        stats->bytes = trajectory->offset;
+        stats->stalls = trajectory->stalls;
+    }
+
+    trajectory_free(trajectory);
+    return ok;
+}
+
+void
+trajectory_record_world(struct trajectory_record* record, const struct world* world, uint32_t run, bool flap)
+{
+    assert(record != NULL);
+    assert(world != NULL);
+
+    const struct entity_store* entities = &world->entities;
+    float bird_x = entities->pos_x[WORLD_BIRD];
+    float bird_y = entities->pos_y[WORLD_BIRD];
+
+    record->run = run;
+    record->tick = world->ticks;
+    record->x = bird_x;
+    record->y = bird_y;
+    record->vel_x = entities->vel_x[WORLD_BIRD];
+    record->vel_y = entities->vel_y[WORLD_BIRD];
+    record->flap = flap;
+    record->score = world->score;
+    record->dead = world->dead;
+
+    // the next pipe pair not yet cleared (where it is now, for moving pipes)
+    record->gap_x = 0.0f;
+    record->gap_y = 0.0f;
+    for (long i = 1; i + 1 < entities->count; i++) {
+        if (entities->sprite[i] != SPRITE_PIPE_TOP || entities->sprite[i + 1] != SPRITE_PIPE_BOT) continue;
+        if (entities->pos_x[i] + PIPE_WIDTH <= bird_x) continue;
+
+        record->gap_x = entities->pos_x[i] - bird_x;
+        record->gap_y = (entities->pos_y[i] + entities->pos_y[i + 1]) / 2.0f - bird_y;
+        return;
+    }
+
+    // not spawned yet (or past the end of a course)
+    struct course_record obstacle;
+    if (world_obstacle(world, world->score, &obstacle)) {
+        record->gap_x = obstacle.x - bird_x;
+        record->gap_y = obstacle.gap - bird_y;
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef FLAPPY_TRAJECTORY_H_INCLUDED
+#define FLAPPY_TRAJECTORY_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "world.h"
+
+// Columnar trajectory files: one row per simulated tick, for offline
+// analysis of millions of runs (little-endian, read by scripts/trajectory.py).
+//
+//   header   struct trajectory_header
+//   chunks   up to TRAJECTORY_CHUNK_ROWS rows each, stored column by column
+//   index    struct trajectory_column[column_count], then for every chunk
+//            a struct trajectory_chunk and column_count trajectory_blobs
+//   footer   struct trajectory_footer (the last bytes of the file)
+//
+// Every column of a chunk is one blob, 8-byte aligned. TRAJECTORY_CODEC_RAW
+// blobs are the fixed-width values as is, so a reader can map the file and
+// use them in place. TRAJECTORY_CODEC_PACKED blobs hold, for every row, the
+// difference from a straight line through the values `stride` and
+// `2 * stride` rows earlier in the chunk (both as unsigned integers of the
+// column's width, wrapping around), split into byte planes (all first bytes,
+// then all second bytes, ...) and stored with runs of zero bytes squeezed
+// out like timeline frames. A blob is only packed when that makes it
+// smaller. The stride is the number of runs logged side by side: flappy-env
+// appends one row per environment every step.
+//
+// Rows are appended into one of two chunk buffers. A full chunk is handed to
+// a background thread that packs and writes it while the other buffer fills,
+// so the caller only ever waits if the disk falls a whole chunk behind.
+
+enum {
+    TRAJECTORY_VERSION = 1,
+    TRAJECTORY_CHUNK_ROWS = 64 * 1024,
+    TRAJECTORY_ALIGN = 8,
+    TRAJECTORY_NAME_SIZE = 16,
+};
+
+static const char TRAJECTORY_MAGIC[4] = { 'F', 'L', 'P', 'T' };
+
+enum trajectory_column_id {
+    TRAJECTORY_RUN = 0,  // u32, numbered in the order runs start
+    TRAJECTORY_TICK,     // u32, ticks since the run started
+    TRAJECTORY_X,        // f32, bird position
+    TRAJECTORY_Y,
+    TRAJECTORY_VEL_X,    // f32, bird velocity
+    TRAJECTORY_VEL_Y,
+    TRAJECTORY_GAP_X,    // f32, center of the next gap relative to the bird
+    TRAJECTORY_GAP_Y,
+    TRAJECTORY_FLAP,     // u8, flapped at the start of the tick
+    TRAJECTORY_SCORE,    // u32
+    TRAJECTORY_DEAD,     // u8, crashed during the tick
+    TRAJECTORY_COLUMN_COUNT,
+};
+
+enum trajectory_type {
+    TRAJECTORY_TYPE_U8 = 0,
+    TRAJECTORY_TYPE_U32,
+    TRAJECTORY_TYPE_F32,
+};
+
+enum trajectory_codec {
+    TRAJECTORY_CODEC_RAW = 0,
+    TRAJECTORY_CODEC_PACKED,
+};
+
+struct trajectory_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t column_count;
+    uint32_t chunk_rows;
+    uint32_t stride;    // rows between consecutive ticks of a run
+    uint32_t reserved;
+};
+
+struct trajectory_column {
+    char name[TRAJECTORY_NAME_SIZE];
+    uint32_t type;
+    uint32_t width;  // bytes per value
+};
+
+struct trajectory_chunk {
+    uint64_t first_row;
+    uint32_t rows;
+    uint32_t reserved;
+};
+
+struct trajectory_blob {
+    uint64_t offset;
+    uint32_t size;   // bytes in the file
+    uint32_t codec;
+};
+
+struct trajectory_footer {
+    uint64_t index_offset;
+    uint64_t row_count;
+    uint32_t chunk_count;
+    uint32_t column_count;
+    char magic[4];
+    uint32_t version;
+};
+
+struct trajectory_record {
+    uint32_t run;
+    uint32_t tick;
+    float x;
+    float y;
+    float vel_x;
+    float vel_y;
+    float gap_x;
+    float gap_y;
+    uint8_t flap;
+    uint32_t score;
+    uint8_t dead;
+};
+
+struct trajectory_stats {
+    long rows;
+    long chunks;
+    long raw_bytes;   // the same rows with every blob stored raw
+    long bytes;       // file size
+    long stalls;      // appends that had to wait for the writer thread
+};
+
+struct trajectory;
+
+// `stride` is 1 for a single run at a time (see above).
+struct trajectory* trajectory_create(const char* path, long stride);
+void trajectory_append(struct trajectory* trajectory, const struct trajectory_record* record);
+
+// Write the last chunk, the index, and the footer. Returns false if anything
+// failed to be written (the file is then incomplete). Stats may be NULL.
+bool trajectory_close(struct trajectory* trajectory, struct trajectory_stats* stats);
+
+// Fill a record from the world right after it was updated with `flap`.
+void trajectory_record_world(struct trajectory_record* record, const struct world* world, uint32_t run, bool flap);
+
+#endif
@@ -0,0 +1,235 @@
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "course.h"
+#include "entity.h"
+#include "world.h"
+
+#ifndef M_PI
+#define M_PI 3.141592653589793
+#endif
+
+// pipes are spawned this far ahead of the camera and culled this far behind
+// (matches the window that is visible on screen)
+static const float SPAWN_AHEAD = 12.0f;
+static const float CULL_BEHIND = 8.0f;
+
+// where every run starts
+static const float BIRD_START_X = -6.0f;
+
+// integer hash (lowbias32) used to derive obstacles from the run seed
+static unsigned int
+world_hash(unsigned int x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+bool
+world_obstacle(const struct world* world, long i, struct course_record* obstacle)
+{
+    assert(world != NULL);
+    assert(obstacle != NULL);
+
+    if (world->course != NULL) {
+        const struct course_record* record = course_record(world->course, i);
+        if (record == NULL) return false;
+
+        *obstacle = *record;
+        return true;
+    }
+
+    float gap = (float)world_hash(world->seed ^ (i * 0x9e3779b9u)) / (float)UINT_MAX;  // [0.0, 1.0]
+    gap -= 0.5f;  // [-0.5, 0.5]
+
+    obstacle->x = i * PIPE_SPACING;
+    obstacle->gap = gap * 4.0f;  // [-2.0, 2.0]
+    obstacle->gap_size = 2.0f * GAP - PIPE_HEIGHT;
+    obstacle->amplitude = 0.0f;
+    obstacle->frequency = 0.0f;
+    obstacle->flags = 0;
+    return true;
+}
+
+static void
+world_spawn_pipes(struct world* world)
+{
+    struct course_record obstacle;
+    long spawned = 0;
+    while (world_obstacle(world, world->next_pipe, &obstacle)) {
+        if (obstacle.x > world->camera + SPAWN_AHEAD) break;
+
+        // moving pipes oscillate around their anchor (simple harmonic motion)
+        float omega = 2.0f * M_PI * obstacle.frequency;
+        float offset = (obstacle.gap_size + PIPE_HEIGHT) / 2.0f;
+        struct entity_desc pipe = {
+            .pos_x = obstacle.x,
+            .vel_y = obstacle.amplitude * omega,
+            .spring = omega * omega,
+            .collider_w = PIPE_WIDTH,
+            .collider_h = PIPE_HEIGHT,
+            .solid = true,
+            .size_x = PIPE_WIDTH,
+            .size_y = PIPE_HEIGHT,
+            .layer = PIPE_LAYER,
+        };
+
+        pipe.pos_y = pipe.anchor_y = obstacle.gap + offset;
+        pipe.sprite = SPRITE_PIPE_TOP;
+        entity_spawn(&world->entities, &pipe);
+
+        pipe.pos_y = pipe.anchor_y = obstacle.gap - offset;
+        pipe.sprite = SPRITE_PIPE_BOT;
+        entity_spawn(&world->entities, &pipe);
+
+        world->next_pipe++;
+        spawned++;
+    }
+
+    // let go of course records the bird has already passed
+    if (spawned > 0 && world->course != NULL) {
+        course_release(world->course, world->score);
+    }
+}
+
+void
+world_init(struct world* world, struct course* course, unsigned int seed)
+{
+    assert(world != NULL);
+
+    world->course = course;
+    world->seed = seed;
+    world_reset(world);
+}
+
+void
+world_reset(struct world* world)
+{
+    assert(world != NULL);
+
+    // game state
+    world->running = false;
+    world->dead = false;
+    world->death = WORLD_DEATH_NONE;
+    world->score = 0;
+    world->ticks = 0;
+    world->time = 0.0;
+
+    // every run gets fresh obstacles (unless they come from a course)
+    world->seed = world_hash(world->seed + 1);
+
+    // game objects
+    world->camera = -3.0f;
+
+    // course obstacles already behind the cull line are never spawned: look
+    // up the first one past it in the course index (and count the ones the
+    // bird starts beyond as cleared, like world_update would)
+    world->next_pipe = 0;
+    if (world->course != NULL) {
+        world->next_pipe = course_find(world->course, world->camera - CULL_BEHIND);
+        world->score = course_find(world->course, BIRD_START_X - PIPE_WIDTH);
+    }
+    entity_clear(&world->entities);
+
+    struct entity_desc bird = {
+        .pos_x = BIRD_START_X,
+        .pos_y = 0.0f,
+        .vel_x = SPEED,
+        .vel_y = 0.0f,
+        .gravity = GRAVITY,
+        .sprite = SPRITE_BIRD,
+        .size_x = BIRD_WIDTH,
+        .size_y = BIRD_HEIGHT,
+        .spin = BIRD_SPIN,
+        .layer = BIRD_LAYER,
+    };
+    long index = entity_spawn(&world->entities, &bird);
+    assert(index == WORLD_BIRD);
+
+    world_spawn_pipes(world);
+}
+
+// Save or restore a whole world: the scalar state plus the live entities.
+void
+world_copy(struct world* dst, const struct world* src)
+{
+    assert(dst != NULL);
+    assert(src != NULL);
+
+    memcpy(dst, src, offsetof(struct world, entities));
+    entity_copy(&dst->entities, &src->entities);
+}
+
+void
+world_update(struct world* world, bool flap, float delta)
+{
+    assert(world != NULL);
+
+    struct entity_store* entities = &world->entities;
+
+    // a flap after death starts a fresh run
+    if (flap) {
+        if (world->dead) world_reset(world);
+
+        world->running = true;
+    }
+
+    // nothing moves until the first flap
+    if (!world->running) return;
+
+    // run length (up to the moment of death)
+    if (!world->dead) {
+        world->ticks++;
+        world->time += delta;
+    }
+
+    entity_accelerate(entities, delta);
+
+    // a flap sets the bird's velocity outright: no gravity on that tick
+    if (flap) entities->vel_y[WORLD_BIRD] = FLAP;
+
+    entity_move(entities, delta);
+    world->camera += entities->vel_x[WORLD_BIRD] * delta;
+
+    world_spawn_pipes(world);
+    entity_cull(entities, world->camera - CULL_BEHIND);
+
+    // check collision
+    float bird_x = entities->pos_x[WORLD_BIRD];
+    float bird_y = entities->pos_y[WORLD_BIRD];
+
+    int death = WORLD_DEATH_NONE;
+    if (entity_collide(entities, bird_x, bird_y, BIRD_RADIUS) > 0) {
+        death = WORLD_DEATH_PIPE;
+    }
+    if (bird_x >= WALL_START_X && bird_y > 4.5f) {
+        death = WORLD_DEATH_CEILING;
+    }
+    if (bird_x >= WALL_START_X && bird_y < -4.5f) {
+        death = WORLD_DEATH_FLOOR;
+    }
+
+    if (death != WORLD_DEATH_NONE && !world->dead) {
+        world->dead = true;
+        world->death = death;
+        entities->vel_x[WORLD_BIRD] = 0.0f;
+        entities->vel_y[WORLD_BIRD] = 8.0f;
+    }
+
+    // score every obstacle the bird has cleared
+    struct course_record obstacle;
+    while (world_obstacle(world, world->score, &obstacle) && bird_x >= obstacle.x + PIPE_WIDTH) {
+        world->score++;
+    }
+}
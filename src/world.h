@@ -0,0 +1,52 @@
+#ifndef FLAPPY_WORLD_H_INCLUDED
+#define FLAPPY_WORLD_H_INCLUDED
+
+#include <stdbool.h>
+
+#include "course.h"
+#include "entity.h"
+
+// Simulation state of a single run, free of any window or GL handles. The
+// bird is always entity zero: it is spawned first and entity_cull compacts
+// stably, so it never moves within the store.
+//
+// Obstacles come from a course file when one is given. Otherwise they are
+// generated from the seed (a new one for every run), evenly spaced.
+
+enum {
+    WORLD_BIRD = 0,
+};
+
+enum world_death {
+    WORLD_DEATH_NONE = 0,
+    WORLD_DEATH_PIPE,
+    WORLD_DEATH_CEILING,
+    WORLD_DEATH_FLOOR,
+};
+
+struct world {
+    // game state
+    bool running;
+    bool dead;
+    int death;
+    long score;
+    long ticks;
+    double time;
+
+    // obstacle source
+    struct course* course;
+    unsigned int seed;
+    long next_pipe;
+
+    // game objects (keep the entity store last, see world_copy)
+    float camera;
+    struct entity_store entities;
+};
+
+void world_init(struct world* world, struct course* course, unsigned int seed);
+void world_reset(struct world* world);
+void world_copy(struct world* dst, const struct world* src);
+bool world_obstacle(const struct world* world, long i, struct course_record* obstacle);
+void world_update(struct world* world, bool flap, float delta);
+
+#endif